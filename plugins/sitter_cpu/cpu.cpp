@@ -174,10 +174,16 @@ void cpu::on_process_watch(as2js::json::json_value_ref & json)
                     {
                         // processors are overloaded on this machine
                         //
+                        // the I/O list is only saved in the JSON data;
+                        // it is often incomplete (see top_processes)
+                        //
+                        std::string message("High CPU usage.");
+                        message += server->output_top_processes(e, resource_t::RESOURCE_CPU);
+                        server->output_top_processes(e, resource_t::RESOURCE_IO);
                         server->append_error(
                               json
                             , "cpu"
-                            , "High CPU usage."
+                            , message
                             , 100);
                         add_warning = false;
                     }
@@ -199,6 +205,8 @@ void cpu::on_process_watch(as2js::json::json_value_ref & json)
             if(add_warning)
             {
                 e["warning"] = "High CPU usage";
+                server->output_top_processes(e, resource_t::RESOURCE_CPU);
+                server->output_top_processes(e, resource_t::RESOURCE_IO);
             }
         }
         else
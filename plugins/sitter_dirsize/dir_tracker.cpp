@@ -0,0 +1,525 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "dir_tracker.h"
+
+
+// sitter
+//
+#include    <sitter/monotonic_clock.h>
+
+
+// C++
+//
+#include    <algorithm>
+
+
+// C
+//
+#include    <dirent.h>
+#include    <sys/stat.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the directory size tracker.
+ *
+ * The tracker walks a set of directory trees, a little at a time, and
+ * computes the size of each directory (the files found directly in that
+ * directory) and its total (including all of its sub-directories).
+ *
+ * Each tick the walk is allowed to check a limited number of files and
+ * directories (the budget). A complete walk of the trees (a pass) may
+ * therefore span many ticks. The sizes are only published at the end
+ * of a pass so the totals are always coherent.
+ *
+ * The list of files and sub-directories of each directory is cached
+ * along its modification time and its own size (the size of its files).
+ * When the modification time did not change, the directory is not read
+ * again and its cached size is reused. Its sub-directories still get
+ * visited since a change deeper in the tree does not change the
+ * modification time of the parents.
+ *
+ * A file growing in place (i.e. a log file) does not change the
+ * modification time of its directory either. To catch those, every
+ * FULL_PASS_INTERVAL passes, the files of all the directories are
+ * checked with lstat() again.
+ *
+ * The budget is checked after each file so a directory with many files
+ * gets checked over several ticks.
+ *
+ * Like `du -x`, the walk does not cross file systems and does not
+ * follow symbolic links. Files with multiple hard links are counted
+ * once per link.
+ */
+
+
+
+namespace sitter
+{
+namespace dirsize
+{
+
+
+
+
+/** \brief Define the directories to track.
+ *
+ * If the list of roots changes, the cache is cleared and a new pass
+ * starts on the next tick.
+ *
+ * A root found inside another root is ignored since it would be counted
+ * twice.
+ *
+ * \param[in] roots  The list of directories to track.
+ */
+void dir_tracker::set_roots(std::vector<std::string> const & roots)
+{
+    std::vector<std::string> clean;
+    for(auto r : roots)
+    {
+        while(r.length() > 1
+           && r.back() == '/')
+        {
+            r.pop_back();
+        }
+        if(r.empty()
+        || r[0] != '/')
+        {
+            continue;
+        }
+        clean.push_back(r);
+    }
+    std::sort(clean.begin(), clean.end());
+    clean.erase(std::unique(clean.begin(), clean.end()), clean.end());
+
+    std::vector<std::string> result;
+    for(auto const & r : clean)
+    {
+        if(std::none_of(
+                  result.begin()
+                , result.end()
+                , [&r](std::string const & parent)
+                {
+                    return parent == "/"
+                        || (r.length() > parent.length()
+                            && r.compare(0, parent.length(), parent) == 0
+                            && r[parent.length()] == '/');
+                }))
+        {
+            result.push_back(r);
+        }
+    }
+
+    if(result == f_roots)
+    {
+        return;
+    }
+
+    f_roots = result;
+    f_directories.clear();
+    f_queue.clear();
+    f_completed_passes = 0;
+    f_pass_end = 0.0;
+    f_pass_interval = 0.0;
+}
+
+
+/** \brief Get the directories being tracked.
+ *
+ * \return The list of root directories.
+ */
+std::vector<std::string> const & dir_tracker::get_roots() const
+{
+    return f_roots;
+}
+
+
+/** \brief Walk the trees for a while.
+ *
+ * This function checks up to \p budget files and directories. If the
+ * current pass is complete, a new pass starts.
+ *
+ * \param[in] budget  The maximum number of files and directories to check.
+ *
+ * \return true if a pass was completed.
+ */
+bool dir_tracker::tick(std::size_t budget)
+{
+    if(f_roots.empty())
+    {
+        return false;
+    }
+
+    if(f_queue.empty())
+    {
+        ++f_pass;
+        for(auto const & r : f_roots)
+        {
+            struct stat st = {};
+            if(lstat(r.c_str(), &st) != 0
+            || !S_ISDIR(st.st_mode))
+            {
+                continue;
+            }
+            pending_t p;
+            p.f_path = r;
+            p.f_dev = st.st_dev;
+            p.f_root = true;
+            f_queue.push_back(p);
+        }
+        if(f_queue.empty())
+        {
+            return false;
+        }
+    }
+
+    std::size_t spent(0);
+    while(spent < budget
+       && !f_queue.empty())
+    {
+        // visit() only adds at the back so this reference remains valid
+        //
+        if(!visit(f_queue.front(), spent, budget))
+        {
+            break;
+        }
+        f_queue.pop_front();
+    }
+
+    if(!f_queue.empty())
+    {
+        return false;
+    }
+
+    end_pass();
+    return true;
+}
+
+
+/** \brief Check whether at least one pass was completed.
+ *
+ * \return true if the sizes are available.
+ */
+bool dir_tracker::has_results() const
+{
+    return f_completed_passes > 0;
+}
+
+
+/** \brief Get the total size of a directory.
+ *
+ * \param[in] path  The path to the directory.
+ *
+ * \return The total size in bytes as of the last completed pass.
+ */
+std::uint64_t dir_tracker::get_total(std::string const & path) const
+{
+    auto const it(f_directories.find(path));
+    if(it == f_directories.end())
+    {
+        return 0;
+    }
+    return it->second.f_previous_total;
+}
+
+
+/** \brief Get the growth of a directory total size.
+ *
+ * \param[in] path  The path to the directory.
+ *
+ * \return The growth in bytes between the last two completed passes.
+ */
+std::int64_t dir_tracker::get_total_growth(std::string const & path) const
+{
+    auto const it(f_directories.find(path));
+    if(it == f_directories.end())
+    {
+        return 0;
+    }
+    return it->second.f_total_growth;
+}
+
+
+/** \brief Get the time between the last two completed passes.
+ *
+ * \return The number of seconds, 0.0 if less than two passes completed.
+ */
+double dir_tracker::get_pass_interval() const
+{
+    return f_pass_interval;
+}
+
+
+/** \brief Get the directories which grew the most.
+ *
+ * The growth is computed on the files found directly in a directory so
+ * the growth is attributed to the directory where it happens and not to
+ * all of its parents.
+ *
+ * \param[in] n  The maximum number of directories to return.
+ *
+ * \return The directories with the largest growth, largest first.
+ */
+grower_vector_t dir_tracker::get_top_growers(std::size_t n) const
+{
+    grower_vector_t result;
+    for(auto const & d : f_directories)
+    {
+        if(d.second.f_growth > 0)
+        {
+            grower_t g;
+            g.f_path = d.first;
+            g.f_size = d.second.f_previous_own_size;
+            g.f_growth = d.second.f_growth;
+            result.push_back(g);
+        }
+    }
+
+    std::size_t const count(std::min(n, result.size()));
+    std::partial_sort(
+              result.begin()
+            , result.begin() + count
+            , result.end()
+            , [](grower_t const & a, grower_t const & b)
+            {
+                return a.f_growth > b.f_growth;
+            });
+    result.resize(count);
+
+    return result;
+}
+
+
+/** \brief Check one directory.
+ *
+ * If the modification time of the directory changed, its list of files
+ * and sub-directories is read again and the size of each file is
+ * retrieved. Otherwise the size found on the previous pass is reused,
+ * except on a full pass. In both cases, the sub-directories are added
+ * to the queue.
+ *
+ * If the budget runs out while checking the files, the function returns
+ * false and the next call continues with the next file.
+ *
+ * \param[in,out] p  The directory to check.
+ * \param[in,out] spent  The number of files and directories checked so far.
+ * \param[in] budget  The maximum number of files and directories to check.
+ *
+ * \return true if the directory was completely checked.
+ */
+bool dir_tracker::visit(
+      pending_t & p
+    , std::size_t & spent
+    , std::size_t budget)
+{
+    std::string const prefix(p.f_path == "/" ? std::string() : p.f_path);
+
+    if(!p.f_listed)
+    {
+        ++spent;
+
+        struct stat st = {};
+        if(lstat(p.f_path.c_str(), &st) != 0
+        || !S_ISDIR(st.st_mode)
+        || st.st_dev != p.f_dev)
+        {
+            return true;
+        }
+
+        directory_t & d(f_directories[p.f_path]);
+        d.f_pass = f_pass;
+
+        bool const changed(d.f_mtime_sec != st.st_mtim.tv_sec
+                        || d.f_mtime_nsec != st.st_mtim.tv_nsec);
+        if(changed)
+        {
+            d.f_files.clear();
+            d.f_subdirs.clear();
+
+            DIR * dir(opendir(p.f_path.c_str()));
+            if(dir == nullptr)
+            {
+                d.f_own_size = 0;
+                return true;
+            }
+            for(dirent const * ent(readdir(dir)); ent != nullptr; ent = readdir(dir))
+            {
+                std::string const name(ent->d_name);
+                if(name == "."
+                || name == "..")
+                {
+                    continue;
+                }
+                unsigned char type(ent->d_type);
+                if(type == DT_UNKNOWN)
+                {
+                    struct stat s = {};
+                    ++spent;
+                    if(lstat((prefix + '/' + name).c_str(), &s) != 0)
+                    {
+                        continue;
+                    }
+                    type = S_ISDIR(s.st_mode) ? DT_DIR : DT_REG;
+                }
+                if(type == DT_DIR)
+                {
+                    d.f_subdirs.push_back(name);
+                }
+                else
+                {
+                    d.f_files.push_back(name);
+                }
+            }
+            closedir(dir);
+
+            d.f_mtime_sec = st.st_mtim.tv_sec;
+            d.f_mtime_nsec = st.st_mtim.tv_nsec;
+        }
+
+        for(auto const & name : d.f_subdirs)
+        {
+            pending_t sub;
+            sub.f_path = prefix + '/' + name;
+            sub.f_dev = p.f_dev;
+            f_queue.push_back(sub);
+        }
+
+        if(!changed
+        && f_pass % FULL_PASS_INTERVAL != 0)
+        {
+            // keep d.f_own_size from the previous pass
+            //
+            return true;
+        }
+
+        // like du(1), count the blocks allocated to this directory and
+        // its files
+        //
+        p.f_listed = true;
+        p.f_next_file = 0;
+        p.f_size = static_cast<std::uint64_t>(st.st_blocks) * 512;
+    }
+
+    directory_t & d(f_directories[p.f_path]);
+    for(; p.f_next_file < d.f_files.size(); ++p.f_next_file)
+    {
+        if(spent >= budget)
+        {
+            return false;
+        }
+
+        struct stat s = {};
+        ++spent;
+        if(lstat((prefix + '/' + d.f_files[p.f_next_file]).c_str(), &s) == 0)
+        {
+            p.f_size += static_cast<std::uint64_t>(s.st_blocks) * 512;
+        }
+    }
+    d.f_own_size = p.f_size;
+
+    return true;
+}
+
+
+/** \brief Publish the results of a pass.
+ *
+ * This function removes the directories which were not found in this
+ * pass, computes the totals and the growth since the previous pass.
+ */
+void dir_tracker::end_pass()
+{
+    for(auto it(f_directories.begin()); it != f_directories.end(); )
+    {
+        if(it->second.f_pass != f_pass)
+        {
+            it = f_directories.erase(it);
+        }
+        else
+        {
+            it->second.f_total = it->second.f_own_size;
+            ++it;
+        }
+    }
+
+    // a child path is always larger than its parent path so going
+    // backward guarantees that the total of a directory is complete
+    // before we add it to its parent
+    //
+    for(auto it(f_directories.rbegin()); it != f_directories.rend(); ++it)
+    {
+        if(std::find(f_roots.begin(), f_roots.end(), it->first) != f_roots.end())
+        {
+            continue;
+        }
+        std::string::size_type const pos(it->first.rfind('/'));
+        if(pos == std::string::npos)
+        {
+            continue;
+        }
+        auto parent(f_directories.find(pos == 0 ? std::string("/") : it->first.substr(0, pos)));
+        if(parent != f_directories.end())
+        {
+            parent->second.f_total += it->second.f_total;
+        }
+    }
+
+    for(auto & d : f_directories)
+    {
+        directory_t & dir(d.second);
+        if(dir.f_has_previous)
+        {
+            dir.f_growth = static_cast<std::int64_t>(dir.f_own_size - dir.f_previous_own_size);
+            dir.f_total_growth = static_cast<std::int64_t>(dir.f_total - dir.f_previous_total);
+        }
+        else if(f_completed_passes > 0)
+        {
+            // a new directory, all of it is growth
+            //
+            dir.f_growth = static_cast<std::int64_t>(dir.f_own_size);
+            dir.f_total_growth = static_cast<std::int64_t>(dir.f_total);
+        }
+        dir.f_previous_own_size = dir.f_own_size;
+        dir.f_previous_total = dir.f_total;
+        dir.f_has_previous = true;
+    }
+
+    double const now(monotonic_seconds());
+    if(f_pass_end > 0.0)
+    {
+        f_pass_interval = now - f_pass_end;
+    }
+    f_pass_end = now;
+    ++f_completed_passes;
+}
+
+
+
+} // namespace dirsize
+} // namespace sitter
+// vim: ts=4 sw=4 et
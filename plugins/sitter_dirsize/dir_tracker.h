@@ -0,0 +1,116 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <cstdint>
+#include    <deque>
+#include    <map>
+#include    <string>
+#include    <vector>
+
+
+// C
+//
+#include    <sys/types.h>
+
+
+
+namespace sitter
+{
+namespace dirsize
+{
+
+
+
+struct grower_t
+{
+    std::string                 f_path = std::string();
+    std::uint64_t               f_size = 0;
+    std::int64_t                f_growth = 0;
+};
+typedef std::vector<grower_t>   grower_vector_t;
+
+
+class dir_tracker
+{
+public:
+    static constexpr std::size_t const  DEFAULT_BUDGET = 10'000;
+    static constexpr std::size_t const  FULL_PASS_INTERVAL = 10;
+
+    void                        set_roots(std::vector<std::string> const & roots);
+    std::vector<std::string> const &
+                                get_roots() const;
+    bool                        tick(std::size_t budget = DEFAULT_BUDGET);
+    bool                        has_results() const;
+    std::uint64_t               get_total(std::string const & path) const;
+    std::int64_t                get_total_growth(std::string const & path) const;
+    double                      get_pass_interval() const;
+    grower_vector_t             get_top_growers(std::size_t n) const;
+
+private:
+    struct directory_t
+    {
+        std::int64_t            f_mtime_sec = -1;
+        std::int64_t            f_mtime_nsec = -1;
+        std::vector<std::string>
+                                f_files = std::vector<std::string>();
+        std::vector<std::string>
+                                f_subdirs = std::vector<std::string>();
+        std::uint32_t           f_pass = 0;
+        std::uint64_t           f_own_size = 0;
+        std::uint64_t           f_total = 0;
+        bool                    f_has_previous = false;
+        std::uint64_t           f_previous_own_size = 0;
+        std::uint64_t           f_previous_total = 0;
+        std::int64_t            f_growth = 0;
+        std::int64_t            f_total_growth = 0;
+    };
+    typedef std::map<std::string, directory_t>  directory_map_t;
+
+    struct pending_t
+    {
+        std::string             f_path = std::string();
+        dev_t                   f_dev = 0;
+        bool                    f_root = false;
+        bool                    f_listed = false;
+        std::size_t             f_next_file = 0;
+        std::uint64_t           f_size = 0;
+    };
+
+    bool                        visit(
+                                      pending_t & p
+                                    , std::size_t & spent
+                                    , std::size_t budget);
+    void                        end_pass();
+
+    std::vector<std::string>    f_roots = std::vector<std::string>();
+    directory_map_t             f_directories = directory_map_t();
+    std::deque<pending_t>       f_queue = std::deque<pending_t>();
+    std::uint32_t               f_pass = 0;
+    std::uint32_t               f_completed_passes = 0;
+    double                      f_pass_end = 0.0;
+    double                      f_pass_interval = 0.0;
+};
+
+
+
+} // namespace dirsize
+} // namespace sitter
+// vim: ts=4 sw=4 et
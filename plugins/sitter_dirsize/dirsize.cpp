@@ -0,0 +1,267 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "dirsize.h"
+
+#include    "names.h"
+
+
+// advgetopt
+//
+#include    <advgetopt/utils.h>
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// snapdev
+//
+#include    <snapdev/gethostname.h>
+
+
+// serverplugins
+//
+#include    <serverplugins/collection.h>
+
+
+// C++
+//
+#include    <cmath>
+#include    <iomanip>
+#include    <iterator>
+#include    <sstream>
+
+
+// C
+//
+#include    <sys/statvfs.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+/** \file
+ * \brief Track the size of a few directory trees.
+ *
+ * When a partition fills up, the first question is: which directory
+ * grew? This plugin tracks the size of the directories defined in the
+ * dirsize_paths parameter (/var/log and /var/lib by default, plus the
+ * sitter data_path). The walk is incremental and limited to
+ * dirsize_budget files per tick (see dir_tracker).
+ *
+ * The directories which grew the most between the last two complete
+ * walks are saved in the JSON data. When the partition holding one
+ * of those directories is used at 90% or more (the threshold used by
+ * the disk plugin), an error listing the top growers is generated.
+ */
+
+
+
+namespace sitter
+{
+namespace dirsize
+{
+
+SERVERPLUGINS_START(dirsize)
+    , ::serverplugins::description(
+            "Track the size of directories to find which ones grow.")
+    , ::serverplugins::dependency("server")
+    , ::serverplugins::help_uri("https://snapwebsites.org/help")
+    , ::serverplugins::categorization_tag("disk")
+SERVERPLUGINS_END(dirsize)
+
+
+
+
+namespace
+{
+
+
+
+std::string format_size(std::int64_t size)
+{
+    char const * units[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+    double value(static_cast<double>(size));
+    std::size_t idx(0);
+    while(std::abs(value) >= 1024.0
+       && idx + 1 < std::size(units))
+    {
+        value /= 1024.0;
+        ++idx;
+    }
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(idx == 0 ? 0 : 1) << value << ' ' << units[idx];
+    return ss.str();
+}
+
+
+
+} // no name namespace
+
+
+
+
+/** \brief Initialize dirsize.
+ *
+ * This function terminates the initialization of the dirsize plugin
+ * by registering for different events.
+ */
+void dirsize::bootstrap()
+{
+    SERVERPLUGINS_LISTEN(dirsize, server, process_watch, std::placeholders::_1);
+}
+
+
+/** \brief Process this sitter data.
+ *
+ * This function walks the directory trees for a while and, once a walk
+ * is complete, saves the size of each tree and the directories which
+ * grew the most.
+ *
+ * \param[in] json  The document where the results are collected.
+ */
+void dirsize::on_process_watch(as2js::json::json_value_ref & json)
+{
+    SNAP_LOG_DEBUG
+        << "dirsize::on_process_watch(): processing"
+        << SNAP_LOG_SEND;
+
+    sitter::server::pointer_t server(plugins()->get_server<sitter::server>());
+
+    advgetopt::string_list_t roots;
+    advgetopt::split_string(server->get_server_parameter(g_name_dirsize_paths), roots, { ":" });
+    std::string const data_path(server->get_server_parameter("data_path"));
+    if(!data_path.empty())
+    {
+        roots.push_back(data_path);
+    }
+    f_tracker.set_roots(roots);
+
+    f_tracker.tick(server->get_integer_parameter(g_name_dirsize_budget, dir_tracker::DEFAULT_BUDGET));
+    if(!f_tracker.has_results())
+    {
+        // the first walk is not yet complete
+        //
+        return;
+    }
+
+    as2js::json::json_value_ref e(json["dirsize"]);
+
+    for(auto const & r : f_tracker.get_roots())
+    {
+        as2js::json::json_value_ref d(e["directory"][-1]);
+        d["path"] = r;
+        d["size"] = f_tracker.get_total(r);
+        d["growth"] = f_tracker.get_total_growth(r);
+    }
+    e["interval"] = f_tracker.get_pass_interval();
+
+    grower_vector_t const growers(f_tracker.get_top_growers(server->get_integer_parameter(g_name_dirsize_top, DEFAULT_TOP)));
+    for(auto const & g : growers)
+    {
+        as2js::json::json_value_ref d(e["grower"][-1]);
+        d["path"] = g.f_path;
+        d["size"] = g.f_size;
+        d["growth"] = g.f_growth;
+    }
+
+    check_partitions(e, growers);
+}
+
+
+/** \brief Report the top growers of partitions which are getting full.
+ *
+ * The disk plugin reports partitions used at 90% or more. This function
+ * generates an error listing the directories which grew the most on
+ * those partitions so the administrator knows where to look.
+ *
+ * \param[in] e  The "dirsize" object.
+ * \param[in] growers  The list of top growers.
+ */
+void dirsize::check_partitions(
+      as2js::json::json_value_ref & e
+    , grower_vector_t const & growers)
+{
+    // a root may be on a network mount where statvfs() can block; the
+    // disk plugin already reports mounts which do not answer
+    //
+    statvfs_result_vector_t const results(plugins()->get_server<sitter::server>()->get_statvfs_pool().probe(f_tracker.get_roots()));
+    for(auto const & p : results)
+    {
+        std::string const & r(p.f_dir);
+        struct statvfs const & s(p.f_stat);
+        if(p.f_status != probe_status_t::PROBE_STATUS_SUCCESS
+        || s.f_blocks == 0)
+        {
+            continue;
+        }
+        double const usage(1.0 - static_cast<double>(s.f_bavail) / static_cast<double>(s.f_blocks));
+        if(usage < 0.9)
+        {
+            continue;
+        }
+
+        std::string list;
+        for(auto const & g : growers)
+        {
+            if(r == "/"
+            || g.f_path == r
+            || g.f_path.compare(0, r.length() + 1, r + '/') == 0)
+            {
+                if(!list.empty())
+                {
+                    list += ", ";
+                }
+                list += g.f_path;
+                list += " (+";
+                list += format_size(g.f_growth);
+                list += ')';
+            }
+        }
+        if(list.empty())
+        {
+            continue;
+        }
+
+        plugins()->get_server<sitter::server>()->append_error(
+              e
+            , "dirsize"
+            , "the partition holding \""
+                + r
+                + "\" on \""
+                + snapdev::gethostname()
+                + "\" is close to full; directories with the largest growth: "
+                + list
+                + "."
+            , usage >= 0.95 ? 80 : 55);
+    }
+}
+
+
+
+} // namespace dirsize
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,70 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    "dir_tracker.h"
+
+
+// sitter
+//
+#include    <sitter/sitter.h>
+
+
+// serverplugins
+//
+#include    <serverplugins/plugin.h>
+
+
+
+namespace sitter
+{
+namespace dirsize
+{
+
+
+
+SERVERPLUGINS_VERSION(dirsize, 1, 0)
+
+
+class dirsize
+    : public serverplugins::plugin
+{
+public:
+    static constexpr std::size_t const  DEFAULT_TOP = 5;
+
+    SERVERPLUGINS_DEFAULTS(dirsize);
+
+    // serverplugins::plugin implementation
+    virtual void        bootstrap() override;
+
+    // server signal
+    void                on_process_watch(as2js::json::json_value_ref & json);
+
+private:
+    void                check_partitions(as2js::json::json_value_ref & e, grower_vector_t const & growers);
+
+    dir_tracker         f_tracker = dir_tracker();
+};
+
+
+
+} // namespace dirsize
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -32,9 +32,8 @@
 // snapdev
 //
 #include    <snapdev/gethostname.h>
-#include    <snapdev/mounts.h>
+#include    <snapdev/join_strings.h>
 #include    <snapdev/not_reached.h>
-#include    <snapdev/not_used.h>
 
 
 // serverplugins
@@ -44,12 +43,17 @@
 
 // C++
 //
+#include    <algorithm>
+#include    <cmath>
+#include    <iomanip>
+#include    <map>
 #include    <regex>
+#include    <sstream>
 
 
 // C
 //
-#include    <signal.h>
+#include    <sys/stat.h>
 #include    <sys/statvfs.h>
 
 
@@ -80,126 +84,93 @@ namespace
 {
 
 
-std::vector<std::string> const g_ignore_filled_partitions =
+// these patterns are compiled once
+//
+std::vector<std::regex> const g_ignore_filled_partitions =
 {
-    "^/snap/core/"
+    std::regex("^/snap/core/")
 };
 
 
+constexpr std::int64_t const    DEFAULT_AWAIT_THRESHOLD = 250;  // ms
+constexpr std::int64_t const    DEFAULT_UTIL_THRESHOLD = 90;    // percent
 
-/** \brief The alarm handler we use to create a statvfs_try() function.
- *
- * This function is a hanlder we use to sound the alarm and prevent
- * the statvfs() from holding us up forever.
- */
-void statvfs_alarm_handler(int sig)
+
+std::string format_double(double value)
 {
-    snapdev::NOT_USED(sig);
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1) << value;
+    return ss.str();
 }
 
 
-/** \brief A statvfs() that times out in case a drive locks us up.
- *
- * On Feb 10, 2018, I was testing the sitter daemon and it was getting
- * stuck on statvfs(). I have keybase installed on my system and
- * it failed restarting properly. Once restarted, everything worked
- * as expected.
- *
- * The `df` command would also lock up.
- *
- * The statvfs() is therefore the culprit. This function is used
- * in order to time out if the function doesn't return in a speedy
- * enough period.
- *
- * \note
- * If the function times out, it returns -1 and sets the errno
- * to EINTR. In other cases, a different errno is set.
- *
- * \param[in] path  The name of the file to stat.
- * \param[in] s  The structure were the results are saved on success.
- * \param[in] seconds  The number of seconds to wait before we time out.
- *
- * \return 0 on success, -1 on error and errno set appropriately.
- */
-int statvfs_try(char const * path, struct statvfs * s, unsigned int seconds)
-{
-    struct sigaction alarm_action = {};
-    struct sigaction saved_action = {};
+// a partition which does not get filled within that amount of time
+// is considered stable
+//
+constexpr double const          FORECAST_STABLE = 30.0 * 24.0 * 60.0 * 60.0;
 
-    // note that the flags do not include SA_RESTART, so
-    // statvfs() should be interrupted on the SIGALRM signal
-    // and not restarted
-    //
-    alarm_action.sa_flags = 0;
-    sigemptyset(&alarm_action.sa_mask);
-    alarm_action.sa_handler = statvfs_alarm_handler;
 
-    // first we setup the alarm handler as setting the alarm before
-    // would mean that we don't get our handler called
-    //
-    if(sigaction(SIGALRM, &alarm_action, &saved_action) != 0)
+int get_forecast_priority(double time_to_full, double usage)
+{
+    if(time_to_full < 0.0
+    || std::isinf(time_to_full))
     {
-        return -1;
+        return 0;
     }
 
-    // alarm() does not return an errors
-    //
-    unsigned int old_alarm(alarm(seconds));
-    time_t const start_time(time(nullptr));
-
-    // clear errno
+    // partitions which are not yet 90% full have their usage going up
+    // and down; only report them if they get filled quickly
     //
-    errno = 0;
-
-    // do the statvfs() now
-    //
-    int const rc(statvfs(path, s));
-
-    // save the errno value as alarm() and sigaction() might change it
-    //
-    int const saved_errno(errno);
-
-    // make sure our or someone else handler does not get called
-    // (this is if the alarm did not happen)
-    //
-    alarm(0);
+    if(usage < 0.9
+    && time_to_full >= 24.0 * 60.0 * 60.0)
+    {
+        return 0;
+    }
 
-    // reset the signal handler
-    //
-    // we have to ignore the error in this case because there is
-    // pretty much nothing we can do about it (throw?!)
-    //
-    snapdev::NOT_USED(sigaction(SIGALRM, &saved_action, nullptr));
+    int priority(0);
+    if(time_to_full < 60.0 * 60.0)
+    {
+        priority = 100;
+    }
+    else if(time_to_full < 6.0 * 60.0 * 60.0)
+    {
+        priority = 90;
+    }
+    else if(time_to_full < 24.0 * 60.0 * 60.0)
+    {
+        priority = 80;
+    }
+    else if(time_to_full < 7.0 * 24.0 * 60.0 * 60.0)
+    {
+        priority = 60;
+    }
 
-    // reset the alarm if required (if 0, avoid the system call)
+    // a forecast is only an extrapolation; a partition with plenty of
+    // space left cannot be as urgent as one which is nearly full
     //
-    if(old_alarm != 0)
+    if(usage < 0.8)
     {
-        // adjust the number of seconds with the number of seconds
-        // that elapsed since we started our own alarm
-        //
-        time_t const elapsed(time(nullptr) - start_time);
-        if(static_cast<unsigned int>(elapsed) >= old_alarm)
-        {
-            // we use this condition in part because the old_alarm
-            // variable is an 'unsigned int'
-            //
-            old_alarm = 1;
-        }
-        else
-        {
-            old_alarm -= elapsed;
-        }
-        alarm(old_alarm);
+        return std::min(priority, 50);
     }
+    if(usage < 0.9)
+    {
+        return std::min(priority, 80);
+    }
+    return priority;
+}
 
-    // restore the errno that statvfs() generated
-    //
-    errno = saved_errno;
 
-    // the statvfs() return code
-    //
-    return rc;
+std::string format_duration(double seconds)
+{
+    if(seconds < 2.0 * 60.0 * 60.0)
+    {
+        return std::to_string(static_cast<std::int64_t>(seconds / 60.0)) + " minutes";
+    }
+    if(seconds < 2.0 * 24.0 * 60.0 * 60.0)
+    {
+        return std::to_string(static_cast<std::int64_t>(seconds / (60.0 * 60.0))) + " hours";
+    }
+    return std::to_string(static_cast<std::int64_t>(seconds / (24.0 * 60.0 * 60.0))) + " days";
 }
 
 
@@ -235,20 +206,74 @@ void disk::on_process_watch(as2js::json::json_value_ref & json)
 
     as2js::json::json_value_ref e(json["disk"]);
 
-    // read the various mounts on this server
+    // the mount table is kept in memory and only reloaded when the
+    // kernel signals a change
     //
     // TBD: instead of all mounts, we may want to look into definitions
     //      in our configuration file?
-    snapdev::mounts m("/proc/mounts");
+    if(f_mount_table == nullptr)
+    {
+        f_mount_table = std::make_shared<mount_table>(plugins()->get_server<sitter::server>().get());
+    }
+    mounts_pointer_t const m(f_mount_table->get_mounts());
+
+    // a file system remounted read-only is generally the result of I/O
+    // errors so we want to report that as soon as possible
+    //
+    advgetopt::string_list_t const read_only(f_mount_table->get_remounted_read_only());
+    for(auto const & dir : read_only)
+    {
+        as2js::json::json_value_ref p(e["partition"][-1]);
+        p["dir"] = dir;
+        p["error"] = "remounted read-only";
+
+        plugins()->get_server<sitter::server>()->append_error(
+              e
+            , "disk"
+            , "partition \""
+                + dir
+                + "\" on \""
+                + snapdev::gethostname()
+                + "\" was remounted read-only."
+            , 90);
+    }
+
+    // probe all the mounts concurrently, each with its own timeout
+    //
+    std::vector<std::string> dirs;
+    dirs.reserve(m->size());
+    for(auto const & entry : *m)
+    {
+        dirs.push_back(entry.get_dir());
+    }
+    statvfs_result_vector_t const results(plugins()->get_server<sitter::server>()->get_statvfs_pool().probe(dirs));
 
     // check each disk
-    size_t const max_mounts(m.size());
-    for(size_t idx(0); idx < max_mounts; ++idx)
+    for(auto const & r : results)
     {
-        struct statvfs s;
-        memset(&s, 0, sizeof(s));
-        if(statvfs_try(m[idx].get_dir().c_str(), &s, 3) == 0)
+        if(r.f_status == probe_status_t::PROBE_STATUS_TIMED_OUT
+        || r.f_status == probe_status_t::PROBE_STATUS_UNRESPONSIVE)
+        {
+            as2js::json::json_value_ref p(e["partition"][-1]);
+            p["dir"] = r.f_dir;
+            p["error"] = "unresponsive";
+
+            plugins()->get_server<sitter::server>()->append_error(
+                  e
+                , "disk"
+                , "partition \""
+                    + r.f_dir
+                    + "\" on \""
+                    + snapdev::gethostname()
+                    + "\" does not respond to statvfs()."
+                , 50);
+            continue;
+        }
+
+        if(r.f_status == probe_status_t::PROBE_STATUS_SUCCESS)
         {
+            struct statvfs const & s(r.f_stat);
+
             // got an entry, however, we ignore entries that have a number
             // of block equal to zero because those are virtual drives
             //
@@ -258,7 +283,7 @@ void disk::on_process_watch(as2js::json::json_value_ref & json)
 
                 // directory where this partition is attached
                 //
-                std::string dir(m[idx].get_dir());
+                std::string const & dir(r.f_dir);
                 p["dir"] = dir;
 
                 // we do not expect to get a server with blocks of 512 bytes
@@ -271,77 +296,313 @@ void disk::on_process_watch(as2js::json::json_value_ref & json)
                 p["favailable"] =   s.f_favail;
                 p["flags"] =        s.f_flag;
 
+                // estimate the time until the partition is full, for the
+                // blocks and the inodes
+                //
+                f_space_forecast.add_sample(dir, s.f_blocks, s.f_bavail, s.f_files, s.f_favail);
+                double const time_to_full(f_space_forecast.time_to_full(dir));
+                double const inode_time_to_full(f_space_forecast.inode_time_to_full(dir));
+                if(time_to_full >= 0.0
+                && !std::isinf(time_to_full))
+                {
+                    p["time_to_full"] = static_cast<std::int64_t>(time_to_full);
+                }
+                if(inode_time_to_full >= 0.0
+                && !std::isinf(inode_time_to_full))
+                {
+                    p["inode_time_to_full"] = static_cast<std::int64_t>(inode_time_to_full);
+                }
+
                 // is that partition full at 90% or more?
                 //
                 double const usage(1.0 - static_cast<double>(s.f_bavail) / static_cast<double>(s.f_blocks));
-                if(usage >= 0.9)
+                double const inode_usage(s.f_files == 0
+                            ? 0.0
+                            : 1.0 - static_cast<double>(s.f_favail) / static_cast<double>(s.f_files));
+                int const forecast_priority(get_forecast_priority(time_to_full, usage));
+                int const inode_forecast_priority(get_forecast_priority(inode_time_to_full, inode_usage));
+                if(usage >= 0.9
+                || forecast_priority > 0
+                || inode_forecast_priority > 0)
                 {
                     // if we find it in the list of partitions to
                     // ignore then we skip the full error generation
                     //
-                    auto it1(std::find_if(
+                    bool const ignore(std::any_of(
                               g_ignore_filled_partitions.begin()
                             , g_ignore_filled_partitions.end()
-                            , [dir](auto pattern)
+                            , [dir](std::regex const & pat)
                             {
-                                std::regex const pat(pattern);
                                 return std::regex_match(dir, pat, std::regex_constants::match_any);
                             }));
-                    bool const ignore(it1 != g_ignore_filled_partitions.end());
 
                     // we mark the partition as quite full even if the user
                     // marks it as "ignore that one"
                     //
-                    p["error"] = ignore
-                                    ? "partition used over 90% (ignore)"
-                                    : "partition used over 90%";
+                    std::string error(usage >= 0.9
+                                    ? "partition used over 90%"
+                                    : "partition filling up");
+                    if(ignore)
+                    {
+                        error += " (ignore)";
+                    }
+                    p["error"] = error;
 
-                    if(!ignore)
+                    // the user can also define a list of regex which
+                    // we test now to ignore further partitions
+                    //
+                    if(!ignore
+                    && !is_ignored(dir))
                     {
-                        // the user can also define a list of regex which
-                        // we test now to ignore further partitions
+                        // get the name of the host for the error message
+                        //
+                        std::string hostname(snapdev::gethostname());
+
+                        // priority increases as the disk gets filled up
+                        // more, however, if the partition is not getting
+                        // filled quickly, it is not urgent
                         //
-                        std::string const disk_ignore(plugins()->get_server<sitter::server>()->get_server_parameter(g_name_disk_ignore));
-                        advgetopt::string_list_t disk_ignore_patterns;
-                        advgetopt::split_string(disk_ignore, disk_ignore_patterns, { ":" });
-                        auto it2(std::find_if(
-                                  disk_ignore_patterns.begin()
-                                , disk_ignore_patterns.end()
-                                , [dir](auto pattern)
-                                {
-                                    std::regex const pat(pattern);
-                                    return std::regex_match(dir, pat, std::regex_constants::match_any);
-                                }));
-                        if(it2 == disk_ignore_patterns.end())
+                        int usage_priority(usage >= 0.999
+                                                ? 100
+                                                : (usage >= 0.95
+                                                    ? 80
+                                                    : (usage >= 0.9
+                                                        ? 55
+                                                        : 0)));
+                        if(usage < 0.999
+                        && (std::isinf(time_to_full)
+                            || time_to_full >= FORECAST_STABLE))
+                        {
+                            usage_priority = std::min(usage_priority, 40);
+                        }
+                        int const priority(std::max(usage_priority, forecast_priority));
+                        if(priority > 0)
+                        {
+                            std::string message("partition \""
+                                    + dir
+                                    + "\" on \""
+                                    + hostname
+                                    + "\" is "
+                                    + (usage >= 0.9 ? "close to full (" : "filling up (")
+                                    + format_double(usage * 100.0)
+                                    + "% used");
+                            if(time_to_full >= 0.0
+                            && !std::isinf(time_to_full))
+                            {
+                                message += ", full in about ";
+                                message += format_duration(time_to_full);
+                            }
+                            message += ')';
+                            plugins()->get_server<sitter::server>()->append_error(
+                                  e
+                                , "disk"
+                                , message
+                                , priority);
+                        }
+
+                        if(inode_forecast_priority > 0)
                         {
-                            // get the name of the host for the error message
-                            //
-                            std::string hostname(snapdev::gethostname());
-
-                            // priority increases as the disk gets filled up more
-                            //
-                            int const priority(usage >= 0.999
-                                                    ? 100
-                                                    : (usage >= 0.95
-                                                        ? 80
-                                                        : 55)); // [0.9, 0.95)
                             plugins()->get_server<sitter::server>()->append_error(
                                   e
                                 , "disk"
                                 , "partition \""
-                                    + m[idx].get_dir()
+                                    + dir
                                     + "\" on \""
                                     + hostname
-                                    + "\" is close to full ("
-                                    + std::to_string(usage * 100.0) // TODO: create a snapdev::to_string(double ...) with appropriate formatting
-                                    + "%)"
-                                , priority);
+                                    + "\" will run out of inodes in about "
+                                    + format_duration(inode_time_to_full)
+                                    + " ("
+                                    + std::to_string(s.f_favail)
+                                    + " left)"
+                                , inode_forecast_priority);
                         }
                     }
                 }
             }
         }
     }
+
+    check_devices(e, m);
+}
+
+
+
+/** \brief Check whether a partition is to be ignored.
+ *
+ * The administrator can define a list of regular expressions in the
+ * disk_ignore parameter. The list is compiled only when the parameter
+ * changes.
+ *
+ * \param[in] dir  The directory where the partition is mounted.
+ *
+ * \return true if the partition matches one of the disk_ignore patterns.
+ */
+bool disk::is_ignored(std::string const & dir)
+{
+    std::string const disk_ignore(plugins()->get_server<sitter::server>()->get_server_parameter(g_name_disk_ignore));
+    if(disk_ignore != f_disk_ignore)
+    {
+        f_disk_ignore = disk_ignore;
+        f_disk_ignore_patterns.clear();
+
+        advgetopt::string_list_t disk_ignore_patterns;
+        advgetopt::split_string(disk_ignore, disk_ignore_patterns, { ":" });
+        for(auto const & pattern : disk_ignore_patterns)
+        {
+            try
+            {
+                f_disk_ignore_patterns.emplace_back(pattern);
+            }
+            catch(std::regex_error const & ex)
+            {
+                SNAP_LOG_ERROR
+                    << "invalid disk_ignore pattern \""
+                    << pattern
+                    << "\": "
+                    << ex.what()
+                    << SNAP_LOG_SEND;
+            }
+        }
+    }
+
+    return std::any_of(
+              f_disk_ignore_patterns.begin()
+            , f_disk_ignore_patterns.end()
+            , [&dir](std::regex const & pat)
+            {
+                return std::regex_match(dir, pat, std::regex_constants::match_any);
+            });
+}
+
+
+
+/** \brief Check the I/O statistics of the devices backing the mounts.
+ *
+ * This function reads /proc/diskstats and outputs the interval metrics
+ * of each block device on which a partition is mounted. A device with
+ * a high latency or a high utilization generates an error.
+ *
+ * The thresholds are defined by the disk_await_threshold and the
+ * disk_util_threshold parameters.
+ *
+ * \param[in] e  The "disk" object where the results are saved.
+ * \param[in] m  The list of mounts.
+ */
+void disk::check_devices(
+      as2js::json::json_value_ref & e
+    , mounts_pointer_t m)
+{
+    f_diskstats.refresh();
+
+    // map the devices to their mount points; only local block devices
+    // (i.e. "/dev/...") have statistics so we do not need to stat()
+    // anything that could block
+    //
+    std::map<dev_t, advgetopt::string_list_t> device_mounts;
+    for(auto const & entry : *m)
+    {
+        std::string const & fsname(entry.get_fsname());
+        if(fsname.compare(0, 5, "/dev/") != 0)
+        {
+            continue;
+        }
+        struct stat st = {};
+        if(stat(fsname.c_str(), &st) != 0
+        || !S_ISBLK(st.st_mode))
+        {
+            continue;
+        }
+        device_mounts[st.st_rdev].push_back(entry.get_dir());
+    }
+    if(device_mounts.empty())
+    {
+        return;
+    }
+
+    sitter::server::pointer_t server(plugins()->get_server<sitter::server>());
+    std::int64_t const await_threshold(server->get_integer_parameter(g_name_disk_await_threshold, DEFAULT_AWAIT_THRESHOLD));
+    std::int64_t const util_threshold(server->get_integer_parameter(g_name_disk_util_threshold, DEFAULT_UTIL_THRESHOLD));
+
+    for(auto const & dm : device_mounts)
+    {
+        device_stats_t const * d(f_diskstats.find_device(dm.first));
+        if(d == nullptr
+        || !d->f_has_rates)
+        {
+            continue;
+        }
+
+        as2js::json::json_value_ref j(e["device"][-1]);
+        j["name"] = d->f_name;
+        j["mounts"] = snapdev::join_strings(dm.second, ",");
+        j["read_iops"] = d->f_read_iops;
+        j["write_iops"] = d->f_write_iops;
+        j["read_throughput"] = d->f_read_throughput;
+        j["write_throughput"] = d->f_write_throughput;
+        j["read_await"] = d->f_read_await;
+        j["write_await"] = d->f_write_await;
+        j["queue_depth"] = d->f_queue_depth;
+        j["util"] = d->f_util;
+
+        std::string const mounts(snapdev::join_strings(dm.second, "\", \""));
+
+        // both errors get reported, the "error" field keeps the one with
+        // the higher priority (the latency)
+        //
+        bool high_latency(false);
+        if(await_threshold > 0)
+        {
+            double const await(std::max(d->f_read_await, d->f_write_await));
+            if(await >= static_cast<double>(await_threshold))
+            {
+                high_latency = true;
+                j["error"] = "high latency";
+
+                server->append_error(
+                      e
+                    , "disk"
+                    , "device \""
+                        + d->f_name
+                        + "\" (\""
+                        + mounts
+                        + "\") on \""
+                        + snapdev::gethostname()
+                        + "\" has a high latency (read: "
+                        + format_double(d->f_read_await)
+                        + " ms, write: "
+                        + format_double(d->f_write_await)
+                        + " ms, queue depth: "
+                        + format_double(d->f_queue_depth)
+                        + ")."
+                    , 60);
+            }
+        }
+
+        if(util_threshold > 0
+        && d->f_util >= static_cast<double>(util_threshold))
+        {
+            if(!high_latency)
+            {
+                j["error"] = "saturated";
+            }
+
+            server->append_error(
+                  e
+                , "disk"
+                , "device \""
+                    + d->f_name
+                    + "\" (\""
+                    + mounts
+                    + "\") on \""
+                    + snapdev::gethostname()
+                    + "\" is busy "
+                    + format_double(d->f_util)
+                    + "% of the time ("
+                    + format_double(d->f_read_iops + d->f_write_iops)
+                    + " IOPS)."
+                , 55);
+        }
+    }
 }
 
 
@@ -17,6 +17,13 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
+// self
+//
+#include    "diskstats.h"
+#include    "mount_table.h"
+#include    "space_forecast.h"
+
+
 // sitter
 //
 #include    <sitter/sitter.h>
@@ -27,6 +34,11 @@
 #include    <serverplugins/plugin.h>
 
 
+// C++
+//
+#include    <regex>
+
+
 
 namespace sitter
 {
@@ -51,6 +63,18 @@ public:
     void                on_process_watch(as2js::json::json_value_ref & json);
 
 private:
+    bool                is_ignored(std::string const & dir);
+    void                check_devices(
+                              as2js::json::json_value_ref & e
+                            , mounts_pointer_t m);
+
+    diskstats           f_diskstats = diskstats();
+    space_forecast      f_space_forecast = space_forecast();
+    mount_table::pointer_t
+                        f_mount_table = mount_table::pointer_t();
+    std::string         f_disk_ignore = std::string();
+    std::vector<std::regex>
+                        f_disk_ignore_patterns = std::vector<std::regex>();
 };
 
 
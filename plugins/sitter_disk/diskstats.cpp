@@ -0,0 +1,212 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "diskstats.h"
+
+
+// sitter
+//
+#include    <sitter/monotonic_clock.h>
+
+
+// snapdev
+//
+#include    <snapdev/file_contents.h>
+
+
+// C++
+//
+#include    <algorithm>
+#include    <sstream>
+
+
+// C
+//
+#include    <sys/sysmacros.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the block device statistics.
+ *
+ * The kernel maintains counters for each block device in /proc/diskstats.
+ * The counters are totals since boot so we keep the previous sample and
+ * compute the interval values (IOPS, throughput, latency, queue depth,
+ * and utilization) between two ticks, the same way iostat(1) does.
+ *
+ * Sectors in /proc/diskstats are always 512 bytes, whatever the actual
+ * sector size of the device.
+ */
+
+
+
+namespace sitter
+{
+namespace disk
+{
+
+
+
+namespace
+{
+
+
+
+constexpr double const      SECTOR_SIZE = 512.0;
+
+
+double delta(std::uint64_t current, std::uint64_t previous)
+{
+    // the counters can wrap on 32 bit systems or get reset when a device
+    // is removed and re-added
+    //
+    if(current < previous)
+    {
+        return 0.0;
+    }
+    return static_cast<double>(current - previous);
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Read /proc/diskstats and compute the interval values.
+ *
+ * The first call only loads the counters. The following calls also
+ * compute the rates since the previous call.
+ */
+void diskstats::refresh()
+{
+    snapdev::file_contents stats("/proc/diskstats");
+    if(!stats.read_all())
+    {
+        return;
+    }
+
+    double const now(monotonic_seconds());
+    double const elapsed(f_previous_time > 0.0 ? now - f_previous_time : 0.0);
+    double const elapsed_ms(elapsed * 1000.0);
+
+    device_stats_map_t devices;
+    std::istringstream in(stats.contents());
+    std::string line;
+    while(std::getline(in, line))
+    {
+        device_stats_t d;
+        std::uint64_t reads_merged(0);
+        std::uint64_t writes_merged(0);
+        std::istringstream fields(line);
+        fields >> d.f_major
+               >> d.f_minor
+               >> d.f_name
+               >> d.f_reads
+               >> reads_merged
+               >> d.f_read_sectors
+               >> d.f_read_ms
+               >> d.f_writes
+               >> writes_merged
+               >> d.f_write_sectors
+               >> d.f_write_ms
+               >> d.f_in_flight
+               >> d.f_io_ms
+               >> d.f_weighted_io_ms;
+        if(fields.fail())
+        {
+            continue;
+        }
+
+        dev_t const dev(makedev(d.f_major, d.f_minor));
+        auto const previous(f_devices.find(dev));
+        if(previous != f_devices.end()
+        && previous->second.f_name == d.f_name
+        && elapsed > 0.0)
+        {
+            device_stats_t const & p(previous->second);
+
+            double const reads(delta(d.f_reads, p.f_reads));
+            double const writes(delta(d.f_writes, p.f_writes));
+
+            d.f_has_rates = true;
+            d.f_read_iops = reads / elapsed;
+            d.f_write_iops = writes / elapsed;
+            d.f_read_throughput = delta(d.f_read_sectors, p.f_read_sectors) * SECTOR_SIZE / elapsed;
+            d.f_write_throughput = delta(d.f_write_sectors, p.f_write_sectors) * SECTOR_SIZE / elapsed;
+            if(reads > 0.0)
+            {
+                d.f_read_await = delta(d.f_read_ms, p.f_read_ms) / reads;
+            }
+            if(writes > 0.0)
+            {
+                d.f_write_await = delta(d.f_write_ms, p.f_write_ms) / writes;
+            }
+            d.f_queue_depth = delta(d.f_weighted_io_ms, p.f_weighted_io_ms) / elapsed_ms;
+            d.f_util = std::min(delta(d.f_io_ms, p.f_io_ms) / elapsed_ms * 100.0, 100.0);
+        }
+
+        devices[dev] = d;
+    }
+
+    f_devices.swap(devices);
+    f_previous_time = now;
+}
+
+
+/** \brief Search for a device by number.
+ *
+ * \param[in] dev  The device number (as found in st_rdev or st_dev).
+ *
+ * \return A pointer to the device statistics or nullptr.
+ */
+device_stats_t const * diskstats::find_device(dev_t dev) const
+{
+    auto const it(f_devices.find(dev));
+    if(it == f_devices.end())
+    {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+
+/** \brief Get all the devices found in the last refresh().
+ *
+ * \return A reference to the map of devices.
+ */
+device_stats_map_t const & diskstats::get_devices() const
+{
+    return f_devices;
+}
+
+
+
+} // namespace disk
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,88 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <cstdint>
+#include    <map>
+#include    <string>
+
+
+// C
+//
+#include    <sys/types.h>
+
+
+
+namespace sitter
+{
+namespace disk
+{
+
+
+
+struct device_stats_t
+{
+    // raw counters as found in /proc/diskstats
+    //
+    std::string                 f_name = std::string();
+    unsigned int                f_major = 0;
+    unsigned int                f_minor = 0;
+    std::uint64_t               f_reads = 0;
+    std::uint64_t               f_read_sectors = 0;
+    std::uint64_t               f_read_ms = 0;
+    std::uint64_t               f_writes = 0;
+    std::uint64_t               f_write_sectors = 0;
+    std::uint64_t               f_write_ms = 0;
+    std::uint64_t               f_in_flight = 0;
+    std::uint64_t               f_io_ms = 0;
+    std::uint64_t               f_weighted_io_ms = 0;
+
+    // interval values, valid only when f_has_rates is true
+    //
+    bool                        f_has_rates = false;
+    double                      f_read_iops = 0.0;
+    double                      f_write_iops = 0.0;
+    double                      f_read_throughput = 0.0;    // bytes per second
+    double                      f_write_throughput = 0.0;   // bytes per second
+    double                      f_read_await = 0.0;         // ms per read
+    double                      f_write_await = 0.0;        // ms per write
+    double                      f_queue_depth = 0.0;
+    double                      f_util = 0.0;               // percent
+};
+typedef std::map<dev_t, device_stats_t>     device_stats_map_t;
+
+
+class diskstats
+{
+public:
+    void                        refresh();
+    device_stats_t const *      find_device(dev_t dev) const;
+    device_stats_map_t const &  get_devices() const;
+
+private:
+    device_stats_map_t          f_devices = device_stats_map_t();
+    double                      f_previous_time = 0.0;
+};
+
+
+
+} // namespace disk
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,379 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "mount_table.h"
+
+
+// sitter
+//
+#include    <sitter/sitter.h>
+
+
+// cppthread
+//
+#include    <cppthread/guard.h>
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// snapdev
+//
+#include    <snapdev/not_used.h>
+
+
+// C++
+//
+#include    <algorithm>
+
+
+// C
+//
+#include    <fcntl.h>
+#include    <poll.h>
+#include    <string.h>
+#include    <sys/eventfd.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the in memory mount table.
+ *
+ * The disk plugin used to read /proc/mounts on every tick. The list of
+ * mounts rarely changes so this implementation keeps it in memory and
+ * reloads it only when the kernel says it changed. The kernel signals
+ * a change by marking the /proc/self/mounts file descriptor with
+ * POLLPRI and POLLERR.
+ *
+ * The watcher runs in its own thread and sleeps in poll(). When a change
+ * is detected, the table is reloaded. If a file system which was mounted
+ * read/write is now mounted read-only (the kernel does that on certain
+ * I/O errors), the watcher forces a tick so the disk plugin reports the
+ * error immediately.
+ */
+
+
+
+namespace sitter
+{
+namespace disk
+{
+
+
+
+namespace
+{
+
+
+
+bool is_read_only(snapdev::mount_entry const & entry)
+{
+    advgetopt::string_list_t options;
+    advgetopt::split_string(entry.get_options(), options, { "," });
+    return std::find(options.begin(), options.end(), "ro") != options.end();
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Initialize the mount watcher.
+ *
+ * The constructor opens /proc/self/mounts (the file descriptor which we
+ * poll) and an eventfd used to wake up the thread when it has to exit.
+ *
+ * \param[in] s  The sitter server, used to force a tick.
+ */
+mount_watcher::mount_watcher(server * s)
+    : runner("mount-watcher")
+    , f_server(s)
+    , f_mounts_fd(open("/proc/self/mounts", O_RDONLY | O_CLOEXEC))
+    , f_wakeup_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+    if(f_mounts_fd.get() == -1)
+    {
+        int const e(errno);
+        SNAP_LOG_WARNING
+            << "could not open /proc/self/mounts to watch for changes (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << "); the list of mounts will be reloaded on each tick."
+            << SNAP_LOG_SEND;
+    }
+}
+
+
+mount_watcher::~mount_watcher()
+{
+}
+
+
+/** \brief Get the current list of mounts.
+ *
+ * The list is loaded the first time and then reloaded only when the
+ * watcher detects a change. If the watcher is not running (i.e. it
+ * could not open /proc/self/mounts or poll() failed), then the list is
+ * reloaded each time.
+ *
+ * \return A pointer to the list of mounts.
+ */
+mounts_pointer_t mount_watcher::get_mounts()
+{
+    cppthread::guard lock(f_mutex);
+
+    if(f_mounts == nullptr
+    || !f_watching)
+    {
+        load_mounts();
+    }
+
+    return f_mounts;
+}
+
+
+/** \brief Get the list of mounts which were remounted read-only.
+ *
+ * This function returns the list of mount points which switched from
+ * read/write to read-only since the last call.
+ *
+ * \return The list of directories.
+ */
+advgetopt::string_list_t mount_watcher::get_remounted_read_only()
+{
+    cppthread::guard lock(f_mutex);
+
+    advgetopt::string_list_t result;
+    result.swap(f_remounted_read_only);
+    return result;
+}
+
+
+/** \brief Wake up the thread so it can exit.
+ *
+ * This function is called when the thread is asked to stop.
+ */
+void mount_watcher::wakeup()
+{
+    std::uint64_t const value(1);
+    snapdev::NOT_USED(write(f_wakeup_fd.get(), &value, sizeof(value)));
+}
+
+
+/** \brief Wait for changes to the list of mounts.
+ *
+ * This function polls /proc/self/mounts and reloads the list of mounts
+ * each time the kernel signals a change.
+ */
+void mount_watcher::run()
+{
+    if(f_mounts_fd.get() == -1
+    || f_wakeup_fd.get() == -1)
+    {
+        return;
+    }
+
+    {
+        cppthread::guard lock(f_mutex);
+        f_watching = true;
+    }
+
+    watch();
+
+    cppthread::guard lock(f_mutex);
+    f_watching = false;
+}
+
+
+/** \brief The poll() loop.
+ *
+ * This function returns when the thread is asked to exit or poll()
+ * fails.
+ */
+void mount_watcher::watch()
+{
+    while(continue_running())
+    {
+        pollfd fds[2] = {};
+        fds[0].fd = f_mounts_fd.get();
+        fds[0].events = POLLPRI;
+        fds[1].fd = f_wakeup_fd.get();
+        fds[1].events = POLLIN;
+        int const r(poll(fds, 2, -1));
+        if(r < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            int const e(errno);
+            SNAP_LOG_ERROR
+                << "poll() on /proc/self/mounts failed (errno: "
+                << e
+                << ", "
+                << strerror(e)
+                << "); the list of mounts will be reloaded on each tick."
+                << SNAP_LOG_SEND;
+            return;
+        }
+
+        if((fds[1].revents & POLLIN) != 0)
+        {
+            // asked to exit
+            //
+            return;
+        }
+
+        if((fds[0].revents & (POLLPRI | POLLERR)) != 0)
+        {
+            bool force_tick(false);
+            {
+                cppthread::guard lock(f_mutex);
+                load_mounts();
+                force_tick = !f_remounted_read_only.empty();
+            }
+            if(force_tick)
+            {
+                f_server->force_tick();
+            }
+        }
+    }
+}
+
+
+/** \brief Load the list of mounts.
+ *
+ * This function reloads the list of mounts and compares the read-only
+ * flag of each mount point against the previous list. A mount point
+ * which switched from read/write to read-only is added to the list
+ * of remounted read-only directories.
+ *
+ * \note
+ * This function must be called with the mutex locked.
+ */
+void mount_watcher::load_mounts()
+{
+    bool const first(f_mounts == nullptr);
+    mounts_pointer_t m(std::make_shared<snapdev::mounts>("/proc/self/mounts"));
+
+    std::set<std::string> read_only;
+    for(auto const & entry : *m)
+    {
+        if(is_read_only(entry))
+        {
+            read_only.insert(entry.get_dir());
+        }
+    }
+
+    if(!first)
+    {
+        for(auto const & dir : read_only)
+        {
+            if(f_read_only.find(dir) == f_read_only.end()
+            && std::find_if(
+                      f_mounts->begin()
+                    , f_mounts->end()
+                    , [&dir](snapdev::mount_entry const & entry)
+                      {
+                          return entry.get_dir() == dir;
+                      }) != f_mounts->end())
+            {
+                // this mount point existed and was read/write
+                //
+                SNAP_LOG_ERROR
+                    << "file system mounted on \""
+                    << dir
+                    << "\" was remounted read-only."
+                    << SNAP_LOG_SEND;
+                f_remounted_read_only.push_back(dir);
+            }
+        }
+    }
+
+    f_read_only.swap(read_only);
+    f_mounts = m;
+}
+
+
+
+
+
+/** \brief Start the mount watcher thread.
+ *
+ * \param[in] s  The sitter server.
+ */
+mount_table::mount_table(server * s)
+    : f_watcher(std::make_shared<mount_watcher>(s))
+    , f_thread(std::make_shared<cppthread::thread>("mount-watcher", f_watcher))
+{
+    f_thread->start();
+}
+
+
+/** \brief Stop the mount watcher thread.
+ *
+ * The thread sleeps in poll() so we have to wake it up for it to exit.
+ */
+mount_table::~mount_table()
+{
+    f_thread->stop([this](cppthread::thread * t)
+        {
+            snapdev::NOT_USED(t);
+            f_watcher->wakeup();
+        });
+}
+
+
+/** \brief Get the current list of mounts.
+ *
+ * \return A pointer to the list of mounts.
+ */
+mounts_pointer_t mount_table::get_mounts()
+{
+    return f_watcher->get_mounts();
+}
+
+
+/** \brief Get the list of mounts which were remounted read-only.
+ *
+ * \return The list of directories remounted read-only since the last call.
+ */
+advgetopt::string_list_t mount_table::get_remounted_read_only()
+{
+    return f_watcher->get_remounted_read_only();
+}
+
+
+
+} // namespace disk
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,117 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// advgetopt
+//
+#include    <advgetopt/utils.h>
+
+
+// cppthread
+//
+#include    <cppthread/mutex.h>
+#include    <cppthread/runner.h>
+#include    <cppthread/thread.h>
+
+
+// snapdev
+//
+#include    <snapdev/mounts.h>
+#include    <snapdev/raii_generic_deleter.h>
+
+
+// C++
+//
+#include    <set>
+
+
+
+namespace sitter
+{
+class server;
+
+namespace disk
+{
+
+
+
+typedef std::shared_ptr<snapdev::mounts>    mounts_pointer_t;
+
+
+class mount_watcher
+    : public cppthread::runner
+{
+public:
+    typedef std::shared_ptr<mount_watcher>  pointer_t;
+
+                            mount_watcher(server * s);
+                            mount_watcher(mount_watcher const &) = delete;
+    virtual                 ~mount_watcher() override;
+    mount_watcher &         operator = (mount_watcher const &) = delete;
+
+    mounts_pointer_t        get_mounts();
+    advgetopt::string_list_t
+                            get_remounted_read_only();
+    void                    wakeup();
+
+    // cppthread::runner implementation
+    //
+    virtual void            run() override;
+
+private:
+    void                    watch();
+    void                    load_mounts();
+
+    server *                f_server = nullptr;
+    cppthread::mutex        f_mutex = cppthread::mutex();
+    snapdev::raii_fd_t      f_mounts_fd = snapdev::raii_fd_t();
+    snapdev::raii_fd_t      f_wakeup_fd = snapdev::raii_fd_t();
+    mounts_pointer_t        f_mounts = mounts_pointer_t();
+    bool                    f_watching = false;
+    std::set<std::string>   f_read_only = std::set<std::string>();
+    advgetopt::string_list_t
+                            f_remounted_read_only = advgetopt::string_list_t();
+};
+
+
+class mount_table
+{
+public:
+    typedef std::shared_ptr<mount_table>    pointer_t;
+
+                            mount_table(server * s);
+                            mount_table(mount_table const &) = delete;
+                            ~mount_table();
+    mount_table &           operator = (mount_table const &) = delete;
+
+    mounts_pointer_t        get_mounts();
+    advgetopt::string_list_t
+                            get_remounted_read_only();
+
+private:
+    mount_watcher::pointer_t
+                            f_watcher = mount_watcher::pointer_t();
+    cppthread::thread::pointer_t
+                            f_thread = cppthread::thread::pointer_t();
+};
+
+
+
+} // namespace disk
+} // namespace sitter
+// vim: ts=4 sw=4 et
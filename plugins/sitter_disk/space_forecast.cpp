@@ -0,0 +1,247 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "space_forecast.h"
+
+
+// sitter
+//
+#include    <sitter/monotonic_clock.h>
+
+
+// C++
+//
+#include    <cmath>
+#include    <limits>
+
+
+// C
+//
+#include    <time.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the disk full forecast.
+ *
+ * A fixed threshold (i.e. 90% used) is not a good indicator of a problem.
+ * A log storm can fill a partition between two checks while a large
+ * partition used at 91% may be fine for months.
+ *
+ * This forecast keeps an incremental linear regression of the available
+ * space (blocks and inodes) of each partition over time. The regression
+ * only keeps five running sums. Older samples have their weight reduced
+ * on each new sample so the slope follows the current trend.
+ *
+ * The slope gives us the rate at which the partition gets filled and
+ * from that we estimate the time until the partition is full.
+ */
+
+
+
+namespace sitter
+{
+namespace disk
+{
+
+
+
+
+/** \brief Add a sample to the forecast of a partition.
+ *
+ * This function adds the current available space and inodes of a
+ * partition to its regressions. It also forgets partitions which were
+ * not sampled in a while (i.e. they were unmounted).
+ *
+ * \param[in] dir  The directory where the partition is mounted.
+ * \param[in] total  The total number of blocks.
+ * \param[in] available  The number of available blocks.
+ * \param[in] inode_total  The total number of inodes.
+ * \param[in] inode_available  The number of available inodes.
+ */
+void space_forecast::add_sample(
+      std::string const & dir
+    , std::uint64_t total
+    , std::uint64_t available
+    , std::uint64_t inode_total
+    , std::uint64_t inode_available)
+{
+    double const now(monotonic_seconds());
+
+    auto it(f_partitions.find(dir));
+    if(it == f_partitions.end())
+    {
+        partition_t p;
+        p.f_origin = now;
+        it = f_partitions.insert({ dir, p }).first;
+    }
+
+    // use a time relative to the first sample to keep the precision
+    //
+    double const t(now - it->second.f_origin);
+    it->second.f_last_time = now;
+    it->second.f_blocks.add(t, total, available);
+    it->second.f_inodes.add(t, inode_total, inode_available);
+
+    for(auto p(f_partitions.begin()); p != f_partitions.end(); )
+    {
+        if(now - p->second.f_last_time > MAXIMUM_IDLE_TIME)
+        {
+            p = f_partitions.erase(p);
+        }
+        else
+        {
+            ++p;
+        }
+    }
+}
+
+
+/** \brief Estimate the time until the partition has no more space.
+ *
+ * \param[in] dir  The directory where the partition is mounted.
+ *
+ * \return The number of seconds until full, infinity if the available
+ * space is not decreasing, or NO_ESTIMATE if there is not enough data.
+ */
+double space_forecast::time_to_full(std::string const & dir) const
+{
+    auto const it(f_partitions.find(dir));
+    if(it == f_partitions.end())
+    {
+        return NO_ESTIMATE;
+    }
+    return it->second.f_blocks.time_to_full();
+}
+
+
+/** \brief Estimate the time until the partition has no more inodes.
+ *
+ * \param[in] dir  The directory where the partition is mounted.
+ *
+ * \return The number of seconds until full, infinity if the number of
+ * available inodes is not decreasing, or NO_ESTIMATE if there is not
+ * enough data.
+ */
+double space_forecast::inode_time_to_full(std::string const & dir) const
+{
+    auto const it(f_partitions.find(dir));
+    if(it == f_partitions.end())
+    {
+        return NO_ESTIMATE;
+    }
+    return it->second.f_inodes.time_to_full();
+}
+
+
+void space_forecast::regression_t::reset()
+{
+    *this = regression_t();
+}
+
+
+/** \brief Add one sample to the regression.
+ *
+ * When the size of the partition changes (it was resized) or a large
+ * amount of space gets freed (a cleanup), the previous trend does not
+ * apply anymore so we restart from scratch.
+ *
+ * The weight of the previous samples decays with the time elapsed since
+ * the last sample, not with the number of samples, so forced ticks do
+ * not make the regression forget its history faster.
+ *
+ * \param[in] t  The time of the sample in seconds.
+ * \param[in] total  The total size.
+ * \param[in] available  The available size.
+ */
+void space_forecast::regression_t::add(double t, std::uint64_t total, std::uint64_t available)
+{
+    if(f_samples > 0
+    && (total != f_total
+        || (available > f_last && available - f_last > total / 20)))
+    {
+        reset();
+    }
+
+    double const y(static_cast<double>(available));
+    double const decay(f_samples == 0 ? 0.0 : std::exp((f_last_time - t) / DECAY_PERIOD));
+
+    f_weight = f_weight * decay + 1.0;
+    f_t      = f_t      * decay + t;
+    f_y      = f_y      * decay + y;
+    f_tt     = f_tt     * decay + t * t;
+    f_ty     = f_ty     * decay + t * y;
+
+    if(f_samples == 0)
+    {
+        f_first_time = t;
+    }
+    f_last_time = t;
+    f_total = total;
+    f_last = available;
+    ++f_samples;
+}
+
+
+/** \brief Compute the time until full from the slope.
+ *
+ * A few samples taken within a short period of time do not represent
+ * a trend so no estimate is returned until the samples cover at least
+ * MINIMUM_PERIOD seconds.
+ *
+ * \return The number of seconds until full, infinity if the slope is
+ * not negative, or NO_ESTIMATE.
+ */
+double space_forecast::regression_t::time_to_full() const
+{
+    if(f_samples < MINIMUM_SAMPLES
+    || f_last_time - f_first_time < MINIMUM_PERIOD
+    || f_total == 0)
+    {
+        return NO_ESTIMATE;
+    }
+
+    double const d(f_weight * f_tt - f_t * f_t);
+    if(d <= 0.0)
+    {
+        return NO_ESTIMATE;
+    }
+    double const slope((f_weight * f_ty - f_t * f_y) / d);
+    if(slope >= 0.0)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    return static_cast<double>(f_last) / -slope;
+}
+
+
+
+} // namespace disk
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,88 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <cstdint>
+#include    <map>
+#include    <string>
+
+
+
+namespace sitter
+{
+namespace disk
+{
+
+
+
+class space_forecast
+{
+public:
+    static constexpr double const       DECAY_PERIOD = 50.0 * 60.0;     // the weight of a sample is divided by e every 50 minutes
+    static constexpr double const       MINIMUM_PERIOD = 30.0 * 60.0;   // the samples must cover at least 30 minutes
+    static constexpr std::size_t const  MINIMUM_SAMPLES = 5;
+    static constexpr double const       MAXIMUM_IDLE_TIME = 60.0 * 60.0; // forget partitions not seen for 1h
+    static constexpr double const       NO_ESTIMATE = -1.0;
+
+    void                    add_sample(
+                                  std::string const & dir
+                                , std::uint64_t total
+                                , std::uint64_t available
+                                , std::uint64_t inode_total
+                                , std::uint64_t inode_available);
+    double                  time_to_full(std::string const & dir) const;
+    double                  inode_time_to_full(std::string const & dir) const;
+
+private:
+    struct regression_t
+    {
+        void                reset();
+        void                add(double t, std::uint64_t total, std::uint64_t available);
+        double              time_to_full() const;
+
+        std::uint64_t       f_total = 0;
+        std::uint64_t       f_last = 0;
+        std::size_t         f_samples = 0;
+        double              f_first_time = 0.0;
+        double              f_last_time = 0.0;
+        double              f_weight = 0.0;
+        double              f_t = 0.0;
+        double              f_y = 0.0;
+        double              f_tt = 0.0;
+        double              f_ty = 0.0;
+    };
+
+    struct partition_t
+    {
+        double              f_origin = 0.0;
+        double              f_last_time = 0.0;
+        regression_t        f_blocks = regression_t();
+        regression_t        f_inodes = regression_t();
+    };
+    typedef std::map<std::string, partition_t>  partition_map_t;
+
+    partition_map_t         f_partitions = partition_map_t();
+};
+
+
+
+} // namespace disk
+} // namespace sitter
+// vim: ts=4 sw=4 et
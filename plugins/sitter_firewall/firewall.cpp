@@ -98,8 +98,10 @@ void firewall::on_process_watch(as2js::json::json_value_ref & json)
     //          firewall is up; what we need to test is whether the ipload
     //          service is "active" (ran successfully)
     //
-    cppprocess::process_list list;
-    cppprocess::process_info::pointer_t info(list.find("ipwall"));
+    // the server keeps a pidfd on ipwall once found so this does not
+    // scan /proc on each tick
+    //
+    cppprocess::process_info::pointer_t info(plugins()->get_server<sitter::server>()->find_process("ipwall"));
     if(!plugins()->get_server<sitter::server>()->output_process("firewall", e, info, "ipwall", 95))
     {
         return;
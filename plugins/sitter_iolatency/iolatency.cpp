@@ -0,0 +1,300 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "iolatency.h"
+
+#include    "names.h"
+
+
+// advgetopt
+//
+#include    <advgetopt/utils.h>
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// snapdev
+//
+#include    <snapdev/gethostname.h>
+
+
+// serverplugins
+//
+#include    <serverplugins/collection.h>
+
+
+// C++
+//
+#include    <algorithm>
+#include    <cstring>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+/** \file
+ * \brief Measure the latency of the storage.
+ *
+ * This plugin writes a block, calls fsync(), and reads the block back in
+ * a scratch file found in each one of the directories listed in the
+ * iolatency_paths parameter (see latency_probe).
+ *
+ * The latencies are saved in two histograms per directory and operation:
+ * a baseline which represents the usual latency over the last few hours
+ * and a recent histogram which represents the last few minutes. When
+ * the recent p99 is much larger than the baseline p99, the storage
+ * regressed and an error is generated.
+ */
+
+
+
+namespace sitter
+{
+namespace iolatency
+{
+
+SERVERPLUGINS_START(iolatency)
+    , ::serverplugins::description(
+            "Measure the write and read latency of the storage.")
+    , ::serverplugins::dependency("server")
+    , ::serverplugins::help_uri("https://snapwebsites.org/help")
+    , ::serverplugins::categorization_tag("disk")
+SERVERPLUGINS_END(iolatency)
+
+
+
+
+namespace
+{
+
+
+
+// the baseline covers the last few hours and the recent latencies the
+// last few minutes; the baseline is trusted after one hour
+//
+latency_settings_t const    g_latency_settings =
+{
+    200.0 * 60.0,   // baseline period
+    4.5 * 60.0,     // recent period
+    100.0,          // minimum samples
+    60.0 * 60.0,    // minimum period
+};
+
+
+
+} // no name namespace
+
+
+
+
+iolatency::mount_latency_t::mount_latency_t()
+    : f_write(g_latency_settings)
+    , f_read(g_latency_settings)
+{
+}
+
+
+/** \brief Initialize iolatency.
+ *
+ * This function terminates the initialization of the iolatency plugin
+ * by registering for different events.
+ */
+void iolatency::bootstrap()
+{
+    SERVERPLUGINS_LISTEN(iolatency, server, process_watch, std::placeholders::_1);
+}
+
+
+/** \brief Process this sitter data.
+ *
+ * This function probes each directory and updates the histograms.
+ *
+ * \param[in] json  The document where the results are collected.
+ */
+void iolatency::on_process_watch(as2js::json::json_value_ref & json)
+{
+    SNAP_LOG_DEBUG
+        << "iolatency::on_process_watch(): processing"
+        << SNAP_LOG_SEND;
+
+    sitter::server::pointer_t server(plugins()->get_server<sitter::server>());
+
+    as2js::json::json_value_ref e(json["iolatency"]);
+
+    advgetopt::string_list_t dirs;
+    advgetopt::split_string(server->get_server_parameter(g_name_iolatency_paths), dirs, { ":" });
+    if(dirs.empty())
+    {
+        std::string const data_path(server->get_server_parameter("data_path"));
+        if(!data_path.empty())
+        {
+            dirs.push_back(data_path);
+        }
+    }
+
+    // forget about directories which were removed from the list
+    //
+    for(auto it(f_mounts.begin()); it != f_mounts.end(); )
+    {
+        if(std::find(dirs.begin(), dirs.end(), it->first) == dirs.end())
+        {
+            it = f_mounts.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    probe_result_vector_t const results(f_probe.probe(dirs));
+    for(auto const & r : results)
+    {
+        as2js::json::json_value_ref p(e["directory"][-1]);
+        p["dir"] = r.f_dir;
+
+        switch(r.f_status)
+        {
+        case probe_status_t::PROBE_STATUS_SUCCESS:
+            {
+                p["direct"] = r.f_direct;
+                mount_latency_t & m(f_mounts[r.f_dir]);
+                check_latency(e, p, r.f_dir, "write", m.f_write, r.f_write);
+                check_latency(e, p, r.f_dir, "read", m.f_read, r.f_read);
+            }
+            break;
+
+        case probe_status_t::PROBE_STATUS_TIMED_OUT:
+        case probe_status_t::PROBE_STATUS_UNRESPONSIVE:
+            p["error"] = "unresponsive";
+            server->append_error(
+                  e
+                , "iolatency"
+                , "storage of \""
+                    + r.f_dir
+                    + "\" on \""
+                    + snapdev::gethostname()
+                    + "\" does not respond to a write and read of "
+                    + std::to_string(latency_probe::BLOCK_SIZE)
+                    + " bytes."
+                , 75);
+            break;
+
+        case probe_status_t::PROBE_STATUS_FAILED:
+        default:
+            p["error"] = strerror(r.f_errno);
+            server->append_error(
+                  e
+                , "iolatency"
+                , "could not probe the latency of the storage of \""
+                    + r.f_dir
+                    + "\" on \""
+                    + snapdev::gethostname()
+                    + "\": "
+                    + strerror(r.f_errno)
+                    + "."
+                , 30);
+            break;
+
+        }
+    }
+}
+
+
+/** \brief Add the samples of one operation and check for a regression.
+ *
+ * \param[in] e  The "iolatency" object where errors are added.
+ * \param[in] p  The object of the directory in the JSON data.
+ * \param[in] dir  The directory being probed.
+ * \param[in] operation  The name of the operation ("write" or "read").
+ * \param[in,out] t  The latency tracker of this directory and operation.
+ * \param[in] samples  The new latencies in microseconds.
+ */
+void iolatency::check_latency(
+      as2js::json::json_value_ref & e
+    , as2js::json::json_value_ref & p
+    , std::string const & dir
+    , std::string const & operation
+    , latency_tracker & t
+    , std::vector<double> const & samples)
+{
+    sitter::server::pointer_t server(plugins()->get_server<sitter::server>());
+
+    t.add(samples);
+    double const recent_p99(t.recent_percentile(0.99));
+
+    p[operation + "_p50"] = t.recent_percentile(0.5);
+    p[operation + "_p99"] = recent_p99;
+    p[operation + "_baseline_p99"] = t.baseline_percentile(0.99);
+
+    double const maximum(static_cast<double>(server->get_integer_parameter(g_name_iolatency_maximum, 1000)) * 1000.0);
+    if(recent_p99 >= maximum)
+    {
+        p["error"] = operation + " latency too high";
+        server->append_error(
+              e
+            , "iolatency"
+            , "the p99 "
+                + operation
+                + " latency of the storage of \""
+                + dir
+                + "\" on \""
+                + snapdev::gethostname()
+                + "\" is "
+                + format_ms(recent_p99)
+                + "."
+            , 70);
+        return;
+    }
+
+    double const minimum(static_cast<double>(server->get_integer_parameter(g_name_iolatency_minimum, 20)) * 1000.0);
+    double const regression(static_cast<double>(server->get_integer_parameter(g_name_iolatency_regression, 300)) / 100.0);
+    if(t.is_regression(minimum, regression))
+    {
+        p["error"] = operation + " latency regression";
+        server->append_error(
+              e
+            , "iolatency"
+            , "the p99 "
+                + operation
+                + " latency of the storage of \""
+                + dir
+                + "\" on \""
+                + snapdev::gethostname()
+                + "\" went from "
+                + format_ms(t.previous_baseline_p99())
+                + " to "
+                + format_ms(recent_p99)
+                + "."
+            , 60);
+    }
+}
+
+
+
+} // namespace iolatency
+} // namespace sitter
+// vim: ts=4 sw=4 et
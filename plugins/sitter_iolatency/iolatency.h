@@ -0,0 +1,85 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    "latency_probe.h"
+
+
+// sitter
+//
+#include    <sitter/latency_tracker.h>
+#include    <sitter/sitter.h>
+
+
+// serverplugins
+//
+#include    <serverplugins/plugin.h>
+
+
+
+namespace sitter
+{
+namespace iolatency
+{
+
+
+
+SERVERPLUGINS_VERSION(iolatency, 1, 0)
+
+
+class iolatency
+    : public serverplugins::plugin
+{
+public:
+    SERVERPLUGINS_DEFAULTS(iolatency);
+
+    // serverplugins::plugin implementation
+    virtual void        bootstrap() override;
+
+    // server signal
+    void                on_process_watch(as2js::json::json_value_ref & json);
+
+private:
+    struct mount_latency_t
+    {
+                            mount_latency_t();
+
+        latency_tracker     f_write;
+        latency_tracker     f_read;
+    };
+    typedef std::map<std::string, mount_latency_t>  mount_latency_map_t;
+
+    void                check_latency(
+                                  as2js::json::json_value_ref & e
+                                , as2js::json::json_value_ref & p
+                                , std::string const & dir
+                                , std::string const & operation
+                                , latency_tracker & t
+                                , std::vector<double> const & samples);
+
+    latency_probe       f_probe = latency_probe();
+    mount_latency_map_t f_mounts = mount_latency_map_t();
+};
+
+
+
+} // namespace iolatency
+} // namespace sitter
+// vim: ts=4 sw=4 et
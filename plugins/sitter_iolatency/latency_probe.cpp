@@ -0,0 +1,291 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "latency_probe.h"
+
+
+// sitter
+//
+#include    <sitter/monotonic_clock.h>
+
+
+// snapdev
+//
+#include    <snapdev/raii_generic_deleter.h>
+
+
+// C++
+//
+#include    <cstdlib>
+#include    <cstring>
+#include    <memory>
+
+
+// C
+//
+#include    <fcntl.h>
+#include    <unistd.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the storage latency probe.
+ *
+ * statvfs() returns immediately even when a device is degraded and each
+ * write takes half a second. The probe measures what the services see:
+ * it writes one block to a scratch file, calls fsync(), and reads the
+ * block back.
+ *
+ * When the file system supports it, the file is opened with O_DIRECT so
+ * the page cache is bypassed. Otherwise the block is removed from the
+ * cache with posix_fadvise() before it gets read back.
+ *
+ * A write on a dead device can block forever, so like the statvfs()
+ * probes of the disk plugin, the directories are probed in a probe_pool.
+ * A probe which does not return in time is abandoned and that directory
+ * is not probed again until it does.
+ */
+
+
+
+namespace sitter
+{
+namespace iolatency
+{
+
+
+
+namespace
+{
+
+
+
+struct free_deleter
+{
+    void operator () (void * ptr)
+    {
+        free(ptr);
+    }
+};
+
+
+
+} // no name namespace
+
+
+
+/** \brief Probe a set of directories.
+ *
+ * This function measures the write and read latency of each one of the
+ * \p dirs concurrently and returns the results in the same order.
+ *
+ * A directory for which a previous probe is still pending is not probed
+ * again. Its status is set to PROBE_STATUS_UNRESPONSIVE.
+ *
+ * \param[in] dirs  The list of directories to probe.
+ * \param[in] timeout  The maximum amount of time each probe can take in
+ * microseconds.
+ *
+ * \return The list of results.
+ */
+probe_result_vector_t latency_probe::probe(
+      std::vector<std::string> const & dirs
+    , std::int64_t timeout)
+{
+    // the callbacks own their result since an abandoned one may return
+    // after this function
+    //
+    std::vector<std::shared_ptr<probe_result_t>> probed;
+    probe_pool::probe_vector_t probes;
+    probed.reserve(dirs.size());
+    probes.reserve(dirs.size());
+    for(auto const & d : dirs)
+    {
+        std::shared_ptr<probe_result_t> r(std::make_shared<probe_result_t>());
+        r->f_dir = d;
+        probed.push_back(r);
+
+        probe_pool::probe_t p;
+        p.f_key = d;
+        p.f_callback = [r]()
+            {
+                measure(*r);
+            };
+        probes.push_back(p);
+    }
+
+    probe_pool::status_vector_t const status(f_pool.run(probes, timeout));
+
+    probe_result_vector_t result(dirs.size());
+    for(std::size_t idx(0); idx < dirs.size(); ++idx)
+    {
+        switch(status[idx])
+        {
+        case probe_status_t::PROBE_STATUS_SUCCESS:
+            result[idx] = *probed[idx];
+            break;
+
+        case probe_status_t::PROBE_STATUS_TIMED_OUT:
+            result[idx].f_dir = dirs[idx];
+            result[idx].f_status = probe_status_t::PROBE_STATUS_TIMED_OUT;
+            result[idx].f_errno = ETIMEDOUT;
+            break;
+
+        default:
+            result[idx].f_dir = dirs[idx];
+            result[idx].f_status = probe_status_t::PROBE_STATUS_UNRESPONSIVE;
+            break;
+
+        }
+    }
+
+    return result;
+}
+
+
+/** \brief Open an unnamed probe file in a directory.
+ *
+ * The probe file is created with O_TMPFILE so it never appears in the
+ * directory and gets released when closed. On a file system which does
+ * not support O_TMPFILE, a named file is created and immediately
+ * unlinked so no file is left behind either way.
+ *
+ * \param[in] dir  The directory where the file gets created.
+ * \param[in] flags  The flags used to open the file.
+ *
+ * \return The file descriptor or -1 and errno set.
+ */
+int latency_probe::open_probe_file(std::string const & dir, int flags)
+{
+    int const fd(open(dir.c_str(), flags | O_TMPFILE, 0600));
+    if(fd != -1
+    || (errno != EOPNOTSUPP && errno != EISDIR))
+    {
+        return fd;
+    }
+
+    std::string const filename(dir + '/' + PROBE_FILENAME);
+    int const named(open(filename.c_str(), flags | O_CREAT, 0600));
+    if(named != -1)
+    {
+        unlink(filename.c_str());
+    }
+    return named;
+}
+
+
+/** \brief Measure the latency of one directory.
+ *
+ * The function writes and reads ITERATIONS blocks at the start of the
+ * probe file.
+ *
+ * \param[in,out] r  The result where the latencies are saved.
+ */
+void latency_probe::measure(probe_result_t & r)
+{
+    r.f_direct = true;
+    int f(open_probe_file(r.f_dir, O_RDWR | O_CLOEXEC | O_DIRECT));
+    if(f == -1
+    && errno == EINVAL)
+    {
+        // this file system does not support O_DIRECT (i.e. tmpfs)
+        //
+        r.f_direct = false;
+        f = open_probe_file(r.f_dir, O_RDWR | O_CLOEXEC);
+    }
+    if(f == -1)
+    {
+        r.f_errno = errno;
+        r.f_status = probe_status_t::PROBE_STATUS_FAILED;
+        return;
+    }
+    snapdev::raii_fd_t fd(f);
+
+    // O_DIRECT requires an aligned buffer
+    //
+    void * ptr(nullptr);
+    if(posix_memalign(&ptr, BLOCK_SIZE, BLOCK_SIZE) != 0)
+    {
+        r.f_errno = ENOMEM;
+        r.f_status = probe_status_t::PROBE_STATUS_FAILED;
+        return;
+    }
+    std::unique_ptr<void, free_deleter> buffer(ptr);
+    memset(buffer.get(), 0, BLOCK_SIZE);
+
+    for(std::size_t idx(0); idx < ITERATIONS; ++idx)
+    {
+        // change the data so the device cannot optimize the write away
+        //
+        *reinterpret_cast<std::int64_t *>(buffer.get()) = monotonic_usec();
+
+        // a short write or read does not set errno, use EIO instead of
+        // whatever errno was left by a previous call
+        //
+        std::int64_t const write_start(monotonic_usec());
+        ssize_t const written(pwrite(fd.get(), buffer.get(), BLOCK_SIZE, 0));
+        if(written != static_cast<ssize_t>(BLOCK_SIZE))
+        {
+            r.f_errno = written == -1 ? errno : EIO;
+            r.f_status = probe_status_t::PROBE_STATUS_FAILED;
+            return;
+        }
+        if(fsync(fd.get()) != 0)
+        {
+            r.f_errno = errno;
+            r.f_status = probe_status_t::PROBE_STATUS_FAILED;
+            return;
+        }
+        std::int64_t const write_end(monotonic_usec());
+        r.f_write.push_back(static_cast<double>(write_end - write_start));
+
+        if(!r.f_direct)
+        {
+            posix_fadvise(fd.get(), 0, BLOCK_SIZE, POSIX_FADV_DONTNEED);
+        }
+
+        std::int64_t const read_start(monotonic_usec());
+        ssize_t const size(pread(fd.get(), buffer.get(), BLOCK_SIZE, 0));
+        if(size != static_cast<ssize_t>(BLOCK_SIZE))
+        {
+            r.f_errno = size == -1 ? errno : EIO;
+            r.f_status = probe_status_t::PROBE_STATUS_FAILED;
+            return;
+        }
+        std::int64_t const read_end(monotonic_usec());
+        r.f_read.push_back(static_cast<double>(read_end - read_start));
+    }
+
+    r.f_status = probe_status_t::PROBE_STATUS_SUCCESS;
+}
+
+
+
+} // namespace iolatency
+} // namespace sitter
+// vim: ts=4 sw=4 et
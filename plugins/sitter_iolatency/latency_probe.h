@@ -0,0 +1,75 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// sitter
+//
+#include    <sitter/probe_pool.h>
+
+
+// C++
+//
+#include    <string>
+#include    <vector>
+
+
+
+namespace sitter
+{
+namespace iolatency
+{
+
+
+
+struct probe_result_t
+{
+    std::string                 f_dir = std::string();
+    probe_status_t              f_status = probe_status_t::PROBE_STATUS_FAILED;
+    int                         f_errno = 0;
+    bool                        f_direct = false;
+    std::vector<double>         f_write = std::vector<double>();    // write + fsync in microseconds
+    std::vector<double>         f_read = std::vector<double>();     // read in microseconds
+};
+typedef std::vector<probe_result_t>     probe_result_vector_t;
+
+
+class latency_probe
+{
+public:
+    static constexpr std::size_t const  ITERATIONS = 4;
+    static constexpr std::size_t const  BLOCK_SIZE = 4096;
+    static constexpr std::size_t const  MAXIMUM_HELPERS = 4;
+    static constexpr std::int64_t const DEFAULT_TIMEOUT = 10'000'000;   // 10 seconds in microseconds
+    static constexpr char const *       PROBE_FILENAME = ".sitter-iolatency-probe";
+
+    probe_result_vector_t       probe(
+                                      std::vector<std::string> const & dirs
+                                    , std::int64_t timeout = DEFAULT_TIMEOUT);
+
+private:
+    static int                  open_probe_file(std::string const & dir, int flags);
+    static void                 measure(probe_result_t & r);
+
+    probe_pool                  f_pool = probe_pool("iolatency", MAXIMUM_HELPERS);
+};
+
+
+
+} // namespace iolatency
+} // namespace sitter
+// vim: ts=4 sw=4 et
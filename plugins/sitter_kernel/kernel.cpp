@@ -0,0 +1,151 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "kernel.h"
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// snapdev
+//
+#include    <snapdev/gethostname.h>
+
+
+// serverplugins
+//
+#include    <serverplugins/collection.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+/** \file
+ * \brief Report the errors found in the kernel log.
+ *
+ * The kernel log monitor (see sitter/kmsg_monitor.cpp) reads the records
+ * of /dev/kmsg as they arrive and counts them per class (out of memory
+ * kill, I/O error, hung task, etc.)
+ *
+ * This plugin saves the counters of the last tick and generates one
+ * error per class which had records. The priority of the error is the
+ * priority of the class.
+ */
+
+
+
+namespace sitter
+{
+namespace kernel
+{
+
+SERVERPLUGINS_START(kernel)
+    , ::serverplugins::description(
+            "Check the kernel log for out of memory kills, I/O errors, hung tasks, etc.")
+    , ::serverplugins::dependency("server")
+    , ::serverplugins::help_uri("https://snapwebsites.org/help")
+    , ::serverplugins::categorization_tag("os")
+SERVERPLUGINS_END(kernel)
+
+
+
+
+/** \brief Initialize kernel.
+ *
+ * This function terminates the initialization of the kernel plugin
+ * by registering for different events.
+ */
+void kernel::bootstrap()
+{
+    SERVERPLUGINS_LISTEN(kernel, server, process_watch, std::placeholders::_1);
+}
+
+
+/** \brief Process this sitter data.
+ *
+ * This function saves the number of kernel records of each class
+ * received since the last tick and reports them.
+ *
+ * \param[in] json  The document where the results are collected.
+ */
+void kernel::on_process_watch(as2js::json::json_value_ref & json)
+{
+    SNAP_LOG_DEBUG
+        << "kernel::on_process_watch(): processing"
+        << SNAP_LOG_SEND;
+
+    sitter::server::pointer_t server(plugins()->get_server<sitter::server>());
+    kmsg_monitor::pointer_t monitor(server->get_kmsg_monitor());
+    if(monitor == nullptr)
+    {
+        return;
+    }
+
+    as2js::json::json_value_ref e(json["kernel"]);
+
+    kmsg_monitor::kmsg_counts_t const counts(monitor->get_counts());
+    e["records"] = counts.f_records;
+    e["lost"] = counts.f_lost;
+
+    for(auto const & c : counts.f_classes)
+    {
+        as2js::json::json_value_ref k(e["class"][-1]);
+        k["name"] = c.f_name;
+        k["count"] = c.f_count;
+        k["message"] = c.f_last_message;
+
+        server->append_error(
+              e
+            , "kernel"
+            , "kernel on \""
+                + snapdev::gethostname()
+                + "\" reported "
+                + std::to_string(c.f_count)
+                + ' '
+                + c.f_description
+                + (c.f_count == 1 ? "" : "s")
+                + ", last: "
+                + c.f_last_message
+            , c.f_priority);
+    }
+
+    if(counts.f_lost > 0)
+    {
+        server->append_error(
+              e
+            , "kernel"
+            , "the kernel overwrote "
+                + std::to_string(counts.f_lost)
+                + " log record(s) before the sitter could read them."
+            , 25);
+    }
+}
+
+
+
+} // namespace kernel
+} // namespace sitter
+// vim: ts=4 sw=4 et
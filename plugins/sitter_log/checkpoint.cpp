@@ -0,0 +1,242 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "checkpoint.h"
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// snapdev
+//
+#include    <snapdev/file_contents.h>
+
+
+// C++
+//
+#include    <sstream>
+
+
+// C
+//
+#include    <stdio.h>
+#include    <string.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+/** \file
+ * \brief This file implements the log checkpoints.
+ *
+ * A checkpoint records how far we scanned a log file: the device and
+ * inode of the file and the offset of the first byte which was not yet
+ * scanned. On the next tick, only the bytes added since are scanned.
+ *
+ * The checkpoints are saved in the sitter cache so a restart of the
+ * sitter does not rescan the logs.
+ *
+ * The file is a simple text file with one line per log file:
+ *
+ * \code
+ *     <device> <inode> <offset> <filename>
+ * \endcode
+ */
+
+
+
+namespace sitter
+{
+namespace log
+{
+
+
+
+/** \brief Load the checkpoints.
+ *
+ * If the file does not exist yet, the list of checkpoints remains empty.
+ *
+ * \param[in] filename  The name of the file with the checkpoints.
+ */
+void checkpoints::load(std::string const & filename)
+{
+    f_filename = filename;
+    f_checkpoints.clear();
+    f_saved.clear();
+
+    snapdev::file_contents in(f_filename);
+    if(!in.read_all())
+    {
+        return;
+    }
+    f_saved = in.contents();
+
+    std::istringstream lines(f_saved);
+    std::string line;
+    while(std::getline(lines, line))
+    {
+        std::istringstream fields(line);
+        checkpoint_t c;
+        std::uint64_t device(0);
+        std::uint64_t inode(0);
+        std::int64_t offset(0);
+        std::string name;
+        if(!(fields >> device >> inode >> offset)
+        || offset < 0)
+        {
+            continue;
+        }
+        fields.get();       // skip the space
+        std::getline(fields, name);
+        if(name.empty())
+        {
+            continue;
+        }
+        c.f_device = static_cast<dev_t>(device);
+        c.f_inode = static_cast<ino_t>(inode);
+        c.f_offset = static_cast<off_t>(offset);
+        f_checkpoints[name] = c;
+    }
+}
+
+
+/** \brief Save the checkpoints.
+ *
+ * The file is written only if something changed. It is first written
+ * in a temporary file which is then renamed so a crash never leaves a
+ * partial file behind.
+ *
+ * \return true if the checkpoints were saved or did not change.
+ */
+bool checkpoints::save()
+{
+    if(f_filename.empty())
+    {
+        return false;
+    }
+
+    std::stringstream ss;
+    for(auto const & c : f_checkpoints)
+    {
+        ss << static_cast<std::uint64_t>(c.second.f_device)
+           << ' '
+           << static_cast<std::uint64_t>(c.second.f_inode)
+           << ' '
+           << static_cast<std::int64_t>(c.second.f_offset)
+           << ' '
+           << c.first
+           << '\n';
+    }
+    std::string const contents(ss.str());
+    if(contents == f_saved)
+    {
+        return true;
+    }
+
+    std::string const tmp(f_filename + ".tmp");
+    snapdev::file_contents out(tmp);
+    out.contents(contents);
+    if(!out.write_all())
+    {
+        SNAP_LOG_ERROR
+            << "could not save the log checkpoints to \""
+            << tmp
+            << "\"."
+            << SNAP_LOG_SEND;
+        return false;
+    }
+    if(rename(tmp.c_str(), f_filename.c_str()) != 0)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not rename \""
+            << tmp
+            << "\" to \""
+            << f_filename
+            << "\" (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << ")."
+            << SNAP_LOG_SEND;
+        return false;
+    }
+
+    f_saved = contents;
+    return true;
+}
+
+
+/** \brief Check whether a log file has a checkpoint.
+ *
+ * \param[in] filename  The name of the log file.
+ *
+ * \return true if the file was scanned before.
+ */
+bool checkpoints::has_checkpoint(std::string const & filename) const
+{
+    return f_checkpoints.find(filename) != f_checkpoints.end();
+}
+
+
+/** \brief Get the checkpoint of a log file.
+ *
+ * If the log file does not yet have a checkpoint, a new one is created.
+ *
+ * \param[in] filename  The name of the log file.
+ *
+ * \return A reference to the checkpoint which can be updated.
+ */
+checkpoint_t & checkpoints::get_checkpoint(std::string const & filename)
+{
+    return f_checkpoints[filename];
+}
+
+
+/** \brief Forget about the log files which are gone.
+ *
+ * \param[in] filenames  The log files found on this tick.
+ */
+void checkpoints::keep_only(std::set<std::string> const & filenames)
+{
+    for(auto it(f_checkpoints.begin()); it != f_checkpoints.end(); )
+    {
+        if(filenames.find(it->first) == filenames.end())
+        {
+            it = f_checkpoints.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+
+
+} // namespace log
+} // namespace sitter
+// vim: ts=4 sw=4 et
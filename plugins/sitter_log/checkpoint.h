@@ -0,0 +1,70 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <map>
+#include    <set>
+#include    <string>
+
+
+// C
+//
+#include    <sys/types.h>
+
+
+
+namespace sitter
+{
+namespace log
+{
+
+
+
+struct checkpoint_t
+{
+    dev_t                       f_device = 0;
+    ino_t                       f_inode = 0;
+    off_t                       f_offset = 0;
+};
+
+
+class checkpoints
+{
+public:
+    typedef std::map<std::string, checkpoint_t>     checkpoint_map_t;
+
+    void                        load(std::string const & filename);
+    bool                        save();
+
+    bool                        has_checkpoint(std::string const & filename) const;
+    checkpoint_t &              get_checkpoint(std::string const & filename);
+    void                        keep_only(std::set<std::string> const & filenames);
+
+private:
+    std::string                 f_filename = std::string();
+    checkpoint_map_t            f_checkpoints = checkpoint_map_t();
+    std::string                 f_saved = std::string();
+};
+
+
+
+} // namespace log
+} // namespace sitter
+// vim: ts=4 sw=4 et
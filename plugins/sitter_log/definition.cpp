@@ -30,6 +30,7 @@
 // advgetopt
 //
 #include    <advgetopt/conf_file.h>
+#include    <advgetopt/validator_duration.h>
 #include    <advgetopt/validator_size.h>
 
 
@@ -153,6 +154,29 @@ void load_config(
         }
     }
 
+    // a definition with units or identifiers searches the journal
+    // instead of files
+    //
+    if(defs->has_parameter("unit"))
+    {
+        advgetopt::string_list_t units;
+        advgetopt::split_string(defs->get_parameter("unit"), units, { "," });
+        for(auto const & u : units)
+        {
+            wl.add_unit(u);
+        }
+    }
+
+    if(defs->has_parameter("identifier"))
+    {
+        advgetopt::string_list_t identifiers;
+        advgetopt::split_string(defs->get_parameter("identifier"), identifiers, { "," });
+        for(auto const & i : identifiers)
+        {
+            wl.add_identifier(i);
+        }
+    }
+
     if(defs->has_parameter("user_name"))
     {
         wl.set_user_name(defs->get_parameter("user_name"));
@@ -187,6 +211,28 @@ void load_config(
         wl.set_max_size(static_cast<std::size_t>(max_size));
     }
 
+    if(defs->has_parameter("max_age"))
+    {
+        std::string const max_age_str(defs->get_parameter("max_age"));
+        double max_age(0.0);
+        if(!advgetopt::validator_duration::convert_string(
+                      max_age_str
+                    , advgetopt::validator_duration::VALIDATOR_DURATION_DEFAULT_FLAGS
+                    , 1.0
+                    , max_age)
+        || max_age < 0.0)
+        {
+            throw invalid_parameter(
+                      "the \"max_age="
+                    + max_age_str
+                    + "\" found in log definition \""
+                    + log_definitions_filename
+                    + "\" is not considered a valid duration.");
+        }
+
+        wl.set_max_age(static_cast<time_t>(max_age));
+    }
+
     if(defs->has_parameter("mode"))
     {
         std::string const mode_str(snapdev::trim_string(
@@ -445,7 +491,14 @@ void load_config(
                 report_as = defs->get_parameter(field_name);
             }
 
-            search const s(regex, report_as);
+            bool urgent(false);
+            field_name = sec + "::urgent";
+            if(defs->has_parameter(field_name))
+            {
+                urgent = advgetopt::is_true(defs->get_parameter(field_name));
+            }
+
+            search const s(sec, regex, report_as, urgent);
             wl.add_search(s);
         }
     }
@@ -581,12 +634,30 @@ void definition::set_max_size(std::size_t size)
 }
 
 
+void definition::set_max_age(time_t age)
+{
+    f_max_age = age;
+}
+
+
 void definition::add_search(search const & s)
 {
     f_searches.push_back(s);
 }
 
 
+void definition::add_unit(std::string const & unit)
+{
+    f_units.push_back(unit);
+}
+
+
+void definition::add_identifier(std::string const & identifier)
+{
+    f_identifiers.push_back(identifier);
+}
+
+
 std::string const & definition::get_name() const
 {
     return f_name;
@@ -647,12 +718,37 @@ size_t definition::get_max_size() const
 }
 
 
+time_t definition::get_max_age() const
+{
+    return f_max_age;
+}
+
+
 search::vector_t definition::get_searches() const
 {
     return f_searches;
 }
 
 
+advgetopt::string_list_t const & definition::get_units() const
+{
+    return f_units;
+}
+
+
+advgetopt::string_list_t const & definition::get_identifiers() const
+{
+    return f_identifiers;
+}
+
+
+bool definition::is_journal() const
+{
+    return !f_units.empty()
+        || !f_identifiers.empty();
+}
+
+
 
 
 
@@ -41,6 +41,7 @@ public:
     typedef std::vector<definition>         vector_t;
 
     static constexpr size_t const           MAX_SIZE_UNDEFINED = 0;
+    static constexpr time_t const           MAX_AGE_UNDEFINED = 0;
 
                                 definition(std::string const & name, bool mandatory);
 
@@ -53,7 +54,10 @@ public:
     void                        set_mode_mask(int mode_mask);
     void                        add_pattern(std::string const & pattern);
     void                        set_max_size(std::size_t size);
+    void                        set_max_age(time_t age);
     void                        add_search(search const & s);
+    void                        add_unit(std::string const & unit);
+    void                        add_identifier(std::string const & identifier);
 
     std::string const &         get_name() const;
     bool                        is_mandatory() const;
@@ -66,7 +70,13 @@ public:
     advgetopt::string_list_t const &
                                 get_patterns() const;
     size_t                      get_max_size() const;
+    time_t                      get_max_age() const;
     search::vector_t            get_searches() const;
+    advgetopt::string_list_t const &
+                                get_units() const;
+    advgetopt::string_list_t const &
+                                get_identifiers() const;
+    bool                        is_journal() const;
 
 
 private:
@@ -74,11 +84,14 @@ private:
     std::string                 f_path          = std::string("/var/log");
     advgetopt::string_list_t    f_patterns      = { std::string("*.log") };
     std::size_t                 f_max_size      = MAX_SIZE_UNDEFINED;
+    time_t                      f_max_age       = MAX_AGE_UNDEFINED;
     uid_t                       f_uid           = -1;
     gid_t                       f_gid           = -1;
     int                         f_mode          = 0;
     int                         f_mode_mask     = 07777; // i.e. no masking
     search::vector_t            f_searches      = search::vector_t();
+    advgetopt::string_list_t    f_units         = advgetopt::string_list_t();
+    advgetopt::string_list_t    f_identifiers   = advgetopt::string_list_t();
     bool                        f_mandatory     = false;
     bool                        f_secure        = false;
     bool                        f_first_pattern = true;
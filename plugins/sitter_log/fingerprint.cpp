@@ -0,0 +1,381 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "fingerprint.h"
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// snapdev
+//
+#include    <snapdev/file_contents.h>
+
+
+// C++
+//
+#include    <sstream>
+
+
+// C
+//
+#include    <stdio.h>
+#include    <string.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+/** \file
+ * \brief This file implements the fingerprints of the rotated logs.
+ *
+ * A pattern such as `*.log*` matches the rotated logs too (`.1`, `.2.gz`,
+ * etc.) These files do not change anymore so once scanned, they are only
+ * stat()'ed and skipped as long as their device, inode, size, and
+ * modification time do not change.
+ *
+ * Each fingerprint also includes a hash of the first few kilobytes of
+ * the (uncompressed) content of the file. When logrotate renames a log
+ * or compresses it, the inode changes but the head of the content does
+ * not. The hash is used to find the number of bytes we already scanned
+ * under the previous name so only the remainder, if any, gets scanned.
+ *
+ * The fingerprints are saved in the sitter cache, one per line:
+ *
+ * \code
+ *     <hash> <device> <inode> <size> <mtime> <offset>
+ * \endcode
+ */
+
+
+
+namespace sitter
+{
+namespace log
+{
+
+
+
+namespace
+{
+
+
+
+bool ends_with(std::string const & s, std::string const & suffix)
+{
+    return s.length() >= suffix.length()
+        && s.compare(s.length() - suffix.length(), suffix.length(), suffix) == 0;
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Check how a log file is compressed.
+ *
+ * \param[in] filename  The name of the log file.
+ *
+ * \return The compression used, determined from the extension.
+ */
+compression_t get_compression(std::string const & filename)
+{
+    if(ends_with(filename, ".gz"))
+    {
+        return compression_t::COMPRESSION_GZIP;
+    }
+    for(auto const & ext : { ".bz2", ".lz4", ".lzma", ".xz", ".zst", ".Z" })
+    {
+        if(ends_with(filename, ext))
+        {
+            return compression_t::COMPRESSION_OTHER;
+        }
+    }
+    return compression_t::COMPRESSION_NONE;
+}
+
+
+/** \brief Check whether a file is a rotated log.
+ *
+ * Logs rotated by logrotate are compressed or their name ends with a
+ * number (i.e. "syslog.1") or a date (i.e. "syslog-20250102").
+ *
+ * \param[in] filename  The name of the log file.
+ *
+ * \return true if the file looks like a rotated log.
+ */
+bool is_rotated(std::string const & filename)
+{
+    if(get_compression(filename) != compression_t::COMPRESSION_NONE)
+    {
+        return true;
+    }
+
+    std::string::size_type const pos(filename.find_last_of("/.-"));
+    if(pos == std::string::npos
+    || filename[pos] == '/'
+    || pos + 1 == filename.length())
+    {
+        return false;
+    }
+    return filename.find_first_not_of("0123456789", pos + 1) == std::string::npos;
+}
+
+
+/** \brief Load the fingerprints.
+ *
+ * If the file does not exist yet, the list of fingerprints remains empty.
+ *
+ * \param[in] filename  The name of the file with the fingerprints.
+ *
+ * \return false if the file does not exist yet (first time the logs are
+ * checked).
+ */
+bool fingerprints::load(std::string const & filename)
+{
+    f_filename = filename;
+    f_fingerprints.clear();
+    f_seen.clear();
+    f_saved.clear();
+    f_last_save = 0;
+
+    struct stat st;
+    if(stat(f_filename.c_str(), &st) != 0)
+    {
+        return false;
+    }
+    f_last_save = st.st_mtime;
+
+    snapdev::file_contents in(f_filename);
+    if(!in.read_all())
+    {
+        return true;
+    }
+    f_saved = in.contents();
+
+    std::istringstream lines(f_saved);
+    std::string line;
+    while(std::getline(lines, line))
+    {
+        std::istringstream fields(line);
+        std::uint64_t hash(0);
+        std::uint64_t device(0);
+        std::uint64_t inode(0);
+        std::int64_t size(0);
+        std::int64_t mtime(0);
+        std::int64_t offset(0);
+        if(!(fields >> hash >> device >> inode >> size >> mtime >> offset)
+        || offset < 0)
+        {
+            continue;
+        }
+        fingerprint_t & fp(f_fingerprints[hash]);
+        fp.f_hash = hash;
+        fp.f_device = static_cast<dev_t>(device);
+        fp.f_inode = static_cast<ino_t>(inode);
+        fp.f_size = static_cast<off_t>(size);
+        fp.f_mtime = static_cast<time_t>(mtime);
+        fp.f_offset = static_cast<off_t>(offset);
+    }
+
+    return true;
+}
+
+
+/** \brief Save the fingerprints.
+ *
+ * The file is written only if something changed. It is first written
+ * in a temporary file which is then renamed so a crash never leaves a
+ * partial file behind.
+ *
+ * \return true if the fingerprints were saved or did not change.
+ */
+bool fingerprints::save()
+{
+    if(f_filename.empty())
+    {
+        return false;
+    }
+
+    std::stringstream ss;
+    for(auto const & f : f_fingerprints)
+    {
+        ss << f.first
+           << ' '
+           << static_cast<std::uint64_t>(f.second.f_device)
+           << ' '
+           << static_cast<std::uint64_t>(f.second.f_inode)
+           << ' '
+           << static_cast<std::int64_t>(f.second.f_size)
+           << ' '
+           << static_cast<std::int64_t>(f.second.f_mtime)
+           << ' '
+           << static_cast<std::int64_t>(f.second.f_offset)
+           << '\n';
+    }
+    std::string const contents(ss.str());
+    if(contents == f_saved)
+    {
+        f_last_save = time(nullptr);
+        return true;
+    }
+
+    std::string const tmp(f_filename + ".tmp");
+    snapdev::file_contents out(tmp);
+    out.contents(contents);
+    if(!out.write_all())
+    {
+        SNAP_LOG_ERROR
+            << "could not save the log fingerprints to \""
+            << tmp
+            << "\"."
+            << SNAP_LOG_SEND;
+        return false;
+    }
+    if(rename(tmp.c_str(), f_filename.c_str()) != 0)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not rename \""
+            << tmp
+            << "\" to \""
+            << f_filename
+            << "\" (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << ")."
+            << SNAP_LOG_SEND;
+        return false;
+    }
+
+    f_saved = contents;
+    f_last_save = time(nullptr);
+    return true;
+}
+
+
+/** \brief Get the time when the fingerprints were last saved.
+ *
+ * On startup, this is the modification time of the file. Afterward, it
+ * is the time of the last successful call to save(), which happens at
+ * the end of each tick.
+ *
+ * \return The time of the last save, 0 if never saved.
+ */
+time_t fingerprints::get_last_save() const
+{
+    return f_last_save;
+}
+
+
+/** \brief Search a fingerprint matching the stat() of a file.
+ *
+ * This is the fast path: a rotated file which was already scanned and
+ * did not change since is found without reading any of its content.
+ *
+ * \param[in] st  The stat() of the file.
+ * \param[out] fp  The fingerprint found.
+ *
+ * \return true if a fingerprint matches.
+ */
+bool fingerprints::find(struct stat const & st, fingerprint_t & fp) const
+{
+    for(auto const & f : f_fingerprints)
+    {
+        if(f.second.f_device == st.st_dev
+        && f.second.f_inode == st.st_ino
+        && f.second.f_size == st.st_size
+        && f.second.f_mtime == st.st_mtime)
+        {
+            fp = f.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/** \brief Search a fingerprint by hash.
+ *
+ * \param[in] hash  The hash of the head of the file.
+ * \param[out] fp  The fingerprint found.
+ *
+ * \return true if a fingerprint has that hash.
+ */
+bool fingerprints::find(std::uint64_t hash, fingerprint_t & fp) const
+{
+    auto const it(f_fingerprints.find(hash));
+    if(it == f_fingerprints.end())
+    {
+        return false;
+    }
+    fp = it->second;
+    return true;
+}
+
+
+/** \brief Save a fingerprint.
+ *
+ * The fingerprint replaces any existing fingerprint with the same hash
+ * and it is marked as seen on this tick.
+ *
+ * \param[in] fp  The fingerprint to save.
+ */
+void fingerprints::set(fingerprint_t const & fp)
+{
+    f_fingerprints[fp.f_hash] = fp;
+    f_seen.insert(fp.f_hash);
+}
+
+
+/** \brief Forget about the fingerprints which were not seen.
+ *
+ * This function removes the fingerprints of the files which were deleted
+ * and resets the list of fingerprints seen for the next tick.
+ */
+void fingerprints::keep_seen()
+{
+    for(auto it(f_fingerprints.begin()); it != f_fingerprints.end(); )
+    {
+        if(f_seen.find(it->first) == f_seen.end())
+        {
+            it = f_fingerprints.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    f_seen.clear();
+}
+
+
+
+} // namespace log
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,90 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <cstdint>
+#include    <map>
+#include    <set>
+#include    <string>
+
+
+// C
+//
+#include    <sys/stat.h>
+
+
+
+namespace sitter
+{
+namespace log
+{
+
+
+
+enum class compression_t
+{
+    COMPRESSION_NONE,
+    COMPRESSION_GZIP,
+    COMPRESSION_OTHER,
+};
+
+
+compression_t                   get_compression(std::string const & filename);
+bool                            is_rotated(std::string const & filename);
+
+
+struct fingerprint_t
+{
+    std::uint64_t               f_hash = 0;
+    dev_t                       f_device = 0;
+    ino_t                       f_inode = 0;
+    off_t                       f_size = 0;
+    time_t                      f_mtime = 0;
+    off_t                       f_offset = 0;       // uncompressed bytes already scanned
+};
+
+
+class fingerprints
+{
+public:
+    typedef std::map<std::uint64_t, fingerprint_t>  fingerprint_map_t;
+
+    bool                        load(std::string const & filename);
+    bool                        save();
+    time_t                      get_last_save() const;
+
+    bool                        find(struct stat const & st, fingerprint_t & fp) const;
+    bool                        find(std::uint64_t hash, fingerprint_t & fp) const;
+    void                        set(fingerprint_t const & fp);
+    void                        keep_seen();
+
+private:
+    std::string                 f_filename = std::string();
+    fingerprint_map_t           f_fingerprints = fingerprint_map_t();
+    std::set<std::uint64_t>     f_seen = std::set<std::uint64_t>();
+    std::string                 f_saved = std::string();
+    time_t                      f_last_save = 0;
+};
+
+
+
+} // namespace log
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,136 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "growth_tracker.h"
+
+
+// C++
+//
+#include    <cmath>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+/** \file
+ * \brief This file implements the tracking of the growth of the logs.
+ *
+ * Comparing the size of a log against its maximum size only tells us
+ * about the problem once it happened. A service which suddenly logs
+ * thousands of lines per second fills the disk long before the next
+ * logrotate. The tracker computes the rate at which each log grows
+ * between ticks so the log plugin can forecast when the log will reach
+ * its maximum size.
+ *
+ * The rate is smoothed with an exponential moving average so a single
+ * burst does not generate an error. The weight of the previous rate
+ * depends on the time elapsed since the previous sample so forced ticks
+ * do not change the smoothing. When a log shrinks (it was rotated or
+ * truncated), the sample is used as the new reference but the rate is
+ * kept since it describes the service writing to the log, not the file.
+ *
+ * No rate is returned until the log was tracked for MINIMUM_PERIOD so
+ * the first two samples, possibly a few seconds apart, do not generate
+ * a forecast on their own.
+ */
+
+
+
+namespace sitter
+{
+namespace log
+{
+
+
+
+/** \brief Add a sample of the size of a log.
+ *
+ * \param[in] filename  The name of the log file.
+ * \param[in] size  The current size of the log file.
+ * \param[in] now  The current time in microseconds (steady clock).
+ *
+ * \return The smoothed growth rate in bytes per second or -1.0 if not
+ * yet known (the log was not tracked for MINIMUM_PERIOD yet).
+ */
+double growth_tracker::add_sample(
+      std::string const & filename
+    , off_t size
+    , std::int64_t now)
+{
+    growth_t & g(f_growth[filename]);
+    g.f_seen = true;
+
+    if(g.f_time == 0)
+    {
+        g.f_first_time = now;
+    }
+    else if(now > g.f_time
+         && size >= g.f_size)
+    {
+        double const elapsed(static_cast<double>(now - g.f_time) / 1'000'000.0);
+        double const rate(static_cast<double>(size - g.f_size) / elapsed);
+        if(g.f_rate < 0.0)
+        {
+            g.f_rate = rate;
+        }
+        else
+        {
+            g.f_rate += (rate - g.f_rate) * (1.0 - std::exp(-elapsed / RATE_PERIOD));
+        }
+    }
+
+    g.f_size = size;
+    g.f_time = now;
+
+    if(now - g.f_first_time < MINIMUM_PERIOD)
+    {
+        return -1.0;
+    }
+    return g.f_rate;
+}
+
+
+/** \brief Forget about the logs which were not sampled on this tick.
+ */
+void growth_tracker::end_tick()
+{
+    for(auto it(f_growth.begin()); it != f_growth.end(); )
+    {
+        if(it->second.f_seen)
+        {
+            it->second.f_seen = false;
+            ++it;
+        }
+        else
+        {
+            it = f_growth.erase(it);
+        }
+    }
+}
+
+
+
+} // namespace log
+} // namespace sitter
+// vim: ts=4 sw=4 et
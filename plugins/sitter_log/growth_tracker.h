@@ -0,0 +1,70 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <cstdint>
+#include    <map>
+#include    <string>
+
+
+// C
+//
+#include    <sys/types.h>
+
+
+
+namespace sitter
+{
+namespace log
+{
+
+
+
+class growth_tracker
+{
+public:
+    static constexpr double const       RATE_PERIOD = 3.0 * 60.0;               // the weight of a rate is divided by e every 3 minutes
+    static constexpr std::int64_t const MINIMUM_PERIOD = 10LL * 60LL * 1'000'000LL; // 10 minutes in microseconds
+
+    double                      add_sample(
+                                      std::string const & filename
+                                    , off_t size
+                                    , std::int64_t now);
+    void                        end_tick();
+
+private:
+    struct growth_t
+    {
+        off_t                   f_size = 0;
+        std::int64_t            f_time = 0;         // microseconds
+        std::int64_t            f_first_time = 0;   // microseconds
+        double                  f_rate = -1.0;      // bytes per second, -1 when unknown
+        bool                    f_seen = false;
+    };
+    typedef std::map<std::string, growth_t>     growth_map_t;
+
+    growth_map_t                f_growth = growth_map_t();
+};
+
+
+
+} // namespace log
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,426 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "journal_reader.h"
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// snapdev
+//
+#include    <snapdev/file_contents.h>
+
+
+// C++
+//
+#include    <sstream>
+
+
+// C
+//
+#include    <stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <systemd/sd-journal.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+/** \file
+ * \brief This file implements the reading of the systemd journal.
+ *
+ * Many services only log to journald. A log definition with a unit=
+ * or an identifier= parameter is searched in the journal instead of
+ * files.
+ *
+ * The journal is kept open between ticks. The units and identifiers are
+ * added as matches so the journal library only returns the entries of
+ * interest and only the MESSAGE field of those entries gets decoded.
+ *
+ * The position reached in the journal is saved as a cursor per log
+ * definition in the sitter cache so a restart does not search the same
+ * entries again. A definition seen for the first time starts at the
+ * current end of the journal. The cursors of definitions which were
+ * removed are dropped.
+ *
+ * The cursors are saved one per line:
+ *
+ * \code
+ *     <cursor> <definition name>
+ * \endcode
+ */
+
+
+
+namespace sitter
+{
+namespace log
+{
+
+
+
+journal_reader::journal_reader()
+{
+}
+
+
+journal_reader::~journal_reader()
+{
+    if(f_journal != nullptr)
+    {
+        sd_journal_close(f_journal);
+    }
+}
+
+
+/** \brief Load the cursors.
+ *
+ * If the file does not exist yet, the list of cursors remains empty.
+ *
+ * \param[in] filename  The name of the file with the cursors.
+ */
+void journal_reader::load_cursors(std::string const & filename)
+{
+    f_filename = filename;
+    f_cursors.clear();
+    f_saved.clear();
+
+    snapdev::file_contents in(f_filename);
+    if(!in.read_all())
+    {
+        return;
+    }
+    f_saved = in.contents();
+
+    std::istringstream lines(f_saved);
+    std::string line;
+    while(std::getline(lines, line))
+    {
+        std::string::size_type const pos(line.find(' '));
+        if(pos == std::string::npos
+        || pos == 0
+        || pos + 1 >= line.length())
+        {
+            continue;
+        }
+        f_cursors[line.substr(pos + 1)] = line.substr(0, pos);
+    }
+}
+
+
+/** \brief Save the cursors.
+ *
+ * The file is written only if something changed. It is first written
+ * in a temporary file which is then renamed so a crash never leaves a
+ * partial file behind.
+ *
+ * \return true if the cursors were saved or did not change.
+ */
+bool journal_reader::save_cursors()
+{
+    if(f_filename.empty())
+    {
+        return false;
+    }
+
+    std::stringstream ss;
+    for(auto const & c : f_cursors)
+    {
+        ss << c.second
+           << ' '
+           << c.first
+           << '\n';
+    }
+    std::string const contents(ss.str());
+    if(contents == f_saved)
+    {
+        return true;
+    }
+
+    std::string const tmp(f_filename + ".tmp");
+    snapdev::file_contents out(tmp);
+    out.contents(contents);
+    if(!out.write_all())
+    {
+        SNAP_LOG_ERROR
+            << "could not save the journal cursors to \""
+            << tmp
+            << "\"."
+            << SNAP_LOG_SEND;
+        return false;
+    }
+    if(rename(tmp.c_str(), f_filename.c_str()) != 0)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not rename \""
+            << tmp
+            << "\" to \""
+            << f_filename
+            << "\" (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << ")."
+            << SNAP_LOG_SEND;
+        return false;
+    }
+
+    f_saved = contents;
+    return true;
+}
+
+
+/** \brief Forget about the cursors of removed definitions.
+ *
+ * \param[in] names  The names of the journal definitions found on this
+ * tick.
+ */
+void journal_reader::keep_only(std::set<std::string> const & names)
+{
+    for(auto it(f_cursors.begin()); it != f_cursors.end(); )
+    {
+        if(names.find(it->first) == names.end())
+        {
+            it = f_cursors.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+
+/** \brief Read the new journal entries of a log definition.
+ *
+ * This function reads the entries added to the journal since the last
+ * call for the units and identifiers of \p def and calls \p callback
+ * with the message of each entry.
+ *
+ * At most MAXIMUM_ENTRIES are read per call; the remaining entries are
+ * read on the next tick.
+ *
+ * \param[in] def  The log definition.
+ * \param[in] callback  The function called with each message.
+ *
+ * \return true if the journal could be read.
+ */
+bool journal_reader::read(
+      definition const & def
+    , message_callback_t callback)
+{
+    f_count = 0;
+    f_error = 0;
+
+    if(!open()
+    || !add_matches(def))
+    {
+        return false;
+    }
+
+    std::string & cursor(f_cursors[def.get_name()]);
+    if(cursor.empty())
+    {
+        // first time, only the entries written from now on are of interest
+        //
+        f_error = -sd_journal_seek_tail(f_journal);
+        if(f_error != 0)
+        {
+            return false;
+        }
+        if(sd_journal_previous(f_journal) <= 0)
+        {
+            // no entries for this definition yet
+            //
+            return true;
+        }
+    }
+    else
+    {
+        f_error = -sd_journal_seek_cursor(f_journal, cursor.c_str());
+        if(f_error != 0)
+        {
+            return false;
+        }
+
+        // the seek positions us on the entry of the cursor, which we
+        // already processed, or the closest entry if it was vacuumed
+        //
+        if(sd_journal_next(f_journal) > 0
+        && sd_journal_test_cursor(f_journal, cursor.c_str()) <= 0)
+        {
+            sd_journal_previous(f_journal);
+        }
+    }
+
+    bool found(false);
+    while(f_count < MAXIMUM_ENTRIES)
+    {
+        int const r(sd_journal_next(f_journal));
+        if(r < 0)
+        {
+            f_error = -r;
+            break;
+        }
+        if(r == 0)
+        {
+            break;
+        }
+        found = true;
+        ++f_count;
+
+        void const * data(nullptr);
+        std::size_t length(0);
+        if(sd_journal_get_data(f_journal, "MESSAGE", &data, &length) >= 0
+        && length > 8)
+        {
+            // skip the "MESSAGE=" prefix
+            //
+            callback(static_cast<char const *>(data) + 8, length - 8);
+        }
+    }
+
+    if(found
+    || cursor.empty())
+    {
+        char * c(nullptr);
+        if(sd_journal_get_cursor(f_journal, &c) >= 0
+        && c != nullptr)
+        {
+            cursor = c;
+            free(c);
+        }
+    }
+
+    return f_error == 0;
+}
+
+
+/** \brief Get the number of entries read by the last call to read().
+ *
+ * \return The number of entries.
+ */
+std::size_t journal_reader::get_count() const
+{
+    return f_count;
+}
+
+
+/** \brief Get the error of the last call to read().
+ *
+ * \return The errno of the last read which failed, 0 otherwise.
+ */
+int journal_reader::get_error() const
+{
+    return f_error;
+}
+
+
+/** \brief Open the journal.
+ *
+ * The journal is opened the first time and then kept open.
+ *
+ * \return true if the journal is open.
+ */
+bool journal_reader::open()
+{
+    if(f_journal != nullptr)
+    {
+        return true;
+    }
+
+    int const r(sd_journal_open(&f_journal, SD_JOURNAL_LOCAL_ONLY | SD_JOURNAL_SYSTEM));
+    if(r < 0)
+    {
+        f_journal = nullptr;
+        f_error = -r;
+        return false;
+    }
+
+    // we only need the beginning of the messages
+    //
+    sd_journal_set_data_threshold(f_journal, MAXIMUM_MESSAGE_LENGTH);
+
+    return true;
+}
+
+
+/** \brief Restrict the journal to the entries of a definition.
+ *
+ * The units and the identifiers are added as matches. Matches on the
+ * same field are OR'ed by the journal. The conjunction between the two
+ * groups makes an entry match one of the units and one of the
+ * identifiers.
+ *
+ * \param[in] def  The log definition.
+ *
+ * \return true if the matches were added.
+ */
+bool journal_reader::add_matches(definition const & def)
+{
+    sd_journal_flush_matches(f_journal);
+
+    auto add = [this](std::string const & field, advgetopt::string_list_t const & values, bool unit)
+        {
+            for(auto const & v : values)
+            {
+                // a unit without a type is a service
+                //
+                std::string const match(
+                          field
+                        + "="
+                        + v
+                        + (unit && v.find('.') == std::string::npos ? ".service" : ""));
+                int const r(sd_journal_add_match(f_journal, match.c_str(), match.length()));
+                if(r < 0)
+                {
+                    f_error = -r;
+                    return false;
+                }
+            }
+            return true;
+        };
+
+    if(!add("_SYSTEMD_UNIT", def.get_units(), true))
+    {
+        return false;
+    }
+    if(!def.get_units().empty()
+    && !def.get_identifiers().empty())
+    {
+        sd_journal_add_conjunction(f_journal);
+    }
+    return add("SYSLOG_IDENTIFIER", def.get_identifiers(), false);
+}
+
+
+
+} // namespace log
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,84 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    "definition.h"
+
+
+// C++
+//
+#include    <functional>
+#include    <map>
+#include    <set>
+#include    <string>
+
+
+
+struct sd_journal;
+
+namespace sitter
+{
+namespace log
+{
+
+
+
+class journal_reader
+{
+public:
+    typedef std::function<void(char const * message, std::size_t size)>
+                                message_callback_t;
+
+    static constexpr std::size_t const  MAXIMUM_MESSAGE_LENGTH = 4096;
+    static constexpr std::size_t const  MAXIMUM_ENTRIES = 100'000;
+
+                                journal_reader();
+                                journal_reader(journal_reader const &) = delete;
+                                ~journal_reader();
+    journal_reader &            operator = (journal_reader const &) = delete;
+
+    void                        load_cursors(std::string const & filename);
+    bool                        save_cursors();
+    void                        keep_only(std::set<std::string> const & names);
+
+    bool                        read(
+                                      definition const & def
+                                    , message_callback_t callback);
+    std::size_t                 get_count() const;
+    int                         get_error() const;
+
+private:
+    bool                        open();
+    bool                        add_matches(definition const & def);
+
+    sd_journal *                f_journal = nullptr;
+    std::string                 f_filename = std::string();
+    std::map<std::string, std::string>
+                                f_cursors = std::map<std::string, std::string>();
+    std::string                 f_saved = std::string();
+    std::size_t                 f_count = 0;
+    int                         f_error = 0;
+};
+
+
+
+} // namespace log
+} // namespace sitter
+// vim: ts=4 sw=4 et
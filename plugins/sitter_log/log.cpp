@@ -20,12 +20,19 @@
 // self
 //
 #include    "./log.h"
+#include    "names.h"
 
 
 
 // sitter
 //
 #include    <sitter/exception.h>
+#include    <sitter/monotonic_clock.h>
+
+
+// advgetopt
+//
+#include    <advgetopt/utils.h>
 
 
 // snaplogger
@@ -50,6 +57,8 @@
 
 // C
 //
+#include    <fcntl.h>
+#include    <string.h>
 #include    <sys/stat.h>
 
 
@@ -74,6 +83,56 @@ SERVERPLUGINS_END(log)
 
 
 
+namespace
+{
+
+
+
+constexpr double const          GROWTH_URGENT_HORIZON = 60.0 * 60.0;            // 1 hour
+constexpr double const          GROWTH_WARNING_HORIZON = 24.0 * 60.0 * 60.0;    // 1 day
+
+
+/** \brief Get the time of the oldest data of a log file.
+ *
+ * For a rotated log, this is the creation time of the file, if the file
+ * system saves it, or its modification time, whichever is the oldest.
+ * The modification time can be older when the file was compressed (gzip
+ * copies the modification time of the original file).
+ *
+ * For the active log, only the modification time is used. A log rotated
+ * with the logrotate copytruncate option keeps its creation time
+ * forever even though its contents are fresh.
+ *
+ * \param[in] filename  The name of the log file.
+ * \param[in] st  The stat() of the log file.
+ * \param[in] rotated  Whether \p filename is a rotated log.
+ *
+ * \return The time of the oldest data in the log file.
+ */
+time_t oldest_time(std::string const & filename, struct stat const & st, bool rotated)
+{
+    time_t result(st.st_mtime);
+    if(!rotated)
+    {
+        return result;
+    }
+
+    struct statx stx = {};
+    if(statx(AT_FDCWD, filename.c_str(), 0, STATX_BTIME, &stx) == 0
+    && (stx.stx_mask & STATX_BTIME) != 0
+    && stx.stx_btime.tv_sec < result)
+    {
+        result = stx.stx_btime.tv_sec;
+    }
+
+    return result;
+}
+
+
+} // no name namespace
+
+
+
 
 /** \brief Initialize log.
  *
@@ -102,12 +161,47 @@ void log::on_process_watch(as2js::json::json_value_ref & json)
 
     as2js::json::json_value_ref e(json["logs"]);
 
+    if(!f_checkpoints_loaded)
+    {
+        f_checkpoints_loaded = true;
+        f_checkpoints.load(plugins()->get_server<sitter::server>()->get_cache_path("log_checkpoints.txt"));
+        f_first_sight = !f_fingerprints.load(plugins()->get_server<sitter::server>()->get_cache_path("log_fingerprints.txt"));
+        f_journal.load_cursors(plugins()->get_server<sitter::server>()->get_cache_path("log_journal_cursors.txt"));
+    }
+    f_scanned_logs.clear();
+
+    // the real-time watcher searches the urgent patterns between ticks
+    //
+    sitter::server::pointer_t server(plugins()->get_server<sitter::server>());
+    if(advgetopt::is_true(server->get_server_parameter(g_name_log_realtime)))
+    {
+        if(f_realtime == nullptr)
+        {
+            f_realtime = std::make_shared<realtime_logs>(server.get());
+        }
+        f_realtime->set_definitions(
+                  log_defs
+                , server->get_integer_parameter(g_name_log_debounce, log_watcher::DEFAULT_DEBOUNCE));
+    }
+    else
+    {
+        f_realtime.reset();
+    }
+
     // check each log
     //
+    std::set<std::string> journal_names;
     size_t const max_logs(log_defs.size());
     for(size_t idx(0); idx < max_logs; ++idx)
     {
         definition const & def(log_defs[idx]);
+        if(def.is_journal())
+        {
+            journal_names.insert(def.get_name());
+            check_journal(def, e);
+            continue;
+        }
+
         std::string const & path(def.get_path());
         advgetopt::string_list_t const & patterns(def.get_patterns());
         f_found = false;
@@ -134,6 +228,17 @@ void log::on_process_watch(as2js::json::json_value_ref & json)
                 , 85); // priority
         }
     }
+
+    // forget about the logs which disappeared and save the new offsets
+    //
+    f_checkpoints.keep_only(f_scanned_logs);
+    f_checkpoints.save();
+    f_fingerprints.keep_seen();
+    f_fingerprints.save();
+    f_first_sight = false;
+    f_growth.end_tick();
+    f_journal.keep_only(journal_names);
+    f_journal.save_cursors();
 }
 
 
@@ -152,6 +257,23 @@ void log::check_log(
         //
         f_found = true;
 
+        bool const rotated(is_rotated(filename));
+        time_t const max_age(def.get_max_age());
+        time_t const age(time(nullptr) - oldest_time(filename, st, rotated));
+        bool const too_old(max_age != definition::MAX_AGE_UNDEFINED && age > max_age);
+
+        // a rotated log which did not change since we last checked it
+        // does not need to be checked again
+        //
+        fingerprint_t fp;
+        if(rotated
+        && !too_old
+        && f_fingerprints.find(st, fp))
+        {
+            f_fingerprints.set(fp);
+            return;
+        }
+
         as2js::json::json_value_ref l(json["log"]);
 
         l["name"] = def.get_name();
@@ -162,7 +284,31 @@ void log::check_log(
         l["gid"] = st.st_gid;
         l["mtime"] = st.st_mtime; // we could look into showing the timespec instead?
 
-        if(static_cast<size_t>(st.st_size) > def.get_max_size())
+        l["age"] = age;
+
+        if(too_old)
+        {
+            // the policy says data this old must be deleted
+            //
+            std::string const err_msg(
+                      "log file "
+                    + def.get_name()
+                    + " ("
+                    + filename
+                    + ") includes data from "
+                    + std::to_string(age / 86400)
+                    + " days ago, which is more than the maximum age of "
+                    + std::to_string(max_age / 86400)
+                    + " days");
+            plugins()->get_server<sitter::server>()->append_error(
+                  l
+                , "log"
+                , err_msg
+                , def.is_secure() ? 55 : 45); // priority
+        }
+
+        if(def.get_max_size() != definition::MAX_SIZE_UNDEFINED
+        && static_cast<size_t>(st.st_size) > def.get_max_size())
         {
             // file is too big, generate an error about it!
             //
@@ -182,6 +328,43 @@ void log::check_log(
                 , static_cast<size_t>(st.st_size) > def.get_max_size() * 2 ? 73 : 58); // priority
         }
 
+        if(!rotated
+        && def.get_max_size() != definition::MAX_SIZE_UNDEFINED)
+        {
+            // forecast when the log will reach its maximum size so a
+            // runaway service gets noticed before it fills the disk
+            //
+            double const rate(f_growth.add_sample(filename, st.st_size, monotonic_usec()));
+            if(rate > 0.0)
+            {
+                l["growth_rate"] = rate;
+                double const left(static_cast<double>(def.get_max_size()) - static_cast<double>(st.st_size));
+                double const full_in(left / rate);
+                if(left > 0.0
+                && full_in < GROWTH_WARNING_HORIZON)
+                {
+                    l["full_in"] = full_in;
+                    std::string const err_msg(
+                              "log file "
+                            + def.get_name()
+                            + " ("
+                            + filename
+                            + ") grows by "
+                            + std::to_string(static_cast<std::int64_t>(rate))
+                            + " bytes per second and will reach its maximum size of "
+                            + std::to_string(def.get_max_size())
+                            + " in "
+                            + std::to_string(static_cast<std::int64_t>(full_in / 60.0))
+                            + " minutes");
+                    plugins()->get_server<sitter::server>()->append_error(
+                          l
+                        , "log"
+                        , err_msg
+                        , full_in < GROWTH_URGENT_HORIZON ? 65 : 40); // priority
+                }
+            }
+        }
+
         uid_t const uid(def.get_uid());
         if(uid != snapdev::NO_UID
         && uid != st.st_uid)
@@ -249,7 +432,14 @@ void log::check_log(
                 , 64); // priority
         }
 
-        // TODO: do the searches if we have some regex defined
+        if(rotated)
+        {
+            search_rotated_log(filename, def, json, l, st);
+        }
+        else
+        {
+            search_log(filename, def, json, l, st);
+        }
     }
     else
     {
@@ -259,6 +449,426 @@ void log::check_log(
 
 
 
+/** \brief Get the search engine of a log definition.
+ *
+ * The engine is compiled the first time and kept for the following
+ * ticks. A regular expression which does not compile generates an error.
+ *
+ * \param[in] def  The definition of the log file.
+ * \param[in] json  The "logs" object where errors are added.
+ *
+ * \return The search engine or nullptr if the definition has no searches.
+ */
+search_engine * log::get_engine(
+      definition const & def
+    , as2js::json::json_value_ref & json)
+{
+    search::vector_t const searches(def.get_searches());
+    if(searches.empty())
+    {
+        return nullptr;
+    }
+
+    search_engine & engine(f_engines[def.get_name()]);
+    engine.compile(searches);
+    for(std::size_t idx(0); idx < engine.size(); ++idx)
+    {
+        if(!engine.get_error(idx).empty())
+        {
+            plugins()->get_server<sitter::server>()->append_error(
+                  json
+                , "log"
+                , "invalid regular expression \""
+                    + engine.get_search(idx).get_regex()
+                    + "\" in log definition "
+                    + def.get_name()
+                    + ": "
+                    + engine.get_error(idx)
+                , 20);
+        }
+    }
+
+    return &engine;
+}
+
+
+/** \brief Search the new lines of a log file.
+ *
+ * This function scans the lines added to the log file since the last
+ * tick and searches them using the regular expressions of the
+ * definition. Each search which matches at least one line generates
+ * an error (or a warning, depending on its report_as parameter).
+ *
+ * The fingerprint of the file is updated with the offset reached so
+ * once the file gets rotated, only the lines written after this scan
+ * need to be searched.
+ *
+ * \param[in] filename  The name of the log file.
+ * \param[in] def  The definition of the log file.
+ * \param[in] json  The "logs" object where errors are added.
+ * \param[in] l  The object of the log file in the JSON data.
+ * \param[in] st  The stat() of the log file.
+ */
+void log::search_log(
+      std::string const & filename
+    , definition const & def
+    , as2js::json::json_value_ref & json
+    , as2js::json::json_value_ref & l
+    , struct stat const & st)
+{
+    search_engine * engine(get_engine(def, json));
+    if(engine == nullptr)
+    {
+        return;
+    }
+
+    f_scanned_logs.insert(filename);
+    bool const known(f_checkpoints.has_checkpoint(filename));
+    checkpoint_t & cp(f_checkpoints.get_checkpoint(filename));
+
+    engine->reset_matches();
+    scan_status_t const status(f_scanner.scan(
+          filename
+        , cp
+        , known
+        , [engine](char const * block, std::size_t size)
+        {
+            engine->search_block(block, size);
+        }));
+
+    if(!report_matches(status, filename, def, json, l, cp.f_offset, *engine)
+    || st.st_size < static_cast<off_t>(log_scanner::HEAD_SIZE))
+    {
+        // the head of a small file still changes, wait before saving
+        // its fingerprint
+        //
+        return;
+    }
+
+    fingerprint_t fp;
+    if(!f_fingerprints.find(st, fp))
+    {
+        if(!f_scanner.head_hash(filename, false, fp.f_hash))
+        {
+            return;
+        }
+        fp.f_device = st.st_dev;
+        fp.f_inode = st.st_ino;
+        fp.f_size = st.st_size;
+        fp.f_mtime = st.st_mtime;
+    }
+    fp.f_offset = cp.f_offset;
+    f_fingerprints.set(fp);
+}
+
+
+/** \brief Search a rotated log file.
+ *
+ * A rotated log file (i.e. "syslog.1" or "syslog.2.gz") was, in most
+ * cases, already scanned under its previous name. The hash of its head
+ * is used to find the fingerprint saved at the time and only the data
+ * after the offset reached then gets scanned. A file compressed with
+ * gzip is decompressed in memory.
+ *
+ * A rotated file without a known fingerprint is only searched if it was
+ * modified since the last tick. The first time the logs get checked (no
+ * fingerprints saved yet), the rotated files are recorded as already
+ * scanned so the old data does not generate a flood of errors.
+ *
+ * Files compressed with other tools are not searched.
+ *
+ * \param[in] filename  The name of the log file.
+ * \param[in] def  The definition of the log file.
+ * \param[in] json  The "logs" object where errors are added.
+ * \param[in] l  The object of the log file in the JSON data.
+ * \param[in] st  The stat() of the log file.
+ */
+void log::search_rotated_log(
+      std::string const & filename
+    , definition const & def
+    , as2js::json::json_value_ref & json
+    , as2js::json::json_value_ref & l
+    , struct stat const & st)
+{
+    compression_t const compression(get_compression(filename));
+
+    fingerprint_t fp;
+    fp.f_device = st.st_dev;
+    fp.f_inode = st.st_ino;
+    fp.f_size = st.st_size;
+    fp.f_mtime = st.st_mtime;
+    if(compression == compression_t::COMPRESSION_OTHER)
+    {
+        // we cannot read this file, use a hash of its stat() so we
+        // still skip it on the following ticks
+        //
+        fp.f_hash = (static_cast<std::uint64_t>(st.st_dev) << 32)
+                  ^ static_cast<std::uint64_t>(st.st_ino)
+                  ^ (static_cast<std::uint64_t>(st.st_size) << 16);
+        f_fingerprints.set(fp);
+        return;
+    }
+
+    bool const compressed(compression == compression_t::COMPRESSION_GZIP);
+    if(!f_scanner.head_hash(filename, compressed, fp.f_hash))
+    {
+        if(f_scanner.get_error() != 0)
+        {
+            plugins()->get_server<sitter::server>()->append_error(
+                  json
+                , "log"
+                , "could not read log file "
+                    + def.get_name()
+                    + " ("
+                    + filename
+                    + "): "
+                    + strerror(f_scanner.get_error())
+                , 30);
+        }
+        return;
+    }
+
+    fingerprint_t previous;
+    if(f_fingerprints.find(fp.f_hash, previous))
+    {
+        fp.f_offset = previous.f_offset;
+    }
+    else if(f_first_sight
+         || st.st_mtime < f_fingerprints.get_last_save())
+    {
+        // this is the first time we check these logs or this file was not
+        // written to since the last tick so it did not just rotate; do not
+        // search old data, only record it as scanned
+        //
+        std::uint32_t size(0);
+        if(!compressed)
+        {
+            fp.f_offset = st.st_size;
+        }
+        else if(log_scanner::compressed_size(filename, size))
+        {
+            fp.f_offset = size;
+        }
+        f_fingerprints.set(fp);
+        return;
+    }
+
+    search_engine * engine(get_engine(def, json));
+    if(engine == nullptr)
+    {
+        fp.f_offset = compressed ? fp.f_offset : st.st_size;
+        f_fingerprints.set(fp);
+        return;
+    }
+
+    l["rotated_file"] = true;
+    engine->reset_matches();
+    auto callback([engine](char const * block, std::size_t size)
+        {
+            engine->search_block(block, size);
+        });
+
+    scan_status_t status(scan_status_t::SCAN_STATUS_SCANNED);
+    if(compressed)
+    {
+        l["compressed"] = true;
+        std::uint32_t size(0);
+        if(fp.f_offset == 0
+        || !log_scanner::compressed_size(filename, size)
+        || size != static_cast<std::uint32_t>(fp.f_offset))
+        {
+            status = f_scanner.scan_compressed(filename, fp.f_offset, callback);
+        }
+    }
+    else
+    {
+        checkpoint_t cp;
+        cp.f_device = st.st_dev;
+        cp.f_inode = st.st_ino;
+        cp.f_offset = fp.f_offset;
+        status = f_scanner.scan(filename, cp, true, callback);
+        fp.f_offset = cp.f_offset;
+    }
+
+    if(report_matches(status, filename, def, json, l, fp.f_offset, *engine))
+    {
+        f_fingerprints.set(fp);
+    }
+}
+
+
+/** \brief Report the results of a scan.
+ *
+ * \param[in] status  The status returned by the scanner.
+ * \param[in] filename  The name of the log file.
+ * \param[in] def  The definition of the log file.
+ * \param[in] json  The "logs" object where errors are added.
+ * \param[in] l  The object of the log file in the JSON data.
+ * \param[in] offset  The offset reached by the scan.
+ * \param[in] engine  The engine with the matches.
+ *
+ * \return false if the scan failed.
+ */
+bool log::report_matches(
+      scan_status_t status
+    , std::string const & filename
+    , definition const & def
+    , as2js::json::json_value_ref & json
+    , as2js::json::json_value_ref & l
+    , off_t offset
+    , search_engine const & engine)
+{
+    sitter::server::pointer_t server(plugins()->get_server<sitter::server>());
+
+    switch(status)
+    {
+    case scan_status_t::SCAN_STATUS_SCANNED:
+        break;
+
+    case scan_status_t::SCAN_STATUS_ROTATED:
+        l["rotated"] = true;
+        break;
+
+    case scan_status_t::SCAN_STATUS_TRUNCATED:
+        l["truncated"] = true;
+        break;
+
+    case scan_status_t::SCAN_STATUS_FAILED:
+    default:
+        server->append_error(
+              json
+            , "log"
+            , "could not read log file "
+                + def.get_name()
+                + " ("
+                + filename
+                + "): "
+                + strerror(f_scanner.get_error())
+            , 30);
+        return false;
+
+    }
+
+    l["scanned"] = f_scanner.get_scanned();
+    l["offset"] = static_cast<std::int64_t>(offset);
+
+    report_found(filename, def, json, l, engine);
+
+    return true;
+}
+
+
+
+/** \brief Report the searches which matched.
+ *
+ * Each search which matched at least one line generates an error (or
+ * a warning, depending on its report_as parameter).
+ *
+ * \param[in] source  The name of the log file or the journal units.
+ * \param[in] def  The definition of the log file.
+ * \param[in] json  The "logs" object where errors are added.
+ * \param[in] l  The object of the log file in the JSON data.
+ * \param[in] engine  The engine with the matches.
+ */
+void log::report_found(
+      std::string const & source
+    , definition const & def
+    , as2js::json::json_value_ref & json
+    , as2js::json::json_value_ref & l
+    , search_engine const & engine)
+{
+    for(std::size_t idx(0); idx < engine.size(); ++idx)
+    {
+        search_engine::match_t const & match(engine.get_matches()[idx]);
+        if(match.f_count == 0)
+        {
+            continue;
+        }
+
+        as2js::json::json_value_ref m(l["match"][-1]);
+        m["name"] = engine.get_search(idx).get_name();
+        m["count"] = match.f_count;
+        m["line"] = match.f_first_line;
+
+        bool const is_error(engine.get_search(idx).is_error());
+        plugins()->get_server<sitter::server>()->append_error(
+              json
+            , "log"
+            , "found "
+                + std::to_string(match.f_count)
+                + " line(s) matching \""
+                + engine.get_search(idx).get_name()
+                + "\" in log file "
+                + def.get_name()
+                + " ("
+                + source
+                + "), first: "
+                + match.f_first_line
+            , is_error
+                ? (def.is_secure() ? 80 : 70)
+                : (def.is_secure() ? 45 : 35));
+    }
+}
+
+
+/** \brief Search the new entries of the journal.
+ *
+ * A log definition with units or identifiers is searched in the systemd
+ * journal. Only the entries added since the previous tick are read.
+ *
+ * \param[in] def  The definition of the log.
+ * \param[in] json  The "logs" object where errors are added.
+ */
+void log::check_journal(
+      definition const & def
+    , as2js::json::json_value_ref & json)
+{
+    search_engine * engine(get_engine(def, json));
+    if(engine == nullptr)
+    {
+        return;
+    }
+
+    std::string source("journal:");
+    for(auto const & u : def.get_units())
+    {
+        source += " " + u;
+    }
+    for(auto const & i : def.get_identifiers())
+    {
+        source += " " + i;
+    }
+
+    as2js::json::json_value_ref l(json["journal"][-1]);
+    l["name"] = def.get_name();
+    l["source"] = source;
+
+    engine->reset_matches();
+    if(!f_journal.read(
+          def
+        , [engine](char const * message, std::size_t size)
+        {
+            engine->search_block(message, size);
+        }))
+    {
+        plugins()->get_server<sitter::server>()->append_error(
+              json
+            , "log"
+            , "could not read the journal for log definition "
+                + def.get_name()
+                + ": "
+                + strerror(f_journal.get_error())
+            , 30);
+        return;
+    }
+
+    l["entries"] = static_cast<std::int64_t>(f_journal.get_count());
+
+    report_found(source, def, json, l, *engine);
+}
+
+
+
 } // namespace log
 } // namespace sitter
 // vim: ts=4 sw=4 et
@@ -19,7 +19,14 @@
 
 // sitter
 //
+#include    <checkpoint.h>
 #include    <definition.h>
+#include    <fingerprint.h>
+#include    <growth_tracker.h>
+#include    <journal_reader.h>
+#include    <log_scanner.h>
+#include    <log_watcher.h>
+#include    <search_engine.h>
 
 
 // sitter
@@ -32,6 +39,12 @@
 #include    <serverplugins/plugin.h>
 
 
+// C++
+//
+#include    <map>
+#include    <set>
+
+
 
 namespace sitter
 {
@@ -61,8 +74,53 @@ private:
                             , std::string filename
                             , definition const & def
                             , as2js::json::json_value_ref & json);
+    search_engine *     get_engine(
+                              definition const & def
+                            , as2js::json::json_value_ref & json);
+    void                search_log(
+                              std::string const & filename
+                            , definition const & def
+                            , as2js::json::json_value_ref & json
+                            , as2js::json::json_value_ref & l
+                            , struct stat const & st);
+    void                search_rotated_log(
+                              std::string const & filename
+                            , definition const & def
+                            , as2js::json::json_value_ref & json
+                            , as2js::json::json_value_ref & l
+                            , struct stat const & st);
+    bool                report_matches(
+                              scan_status_t status
+                            , std::string const & filename
+                            , definition const & def
+                            , as2js::json::json_value_ref & json
+                            , as2js::json::json_value_ref & l
+                            , off_t offset
+                            , search_engine const & engine);
+    void                report_found(
+                              std::string const & source
+                            , definition const & def
+                            , as2js::json::json_value_ref & json
+                            , as2js::json::json_value_ref & l
+                            , search_engine const & engine);
+    void                check_journal(
+                              definition const & def
+                            , as2js::json::json_value_ref & json);
 
     bool                f_found = false;
+    bool                f_checkpoints_loaded = false;
+    bool                f_first_sight = false;
+    checkpoints         f_checkpoints = checkpoints();
+    fingerprints        f_fingerprints = fingerprints();
+    growth_tracker      f_growth = growth_tracker();
+    journal_reader      f_journal = journal_reader();
+    realtime_logs::pointer_t
+                        f_realtime = realtime_logs::pointer_t();
+    log_scanner         f_scanner = log_scanner();
+    std::set<std::string>
+                        f_scanned_logs = std::set<std::string>();
+    std::map<std::string, search_engine>
+                        f_engines = std::map<std::string, search_engine>();
 };
 
 
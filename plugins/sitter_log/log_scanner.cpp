@@ -0,0 +1,519 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "log_scanner.h"
+
+
+// snapdev
+//
+#include    <snapdev/raii_generic_deleter.h>
+
+
+// C++
+//
+#include    <algorithm>
+#include    <memory>
+
+
+// C
+//
+#include    <fcntl.h>
+#include    <string.h>
+#include    <sys/stat.h>
+#include    <unistd.h>
+#include    <zlib.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+/** \file
+ * \brief This file implements the incremental scanning of log files.
+ *
+ * Logs can grow to several gigabytes. Reading them in full on each tick
+ * is not an option. Instead, the scanner starts reading at the offset
+ * saved in the checkpoint of the file and stops at the current end of
+ * the file. So each tick costs only the growth of the logs.
+ *
+ * A file with a different device or inode was rotated: the new file is
+ * scanned from the start. A file smaller than the checkpoint offset was
+ * truncated (i.e. logrotate with copytruncate): it is also scanned from
+ * the start.
+ *
+ * A last line without a newline is likely being written. It is not
+ * consumed; the next tick scans it again once complete.
+ *
+ * A read error returns SCAN_STATUS_FAILED with the errno available
+ * through get_error(). The checkpoint is not updated so the same lines
+ * get scanned again on the next tick.
+ *
+ * Rotated logs compressed with gzip are decompressed in memory as they
+ * get scanned; they are never unpacked to disk.
+ */
+
+
+
+namespace sitter
+{
+namespace log
+{
+
+
+
+namespace
+{
+
+
+
+typedef std::unique_ptr<gzFile_s, decltype(&gzclose)>  gzfile_t;
+
+
+int gz_errno(gzFile gz)
+{
+    int errnum(Z_OK);
+    gzerror(gz, &errnum);
+    return errnum == Z_ERRNO ? errno : EIO;
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Scan the new lines of a log file.
+ *
+ * This function reads the lines added to \p filename since the last
+ * scan and calls \p callback with blocks of complete lines. Each line
+ * in a block ends with a newline character. A line longer than the
+ * buffer is passed in pieces without a newline.
+ *
+ * A log file seen for the first time (\p known is false) is scanned
+ * from INITIAL_SCAN_SIZE bytes before its end so the first tick does
+ * not read gigabytes of old logs.
+ *
+ * \param[in] filename  The name of the log file.
+ * \param[in,out] cp  The checkpoint of this log file.
+ * \param[in] known  Whether \p cp was loaded from a previous scan.
+ * \param[in] callback  The function called with each block of lines.
+ *
+ * \return The status of the scan.
+ */
+scan_status_t log_scanner::scan(
+      std::string const & filename
+    , checkpoint_t & cp
+    , bool known
+    , block_callback_t callback)
+{
+    f_scanned = 0;
+    f_error = 0;
+
+    int const fd(open(filename.c_str(), O_RDONLY | O_CLOEXEC | O_NOCTTY));
+    if(fd == -1)
+    {
+        f_error = errno;
+        return scan_status_t::SCAN_STATUS_FAILED;
+    }
+    snapdev::raii_fd_t safe_fd(fd);
+
+    struct stat st = {};
+    if(fstat(fd, &st) != 0)
+    {
+        f_error = errno;
+        return scan_status_t::SCAN_STATUS_FAILED;
+    }
+
+    scan_status_t result(scan_status_t::SCAN_STATUS_SCANNED);
+    off_t offset(cp.f_offset);
+    if(!known)
+    {
+        offset = std::max(st.st_size - INITIAL_SCAN_SIZE, static_cast<off_t>(0));
+    }
+    else if(cp.f_device != st.st_dev
+         || cp.f_inode != st.st_ino)
+    {
+        result = scan_status_t::SCAN_STATUS_ROTATED;
+        offset = 0;
+    }
+    else if(st.st_size < offset)
+    {
+        result = scan_status_t::SCAN_STATUS_TRUNCATED;
+        offset = 0;
+    }
+
+    if(f_buffer.size() != BUFFER_SIZE)
+    {
+        f_buffer.resize(BUFFER_SIZE);
+    }
+
+    // when we start in the middle of the file, skip the partial line
+    //
+    bool skip_partial(!known && offset > 0);
+
+    // stop at the size we got from fstat() so a file growing quickly
+    // does not keep us busy; the rest gets scanned on the next tick
+    //
+    off_t const end(st.st_size);
+    std::size_t used(0);
+    while(offset + static_cast<off_t>(used) < end)
+    {
+        std::size_t const size(std::min(
+                  BUFFER_SIZE - used
+                , static_cast<std::size_t>(end - offset - static_cast<off_t>(used))));
+        ssize_t const r(pread(fd, f_buffer.data() + used, size, offset + static_cast<off_t>(used)));
+        if(r < 0)
+        {
+            // the matches found so far do not get reported, so leave the
+            // checkpoint offset as is and try again on the next tick
+            //
+            f_error = errno;
+            return scan_status_t::SCAN_STATUS_FAILED;
+        }
+        if(r == 0)
+        {
+            // the file was truncated after the fstat()
+            //
+            break;
+        }
+        used += static_cast<std::size_t>(r);
+        f_scanned += static_cast<std::size_t>(r);
+
+        char const * start(f_buffer.data());
+        char const * const limit(f_buffer.data() + used);
+        if(skip_partial)
+        {
+            char const * eol(static_cast<char const *>(memchr(start, '\n', limit - start)));
+            if(eol != nullptr)
+            {
+                skip_partial = false;
+                start = eol + 1;
+            }
+        }
+        if(!skip_partial)
+        {
+            // hand all the complete lines to the callback at once
+            //
+            char const * last(static_cast<char const *>(memrchr(start, '\n', limit - start)));
+            if(last != nullptr)
+            {
+                callback(start, last + 1 - start);
+                start = last + 1;
+            }
+        }
+
+        std::size_t const consumed(start - f_buffer.data());
+        if(consumed == 0
+        && used == BUFFER_SIZE)
+        {
+            // a line longer than our buffer, process it in pieces
+            //
+            if(!skip_partial)
+            {
+                callback(f_buffer.data(), used);
+            }
+            offset += static_cast<off_t>(used);
+            used = 0;
+            continue;
+        }
+
+        offset += static_cast<off_t>(consumed);
+        used -= consumed;
+        if(used > 0
+        && consumed > 0)
+        {
+            memmove(f_buffer.data(), start, used);
+        }
+    }
+
+    // the bytes left in the buffer are a partial line; they get scanned
+    // again on the next tick
+    //
+    cp.f_device = st.st_dev;
+    cp.f_inode = st.st_ino;
+    cp.f_offset = offset;
+
+    return result;
+}
+
+
+/** \brief Scan a log file compressed with gzip.
+ *
+ * This function decompresses \p filename in memory and calls \p callback
+ * with blocks of complete lines. The first \p offset bytes of the
+ * uncompressed data were already scanned (i.e. before the file was
+ * rotated and compressed) and are skipped.
+ *
+ * A compressed file is complete so its last line is passed to the
+ * callback even if it does not end with a newline.
+ *
+ * \param[in] filename  The name of the compressed log file.
+ * \param[in,out] offset  The number of uncompressed bytes already scanned.
+ * On return, the total number of uncompressed bytes.
+ * \param[in] callback  The function called with each block of lines.
+ *
+ * \return The status of the scan.
+ */
+scan_status_t log_scanner::scan_compressed(
+      std::string const & filename
+    , off_t & offset
+    , block_callback_t callback)
+{
+    f_scanned = 0;
+    f_error = 0;
+
+    gzfile_t gz(gzopen(filename.c_str(), "rbe"), &gzclose);
+    if(gz == nullptr)
+    {
+        f_error = errno == 0 ? ENOMEM : errno;
+        return scan_status_t::SCAN_STATUS_FAILED;
+    }
+    gzbuffer(gz.get(), 128 * 1024);
+
+    if(f_buffer.size() != BUFFER_SIZE)
+    {
+        f_buffer.resize(BUFFER_SIZE);
+    }
+
+    // skip the data we already scanned; it still has to be decompressed
+    //
+    off_t skipped(0);
+    while(skipped < offset)
+    {
+        int const r(gzread(
+                  gz.get()
+                , f_buffer.data()
+                , static_cast<unsigned>(std::min(static_cast<off_t>(BUFFER_SIZE), offset - skipped))));
+        if(r < 0)
+        {
+            f_error = gz_errno(gz.get());
+            return scan_status_t::SCAN_STATUS_FAILED;
+        }
+        if(r == 0)
+        {
+            // the file is smaller than what we scanned so far, nothing new
+            //
+            offset = skipped;
+            return scan_status_t::SCAN_STATUS_SCANNED;
+        }
+        skipped += r;
+    }
+
+    std::size_t used(0);
+    for(;;)
+    {
+        int const r(gzread(
+                  gz.get()
+                , f_buffer.data() + used
+                , static_cast<unsigned>(BUFFER_SIZE - used)));
+        if(r < 0)
+        {
+            f_error = gz_errno(gz.get());
+            return scan_status_t::SCAN_STATUS_FAILED;
+        }
+        if(r == 0)
+        {
+            break;
+        }
+        used += static_cast<std::size_t>(r);
+        f_scanned += static_cast<std::size_t>(r);
+
+        char const * last(static_cast<char const *>(memrchr(f_buffer.data(), '\n', used)));
+        std::size_t consumed(0);
+        if(last != nullptr)
+        {
+            consumed = last + 1 - f_buffer.data();
+        }
+        else if(used == BUFFER_SIZE)
+        {
+            // a line longer than our buffer, process it in pieces
+            //
+            consumed = used;
+        }
+        if(consumed > 0)
+        {
+            callback(f_buffer.data(), consumed);
+            offset += static_cast<off_t>(consumed);
+            used -= consumed;
+            memmove(f_buffer.data(), f_buffer.data() + consumed, used);
+        }
+    }
+
+    if(used > 0)
+    {
+        callback(f_buffer.data(), used);
+        offset += static_cast<off_t>(used);
+    }
+
+    return scan_status_t::SCAN_STATUS_SCANNED;
+}
+
+
+/** \brief Compute the hash of the head of a log file.
+ *
+ * This function computes a hash of the first HEAD_SIZE bytes of the
+ * file. When \p compressed is true, the hash is computed on the
+ * uncompressed data so a log file and its compressed version have the
+ * same hash.
+ *
+ * \param[in] filename  The name of the log file.
+ * \param[in] compressed  Whether the file is compressed with gzip.
+ * \param[out] hash  The resulting hash.
+ *
+ * \return true if the hash was computed, false if the file could not be
+ * read or is empty.
+ */
+bool log_scanner::head_hash(
+      std::string const & filename
+    , bool compressed
+    , std::uint64_t & hash)
+{
+    f_error = 0;
+
+    char head[HEAD_SIZE];
+    std::size_t size(0);
+    if(compressed)
+    {
+        gzfile_t gz(gzopen(filename.c_str(), "rbe"), &gzclose);
+        if(gz == nullptr)
+        {
+            f_error = errno == 0 ? ENOMEM : errno;
+            return false;
+        }
+        while(size < HEAD_SIZE)
+        {
+            int const r(gzread(gz.get(), head + size, static_cast<unsigned>(HEAD_SIZE - size)));
+            if(r < 0)
+            {
+                f_error = gz_errno(gz.get());
+                return false;
+            }
+            if(r == 0)
+            {
+                break;
+            }
+            size += static_cast<std::size_t>(r);
+        }
+    }
+    else
+    {
+        int const fd(open(filename.c_str(), O_RDONLY | O_CLOEXEC | O_NOCTTY));
+        if(fd == -1)
+        {
+            f_error = errno;
+            return false;
+        }
+        snapdev::raii_fd_t safe_fd(fd);
+        ssize_t const r(pread(fd, head, HEAD_SIZE, 0));
+        if(r < 0)
+        {
+            f_error = errno;
+            return false;
+        }
+        size = static_cast<std::size_t>(r);
+    }
+    if(size == 0)
+    {
+        return false;
+    }
+
+    // FNV-1a
+    //
+    hash = 14695981039346656037ULL;
+    for(std::size_t idx(0); idx < size; ++idx)
+    {
+        hash ^= static_cast<unsigned char>(head[idx]);
+        hash *= 1099511628211ULL;
+    }
+
+    return true;
+}
+
+
+/** \brief Get the uncompressed size of a gzip file.
+ *
+ * The gzip format saves the size of the uncompressed data modulo 2^32
+ * at the end of the file. This is used to know whether a compressed log
+ * includes data which was not yet scanned without decompressing it.
+ *
+ * \param[in] filename  The name of the compressed file.
+ * \param[out] size  The uncompressed size modulo 2^32.
+ *
+ * \return true if the size was read.
+ */
+bool log_scanner::compressed_size(
+      std::string const & filename
+    , std::uint32_t & size)
+{
+    int const fd(open(filename.c_str(), O_RDONLY | O_CLOEXEC | O_NOCTTY));
+    if(fd == -1)
+    {
+        return false;
+    }
+    snapdev::raii_fd_t safe_fd(fd);
+
+    struct stat st = {};
+    if(fstat(fd, &st) != 0
+    || st.st_size < 18)     // smallest gzip file
+    {
+        return false;
+    }
+
+    unsigned char isize[4];
+    if(pread(fd, isize, sizeof(isize), st.st_size - 4) != sizeof(isize))
+    {
+        return false;
+    }
+    size = isize[0]
+         | (isize[1] << 8)
+         | (isize[2] << 16)
+         | (static_cast<std::uint32_t>(isize[3]) << 24);
+
+    return true;
+}
+
+
+/** \brief Get the number of bytes read by the last scan.
+ *
+ * \return The number of bytes read.
+ */
+std::size_t log_scanner::get_scanned() const
+{
+    return f_scanned;
+}
+
+
+/** \brief Get the error of the last scan.
+ *
+ * \return The errno of the last scan which failed, 0 otherwise.
+ */
+int log_scanner::get_error() const
+{
+    return f_error;
+}
+
+
+
+} // namespace log
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,88 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    "checkpoint.h"
+
+
+// C++
+//
+#include    <cstdint>
+#include    <functional>
+#include    <vector>
+
+
+
+namespace sitter
+{
+namespace log
+{
+
+
+
+enum class scan_status_t
+{
+    SCAN_STATUS_SCANNED,
+    SCAN_STATUS_ROTATED,
+    SCAN_STATUS_TRUNCATED,
+    SCAN_STATUS_FAILED,
+};
+
+
+class log_scanner
+{
+public:
+    typedef std::function<void(char const * block, std::size_t size)>
+                                block_callback_t;
+
+    static constexpr std::size_t const  BUFFER_SIZE = 1024 * 1024;
+    static constexpr off_t const        INITIAL_SCAN_SIZE = 1024 * 1024;
+    static constexpr std::size_t const  HEAD_SIZE = 4096;
+
+    scan_status_t               scan(
+                                      std::string const & filename
+                                    , checkpoint_t & cp
+                                    , bool known
+                                    , block_callback_t callback);
+    scan_status_t               scan_compressed(
+                                      std::string const & filename
+                                    , off_t & offset
+                                    , block_callback_t callback);
+    bool                        head_hash(
+                                      std::string const & filename
+                                    , bool compressed
+                                    , std::uint64_t & hash);
+    static bool                 compressed_size(
+                                      std::string const & filename
+                                    , std::uint32_t & size);
+    std::size_t                 get_scanned() const;
+    int                         get_error() const;
+
+private:
+    std::vector<char>           f_buffer = std::vector<char>();
+    std::size_t                 f_scanned = 0;
+    int                         f_error = 0;
+};
+
+
+
+} // namespace log
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,738 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "log_watcher.h"
+
+#include    "fingerprint.h"
+
+
+// sitter
+//
+#include    <sitter/monotonic_clock.h>
+#include    <sitter/sitter.h>
+
+
+// cppthread
+//
+#include    <cppthread/guard.h>
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// snapdev
+//
+#include    <snapdev/not_used.h>
+
+
+// C++
+//
+#include    <algorithm>
+
+
+// C
+//
+#include    <dirent.h>
+#include    <fnmatch.h>
+#include    <poll.h>
+#include    <string.h>
+#include    <sys/eventfd.h>
+#include    <sys/inotify.h>
+#include    <sys/stat.h>
+#include    <unistd.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the real-time log watcher.
+ *
+ * The log plugin searches the logs once per tick, so a crash signature
+ * such as "SEGV" can take up to a minute to be noticed. When the
+ * log_realtime option is turned on, this watcher keeps an inotify watch
+ * on the directories of the log definitions which have at least one
+ * search marked urgent=true.
+ *
+ * Each time a log gets modified, the watcher waits for the debounce
+ * delay (a service writing many lines in a row generates a single scan)
+ * and then searches the new bytes with the urgent searches only. On a
+ * match, it forces a tick so the log plugin reports the error right
+ * away. The watcher has its own offsets; the tick still scans and
+ * reports all the searches as usual.
+ *
+ * The server limits the number of forced ticks so a service flooding
+ * its log with crashes does not keep the sitter busy. When the server
+ * refuses a tick, the watcher tries again once the server accepts
+ * ticks again.
+ */
+
+
+
+namespace sitter
+{
+namespace log
+{
+
+
+
+namespace
+{
+
+
+
+bool matches(definition const & def, std::string const & name)
+{
+    for(auto const & p : def.get_patterns())
+    {
+        if(fnmatch(p.c_str(), name.c_str(), FNM_PERIOD) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Initialize the log watcher.
+ *
+ * The constructor creates the inotify object and an eventfd used to
+ * wake up the thread when it has to exit.
+ *
+ * \param[in] s  The sitter server, used to force a tick.
+ */
+log_watcher::log_watcher(server * s)
+    : runner("log-watcher")
+    , f_server(s)
+    , f_inotify_fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+    , f_wakeup_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+    if(f_inotify_fd.get() == -1)
+    {
+        int const e(errno);
+        SNAP_LOG_WARNING
+            << "could not create an inotify object to watch the logs (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << "); the logs will only be searched on each tick."
+            << SNAP_LOG_SEND;
+    }
+}
+
+
+log_watcher::~log_watcher()
+{
+}
+
+
+/** \brief Update the list of logs to watch.
+ *
+ * This function is called on each tick with the current log definitions.
+ * Only the definitions with urgent searches are watched. A directory
+ * which was not watched yet gets a new inotify watch and the files
+ * already present are scanned starting at their current end.
+ *
+ * \param[in] defs  The log definitions.
+ * \param[in] debounce  The debounce delay in milliseconds.
+ */
+void log_watcher::set_definitions(
+      definition::vector_t const & defs
+    , std::int64_t debounce)
+{
+    if(f_inotify_fd.get() == -1)
+    {
+        return;
+    }
+
+    cppthread::guard lock(f_mutex);
+
+    f_debounce = debounce * 1'000;
+
+    directory_map_t directories;
+    for(auto const & def : defs)
+    {
+        if(def.is_journal())
+        {
+            continue;
+        }
+
+        search::vector_t urgent;
+        for(auto const & s : def.get_searches())
+        {
+            if(s.is_urgent())
+            {
+                urgent.push_back(s);
+            }
+        }
+        if(urgent.empty())
+        {
+            continue;
+        }
+
+        directory_t & dir(directories[def.get_path()]);
+        dir.f_path = def.get_path();
+
+        watched_definition_t w;
+        w.f_definition = def;
+
+        // keep the engine compiled on a previous tick
+        //
+        auto const previous(f_directories.find(def.get_path()));
+        if(previous != f_directories.end())
+        {
+            for(auto const & p : previous->second.f_definitions)
+            {
+                if(p.f_definition.get_name() == def.get_name())
+                {
+                    w.f_engine = p.f_engine;
+                    break;
+                }
+            }
+        }
+        w.f_engine.compile(urgent);
+        dir.f_definitions.push_back(w);
+    }
+
+    for(auto & d : directories)
+    {
+        auto const previous(f_directories.find(d.first));
+        if(previous != f_directories.end()
+        && previous->second.f_watch != -1)
+        {
+            d.second.f_watch = previous->second.f_watch;
+            continue;
+        }
+
+        d.second.f_watch = inotify_add_watch(
+                  f_inotify_fd.get()
+                , d.second.f_path.c_str()
+                , IN_MODIFY | IN_CREATE);
+        if(d.second.f_watch == -1)
+        {
+            if(previous == f_directories.end())
+            {
+                int const e(errno);
+                SNAP_LOG_WARNING
+                    << "could not watch log directory \""
+                    << d.second.f_path
+                    << "\" (errno: "
+                    << e
+                    << ", "
+                    << strerror(e)
+                    << ")."
+                    << SNAP_LOG_SEND;
+            }
+            continue;
+        }
+
+        // only the lines written from now on are of interest
+        //
+        DIR * dp(opendir(d.second.f_path.c_str()));
+        if(dp != nullptr)
+        {
+            for(dirent * entry(readdir(dp)); entry != nullptr; entry = readdir(dp))
+            {
+                std::string const name(entry->d_name);
+                for(auto const & w : d.second.f_definitions)
+                {
+                    if(matches(w.f_definition, name))
+                    {
+                        start_at_end(d.second.f_path + "/" + name);
+                        break;
+                    }
+                }
+            }
+            closedir(dp);
+        }
+    }
+
+    for(auto const & d : f_directories)
+    {
+        if(d.second.f_watch != -1
+        && directories.find(d.first) == directories.end())
+        {
+            inotify_rm_watch(f_inotify_fd.get(), d.second.f_watch);
+        }
+    }
+
+    f_directories.swap(directories);
+}
+
+
+/** \brief Wake up the thread so it can exit.
+ *
+ * This function is called when the thread is asked to stop.
+ */
+void log_watcher::wakeup()
+{
+    std::uint64_t const value(1);
+    snapdev::NOT_USED(write(f_wakeup_fd.get(), &value, sizeof(value)));
+}
+
+
+/** \brief Watch the logs.
+ *
+ * This function returns when the thread is asked to exit.
+ */
+void log_watcher::run()
+{
+    if(f_inotify_fd.get() == -1
+    || f_wakeup_fd.get() == -1)
+    {
+        return;
+    }
+
+    watch();
+}
+
+
+/** \brief The poll() loop.
+ *
+ * This function waits for inotify events or for the next pending scan,
+ * whichever comes first.
+ */
+void log_watcher::watch()
+{
+    while(continue_running())
+    {
+        int timeout(-1);
+        {
+            cppthread::guard lock(f_mutex);
+
+            std::int64_t deadline(-1);
+            for(auto const & p : f_pending)
+            {
+                if(deadline == -1
+                || p.second < deadline)
+                {
+                    deadline = p.second;
+                }
+            }
+            if(f_tick_pending
+            && (deadline == -1 || f_tick_retry < deadline))
+            {
+                deadline = f_tick_retry;
+            }
+            if(deadline != -1)
+            {
+                timeout = static_cast<int>(std::max((deadline - monotonic_usec() + 999) / 1'000, static_cast<std::int64_t>(0)));
+            }
+        }
+
+        pollfd fds[2] = {};
+        fds[0].fd = f_inotify_fd.get();
+        fds[0].events = POLLIN;
+        fds[1].fd = f_wakeup_fd.get();
+        fds[1].events = POLLIN;
+        int const r(poll(fds, 2, timeout));
+        if(r < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            int const e(errno);
+            SNAP_LOG_ERROR
+                << "poll() on the log inotify object failed (errno: "
+                << e
+                << ", "
+                << strerror(e)
+                << "); the logs will only be searched on each tick."
+                << SNAP_LOG_SEND;
+            return;
+        }
+
+        if((fds[1].revents & POLLIN) != 0)
+        {
+            // asked to exit
+            //
+            return;
+        }
+
+        bool force_tick(false);
+        {
+            cppthread::guard lock(f_mutex);
+
+            std::int64_t const now(monotonic_usec());
+            if((fds[0].revents & POLLIN) != 0)
+            {
+                read_events(now);
+            }
+            scan_pending(now);
+            if(f_tick_pending
+            && now >= f_tick_retry)
+            {
+                f_tick_pending = false;
+                force_tick = true;
+            }
+        }
+        if(force_tick
+        && !f_server->force_tick())
+        {
+            // another tick just happened, try again once the server
+            // accepts ticks again
+            //
+            cppthread::guard lock(f_mutex);
+            f_tick_pending = true;
+            f_tick_retry = monotonic_usec() + server::MINIMUM_TICK_INTERVAL * 1'000'000;
+        }
+    }
+}
+
+
+/** \brief Read the inotify events.
+ *
+ * Each modified log gets scanned once the debounce delay is over. The
+ * deadline is not pushed back by further events so a log which keeps
+ * growing still gets scanned once per debounce delay.
+ *
+ * A log created after the watch started is scanned from the start.
+ * Rotated logs are ignored; they are not being written to.
+ *
+ * If the kernel event queue overflowed, some events were lost so all
+ * the watched logs get scanned (see rescan_all()).
+ *
+ * \note
+ * This function must be called with the mutex locked.
+ *
+ * \param[in] now  The current time in microseconds.
+ */
+void log_watcher::read_events(std::int64_t now)
+{
+    alignas(inotify_event) char buffer[4096];
+    for(;;)
+    {
+        ssize_t const size(read(f_inotify_fd.get(), buffer, sizeof(buffer)));
+        if(size <= 0)
+        {
+            // EAGAIN, we read all the events
+            //
+            return;
+        }
+
+        for(char const * ptr(buffer); ptr < buffer + size; )
+        {
+            inotify_event const * e(reinterpret_cast<inotify_event const *>(ptr));
+            ptr += sizeof(inotify_event) + e->len;
+            if((e->mask & IN_Q_OVERFLOW) != 0)
+            {
+                rescan_all(now);
+                continue;
+            }
+            if(e->len == 0
+            || (e->mask & IN_ISDIR) != 0)
+            {
+                continue;
+            }
+
+            auto const dir(std::find_if(
+                      f_directories.begin()
+                    , f_directories.end()
+                    , [e](auto const & d)
+                      {
+                          return d.second.f_watch == e->wd;
+                      }));
+            if(dir == f_directories.end())
+            {
+                continue;
+            }
+
+            std::string const name(e->name);
+            if(is_rotated(name)
+            || std::none_of(
+                      dir->second.f_definitions.begin()
+                    , dir->second.f_definitions.end()
+                    , [&name](watched_definition_t const & w)
+                      {
+                          return matches(w.f_definition, name);
+                      }))
+            {
+                continue;
+            }
+
+            std::string const filename(dir->second.f_path + "/" + name);
+            if((e->mask & IN_CREATE) != 0)
+            {
+                // a new file, scan it from the start
+                //
+                f_checkpoints[filename] = checkpoint_t();
+            }
+            f_pending.emplace(filename, now + f_debounce);
+        }
+    }
+}
+
+
+/** \brief Scan all the watched logs.
+ *
+ * When the inotify queue overflows, the kernel drops events and we
+ * cannot know which logs were modified or created. This function adds
+ * all the logs found in the watched directories to the list of pending
+ * scans. The checkpoints make sure only the new lines get searched.
+ *
+ * A log without a checkpoint was created after the watch started (its
+ * IN_CREATE event was lost) so it is scanned from the start.
+ *
+ * \note
+ * This function must be called with the mutex locked.
+ *
+ * \param[in] now  The current time in microseconds.
+ */
+void log_watcher::rescan_all(std::int64_t now)
+{
+    SNAP_LOG_WARNING
+        << "the inotify queue of the log watcher overflowed; scanning all the watched logs."
+        << SNAP_LOG_SEND;
+
+    for(auto const & d : f_directories)
+    {
+        if(d.second.f_watch == -1)
+        {
+            continue;
+        }
+
+        DIR * dp(opendir(d.second.f_path.c_str()));
+        if(dp == nullptr)
+        {
+            continue;
+        }
+        for(dirent * entry(readdir(dp)); entry != nullptr; entry = readdir(dp))
+        {
+            std::string const name(entry->d_name);
+            if(is_rotated(name)
+            || std::none_of(
+                      d.second.f_definitions.begin()
+                    , d.second.f_definitions.end()
+                    , [&name](watched_definition_t const & w)
+                      {
+                          return matches(w.f_definition, name);
+                      }))
+            {
+                continue;
+            }
+
+            std::string const filename(d.second.f_path + "/" + name);
+            if(f_checkpoints.find(filename) == f_checkpoints.end())
+            {
+                f_checkpoints[filename] = checkpoint_t();
+            }
+            f_pending.emplace(filename, now + f_debounce);
+        }
+        closedir(dp);
+    }
+}
+
+
+/** \brief Scan the logs for which the debounce delay is over.
+ *
+ * \note
+ * This function must be called with the mutex locked.
+ *
+ * \param[in] now  The current time in microseconds.
+ */
+void log_watcher::scan_pending(std::int64_t now)
+{
+    for(auto it(f_pending.begin()); it != f_pending.end(); )
+    {
+        if(it->second > now)
+        {
+            ++it;
+            continue;
+        }
+
+        if(scan_file(it->first))
+        {
+            f_tick_pending = true;
+        }
+        it = f_pending.erase(it);
+    }
+}
+
+
+/** \brief Search the new lines of a log with the urgent searches.
+ *
+ * \note
+ * This function must be called with the mutex locked.
+ *
+ * \param[in] filename  The name of the log file.
+ *
+ * \return true if at least one urgent search matched.
+ */
+bool log_watcher::scan_file(std::string const & filename)
+{
+    std::string::size_type const pos(filename.rfind('/'));
+    auto const dir(f_directories.find(filename.substr(0, pos)));
+    if(dir == f_directories.end())
+    {
+        return false;
+    }
+
+    std::string const name(filename.substr(pos + 1));
+    std::vector<watched_definition_t *> defs;
+    for(auto & w : dir->second.f_definitions)
+    {
+        if(matches(w.f_definition, name))
+        {
+            w.f_engine.reset_matches();
+            defs.push_back(&w);
+        }
+    }
+    if(defs.empty())
+    {
+        return false;
+    }
+
+    auto const cp(f_checkpoints.find(filename));
+    if(cp == f_checkpoints.end())
+    {
+        // we do not know which lines are new
+        //
+        start_at_end(filename);
+        return false;
+    }
+
+    scan_status_t const status(f_scanner.scan(
+          filename
+        , cp->second
+        , true
+        , [&defs](char const * block, std::size_t size)
+        {
+            for(auto w : defs)
+            {
+                w->f_engine.search_block(block, size);
+            }
+        }));
+    if(status == scan_status_t::SCAN_STATUS_FAILED)
+    {
+        return false;
+    }
+
+    bool found(false);
+    for(auto w : defs)
+    {
+        search_engine::match_vector_t const & m(w->f_engine.get_matches());
+        for(std::size_t idx(0); idx < m.size(); ++idx)
+        {
+            if(m[idx].f_count == 0)
+            {
+                continue;
+            }
+            found = true;
+
+            SNAP_LOG_ERROR
+                << "found \""
+                << w->f_engine.get_search(idx).get_name()
+                << "\" in log file "
+                << w->f_definition.get_name()
+                << " ("
+                << filename
+                << "): "
+                << m[idx].f_first_line
+                << SNAP_LOG_SEND;
+        }
+    }
+
+    return found;
+}
+
+
+/** \brief Start watching a file at its current end.
+ *
+ * \note
+ * This function must be called with the mutex locked.
+ *
+ * \param[in] filename  The name of the log file.
+ */
+void log_watcher::start_at_end(std::string const & filename)
+{
+    struct stat st = {};
+    if(stat(filename.c_str(), &st) != 0
+    || !S_ISREG(st.st_mode))
+    {
+        return;
+    }
+
+    checkpoint_t & cp(f_checkpoints[filename]);
+    cp.f_device = st.st_dev;
+    cp.f_inode = st.st_ino;
+    cp.f_offset = st.st_size;
+}
+
+
+
+
+
+/** \brief Start the log watcher thread.
+ *
+ * \param[in] s  The sitter server.
+ */
+realtime_logs::realtime_logs(server * s)
+    : f_watcher(std::make_shared<log_watcher>(s))
+    , f_thread(std::make_shared<cppthread::thread>("log-watcher", f_watcher))
+{
+    f_thread->start();
+}
+
+
+/** \brief Stop the log watcher thread.
+ *
+ * The thread sleeps in poll() so we have to wake it up for it to exit.
+ */
+realtime_logs::~realtime_logs()
+{
+    f_thread->stop([this](cppthread::thread * t)
+        {
+            snapdev::NOT_USED(t);
+            f_watcher->wakeup();
+        });
+}
+
+
+/** \brief Update the list of logs to watch.
+ *
+ * \param[in] defs  The log definitions.
+ * \param[in] debounce  The debounce delay in milliseconds.
+ */
+void realtime_logs::set_definitions(
+      definition::vector_t const & defs
+    , std::int64_t debounce)
+{
+    f_watcher->set_definitions(defs, debounce);
+}
+
+
+
+} // namespace log
+} // namespace sitter
+// vim: ts=4 sw=4 et
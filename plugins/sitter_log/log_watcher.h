@@ -0,0 +1,140 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    "definition.h"
+#include    "log_scanner.h"
+#include    "search_engine.h"
+
+
+// cppthread
+//
+#include    <cppthread/mutex.h>
+#include    <cppthread/runner.h>
+#include    <cppthread/thread.h>
+
+
+// snapdev
+//
+#include    <snapdev/raii_generic_deleter.h>
+
+
+// C++
+//
+#include    <map>
+
+
+
+namespace sitter
+{
+class server;
+
+namespace log
+{
+
+
+
+class log_watcher
+    : public cppthread::runner
+{
+public:
+    typedef std::shared_ptr<log_watcher>    pointer_t;
+
+    static constexpr std::int64_t const     DEFAULT_DEBOUNCE = 250;             // milliseconds
+
+                            log_watcher(server * s);
+                            log_watcher(log_watcher const &) = delete;
+    virtual                 ~log_watcher() override;
+    log_watcher &           operator = (log_watcher const &) = delete;
+
+    void                    set_definitions(
+                                  definition::vector_t const & defs
+                                , std::int64_t debounce);
+    void                    wakeup();
+
+    // cppthread::runner implementation
+    //
+    virtual void            run() override;
+
+private:
+    struct watched_definition_t
+    {
+        definition          f_definition = definition(std::string(), false);
+        search_engine       f_engine = search_engine();
+    };
+    typedef std::vector<watched_definition_t>   watched_definition_vector_t;
+
+    struct directory_t
+    {
+        int                 f_watch = -1;
+        std::string         f_path = std::string();
+        watched_definition_vector_t
+                            f_definitions = watched_definition_vector_t();
+    };
+    typedef std::map<std::string, directory_t>  directory_map_t;
+
+    void                    watch();
+    void                    read_events(std::int64_t now);
+    void                    rescan_all(std::int64_t now);
+    void                    scan_pending(std::int64_t now);
+    bool                    scan_file(std::string const & filename);
+    void                    start_at_end(std::string const & filename);
+
+    server *                f_server = nullptr;
+    cppthread::mutex        f_mutex = cppthread::mutex();
+    snapdev::raii_fd_t      f_inotify_fd = snapdev::raii_fd_t();
+    snapdev::raii_fd_t      f_wakeup_fd = snapdev::raii_fd_t();
+    directory_map_t         f_directories = directory_map_t();
+    std::map<std::string, checkpoint_t>
+                            f_checkpoints = std::map<std::string, checkpoint_t>();
+    std::map<std::string, std::int64_t>
+                            f_pending = std::map<std::string, std::int64_t>();
+    std::int64_t            f_debounce = DEFAULT_DEBOUNCE * 1'000;
+    std::int64_t            f_tick_retry = 0;
+    bool                    f_tick_pending = false;
+    log_scanner             f_scanner = log_scanner();
+};
+
+
+class realtime_logs
+{
+public:
+    typedef std::shared_ptr<realtime_logs>  pointer_t;
+
+                            realtime_logs(server * s);
+                            realtime_logs(realtime_logs const &) = delete;
+                            ~realtime_logs();
+    realtime_logs &         operator = (realtime_logs const &) = delete;
+
+    void                    set_definitions(
+                                  definition::vector_t const & defs
+                                , std::int64_t debounce);
+
+private:
+    log_watcher::pointer_t  f_watcher = log_watcher::pointer_t();
+    cppthread::thread::pointer_t
+                            f_thread = cppthread::thread::pointer_t();
+};
+
+
+
+} // namespace log
+} // namespace sitter
+// vim: ts=4 sw=4 et
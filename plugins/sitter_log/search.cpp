@@ -36,13 +36,25 @@ namespace log
 
 
 
-search::search(std::string const & regex, std::string const & report_as)
-    : f_regex(regex)
+search::search(
+      std::string const & name
+    , std::string const & regex
+    , std::string const & report_as
+    , bool urgent)
+    : f_name(name)
+    , f_regex(regex)
     , f_report_as(report_as)
+    , f_urgent(urgent)
 {
 }
 
 
+std::string const & search::get_name() const
+{
+    return f_name;
+}
+
+
 std::string const & search::get_regex() const
 {
     return f_regex;
@@ -55,6 +67,18 @@ std::string const & search::get_report_as() const
 }
 
 
+bool search::is_error() const
+{
+    return f_report_as == "error";
+}
+
+
+bool search::is_urgent() const
+{
+    return f_urgent;
+}
+
+
 
 } // namespace log
 } // namespace sitter
@@ -37,15 +37,22 @@ public:
     typedef std::vector<search> vector_t;
 
                                 search(
-                                      std::string const & regex
-                                    , std::string const & report_as);
+                                      std::string const & name
+                                    , std::string const & regex
+                                    , std::string const & report_as
+                                    , bool urgent = false);
 
+    std::string const &         get_name() const;
     std::string const &         get_regex() const;
     std::string const &         get_report_as() const;
+    bool                        is_error() const;
+    bool                        is_urgent() const;
 
 private:
+    std::string                 f_name = std::string();
     std::string                 f_regex = std::string();
     std::string                 f_report_as = std::string("error");
+    bool                        f_urgent = false;
 };
 
 
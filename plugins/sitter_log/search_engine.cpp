@@ -0,0 +1,705 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "search_engine.h"
+
+
+// C++
+//
+#include    <algorithm>
+#include    <deque>
+
+
+// C
+//
+#include    <string.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+/** \file
+ * \brief This file implements the log search engine.
+ *
+ * A log definition can include many regular expressions and running
+ * each one of them against each line of a log would be very slow.
+ * Most log searches include a string which has to be found as is in
+ * the line for the regular expression to match (i.e. "SEGV"). The
+ * engine extracts the longest such literal from each regular expression.
+ * Only the lines where the literal appears are checked with the full
+ * regular expression.
+ *
+ * A top level alternation such as "Out of memory|oom-killer" gets one
+ * literal per alternative and a line is a candidate if it includes any
+ * one of them. Regular expressions without a required literal (i.e.
+ * "\\d+") are checked against each line.
+ *
+ * The literals of all the searches are compiled in one Aho-Corasick
+ * automaton. Each state knows which searches have a literal ending
+ * there, so the block is read once whatever the number of searches and
+ * each hit is mapped back to the searches to verify.
+ */
+
+
+
+namespace sitter
+{
+namespace log
+{
+
+
+
+namespace
+{
+
+
+
+void skip_quantifier(std::string const & regex, std::size_t & pos)
+{
+    std::size_t const max(regex.length());
+    if(pos >= max)
+    {
+        return;
+    }
+    switch(regex[pos])
+    {
+    case '*':
+    case '+':
+    case '?':
+        ++pos;
+        break;
+
+    case '{':
+        {
+            std::string::size_type const close(regex.find('}', pos));
+            pos = close == std::string::npos ? max : close + 1;
+        }
+        break;
+
+    default:
+        return;
+
+    }
+
+    // lazy quantifier
+    //
+    if(pos < max
+    && regex[pos] == '?')
+    {
+        ++pos;
+    }
+}
+
+
+void skip_block(std::string const & regex, std::size_t & pos)
+{
+    std::size_t const max(regex.length());
+    int depth(0);
+    bool in_class(false);
+    for(; pos < max; ++pos)
+    {
+        char const c(regex[pos]);
+        if(c == '\\')
+        {
+            ++pos;
+            continue;
+        }
+        if(in_class)
+        {
+            if(c == ']')
+            {
+                in_class = false;
+                if(depth == 0)
+                {
+                    ++pos;
+                    return;
+                }
+            }
+            continue;
+        }
+        switch(c)
+        {
+        case '[':
+            in_class = true;
+            break;
+
+        case '(':
+            ++depth;
+            break;
+
+        case ')':
+            --depth;
+            if(depth <= 0)
+            {
+                ++pos;
+                return;
+            }
+            break;
+
+        default:
+            break;
+
+        }
+    }
+}
+
+
+bool is_optional(std::string const & regex, std::size_t pos)
+{
+    if(pos >= regex.length())
+    {
+        return false;
+    }
+    switch(regex[pos])
+    {
+    case '*':
+    case '?':
+        return true;
+
+    case '{':
+        return pos + 1 < regex.length()
+            && regex[pos + 1] == '0';
+
+    default:
+        return false;
+
+    }
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Compile the searches of a log definition.
+ *
+ * The regular expressions are compiled only if they changed since the
+ * last call.
+ *
+ * A regular expression which does not compile is marked invalid and
+ * its error message can be retrieved with get_error().
+ *
+ * \param[in] searches  The searches of a log definition.
+ */
+void search_engine::compile(search::vector_t const & searches)
+{
+    std::string signature;
+    for(auto const & s : searches)
+    {
+        signature += s.get_name();
+        signature += '\0';
+        signature += s.get_regex();
+        signature += '\0';
+        signature += s.get_report_as();
+        signature += '\0';
+    }
+    if(signature == f_signature
+    && !f_patterns.empty())
+    {
+        return;
+    }
+    f_signature = signature;
+
+    f_patterns.clear();
+    f_patterns.reserve(searches.size());
+    for(auto const & s : searches)
+    {
+        pattern_t p;
+        p.f_search = s;
+        try
+        {
+            p.f_regex = std::regex(s.get_regex(), std::regex::ECMAScript | std::regex::optimize);
+            p.f_literals = required_literals(s.get_regex());
+            p.f_valid = true;
+        }
+        catch(std::regex_error const & e)
+        {
+            p.f_error = e.what();
+        }
+        f_patterns.push_back(p);
+    }
+
+    build_prefilter();
+
+    f_matches.clear();
+    f_matches.resize(f_patterns.size());
+}
+
+
+/** \brief Build the automaton used to find all the literals at once.
+ *
+ * This function adds the literals of all the valid searches to a trie
+ * and then computes the failure links (Aho-Corasick) to transform the
+ * trie in a complete state machine: each state has one transition per
+ * byte value, so the search does one table lookup per character.
+ *
+ * The output of a state is the list of searches which have a literal
+ * ending at that state, including the literals which are a suffix of
+ * the characters read so far (i.e. the outputs of the failure state).
+ */
+void search_engine::build_prefilter()
+{
+    f_transitions.assign(ALPHABET_SIZE, 0);
+    f_outputs.assign(1, index_list_t());
+
+    for(std::size_t idx(0); idx < f_patterns.size(); ++idx)
+    {
+        pattern_t const & p(f_patterns[idx]);
+        if(!p.f_valid)
+        {
+            continue;
+        }
+        for(auto const & l : p.f_literals)
+        {
+            std::uint32_t state(0);
+            for(auto const c : l)
+            {
+                std::size_t const t(state * ALPHABET_SIZE + static_cast<unsigned char>(c));
+                if(f_transitions[t] == 0)
+                {
+                    f_transitions[t] = static_cast<std::uint32_t>(f_outputs.size());
+                    f_transitions.resize(f_transitions.size() + ALPHABET_SIZE, 0);
+                    f_outputs.emplace_back();
+                }
+                state = f_transitions[t];
+            }
+            index_list_t & out(f_outputs[state]);
+            if(std::find(out.begin(), out.end(), idx) == out.end())
+            {
+                out.push_back(idx);
+            }
+        }
+    }
+
+    // breadth first so the failure state of a state is always complete
+    // before we use it
+    //
+    std::vector<std::uint32_t> failure(f_outputs.size(), 0);
+    std::deque<std::uint32_t> queue;
+    for(std::size_t c(0); c < ALPHABET_SIZE; ++c)
+    {
+        if(f_transitions[c] != 0)
+        {
+            queue.push_back(f_transitions[c]);
+        }
+    }
+    while(!queue.empty())
+    {
+        std::uint32_t const state(queue.front());
+        queue.pop_front();
+        for(std::size_t c(0); c < ALPHABET_SIZE; ++c)
+        {
+            std::size_t const t(state * ALPHABET_SIZE + c);
+            std::uint32_t const next(f_transitions[t]);
+            std::uint32_t const fallback(f_transitions[failure[state] * ALPHABET_SIZE + c]);
+            if(next == 0)
+            {
+                f_transitions[t] = fallback;
+                continue;
+            }
+            failure[next] = fallback;
+            for(auto const idx : f_outputs[fallback])
+            {
+                index_list_t & out(f_outputs[next]);
+                if(std::find(out.begin(), out.end(), idx) == out.end())
+                {
+                    out.push_back(idx);
+                }
+            }
+            queue.push_back(next);
+        }
+    }
+}
+
+
+/** \brief Get the number of searches.
+ *
+ * \return The number of searches compiled in this engine.
+ */
+std::size_t search_engine::size() const
+{
+    return f_patterns.size();
+}
+
+
+/** \brief Get one of the searches.
+ *
+ * \param[in] idx  The index of the search.
+ *
+ * \return A reference to the search.
+ */
+search const & search_engine::get_search(std::size_t idx) const
+{
+    return f_patterns[idx].f_search;
+}
+
+
+/** \brief Get the compilation error of a search.
+ *
+ * \param[in] idx  The index of the search.
+ *
+ * \return The error message or an empty string if the regular expression
+ * compiled as expected.
+ */
+std::string const & search_engine::get_error(std::size_t idx) const
+{
+    return f_patterns[idx].f_error;
+}
+
+
+/** \brief Clear the matches before searching another file.
+ */
+void search_engine::reset_matches()
+{
+    f_matches.clear();
+    f_matches.resize(f_patterns.size());
+}
+
+
+/** \brief Search a block of lines.
+ *
+ * The block is expected to be composed of complete lines, each ending
+ * with a newline character, except for the last one which may be a
+ * piece of a very long line.
+ *
+ * \param[in] block  The first character of the block.
+ * \param[in] size  The number of characters in the block.
+ */
+void search_engine::search_block(char const * block, std::size_t size)
+{
+    char const * const end(block + size);
+
+    bool per_line(false);
+    for(auto const & p : f_patterns)
+    {
+        if(p.f_valid
+        && p.f_literals.empty())
+        {
+            per_line = true;
+            break;
+        }
+    }
+
+    // prefilter: look for all the literals in one pass over the block
+    // and only run the regular expressions of the searches with a
+    // literal in a line against that line, once per line
+    //
+    if(f_outputs.size() > 1)
+    {
+        std::vector<char const *> checked(f_patterns.size(), nullptr);
+        char const * line(block);
+        std::uint32_t state(0);
+        for(char const * s(block); s < end; ++s)
+        {
+            state = f_transitions[state * ALPHABET_SIZE + static_cast<unsigned char>(*s)];
+            for(auto const idx : f_outputs[state])
+            {
+                if(checked[idx] == line)
+                {
+                    continue;
+                }
+                checked[idx] = line;
+
+                char const * eol(static_cast<char const *>(memchr(s, '\n', end - s)));
+                if(eol == nullptr)
+                {
+                    eol = end;
+                }
+                if(std::regex_search(line, eol, f_patterns[idx].f_regex))
+                {
+                    record_match(idx, line, eol);
+                }
+            }
+            if(*s == '\n')
+            {
+                line = s + 1;
+            }
+        }
+    }
+
+    if(!per_line)
+    {
+        return;
+    }
+
+    for(char const * line(block); line < end; )
+    {
+        char const * eol(static_cast<char const *>(memchr(line, '\n', end - line)));
+        if(eol == nullptr)
+        {
+            eol = end;
+        }
+        for(std::size_t idx(0); idx < f_patterns.size(); ++idx)
+        {
+            pattern_t const & p(f_patterns[idx]);
+            if(p.f_valid
+            && p.f_literals.empty()
+            && std::regex_search(line, eol, p.f_regex))
+            {
+                record_match(idx, line, eol);
+            }
+        }
+        line = eol + 1;
+    }
+}
+
+
+/** \brief Get the matches found since the last reset_matches().
+ *
+ * \return The matches, one per search.
+ */
+search_engine::match_vector_t const & search_engine::get_matches() const
+{
+    return f_matches;
+}
+
+
+/** \brief Extract the literals of which any match has to include one.
+ *
+ * This function splits \p regex on its top level alternations and
+ * extracts the required literal of each alternative. A line which does
+ * not include any one of the literals cannot match.
+ *
+ * If one of the alternatives does not have a required literal, then the
+ * function returns an empty list, meaning that the regular expression
+ * has to be checked against each line.
+ *
+ * \param[in] regex  The regular expression.
+ *
+ * \return The list of literals, possibly empty.
+ */
+string_list_t search_engine::required_literals(std::string const & regex)
+{
+    string_list_t result;
+    std::size_t const max(regex.length());
+    std::size_t start(0);
+    std::size_t pos(0);
+    for(;;)
+    {
+        if(pos < max
+        && regex[pos] != '|')
+        {
+            switch(regex[pos])
+            {
+            case '\\':
+                pos += 2;
+                break;
+
+            case '(':
+            case '[':
+                skip_block(regex, pos);
+                break;
+
+            default:
+                ++pos;
+                break;
+
+            }
+            continue;
+        }
+
+        std::string const literal(required_literal(regex.substr(start, std::min(pos, max) - start)));
+        if(literal.empty())
+        {
+            return string_list_t();
+        }
+        result.push_back(literal);
+
+        if(pos >= max)
+        {
+            break;
+        }
+        ++pos;
+        start = pos;
+    }
+
+    return result;
+}
+
+
+/** \brief Extract a literal which any match has to include.
+ *
+ * This function parses an ECMAScript regular expression and returns the
+ * longest sequence of characters which any string matching the
+ * expression must include. The parser is conservative: groups, classes,
+ * and characters followed by an optional quantifier break the sequence.
+ * If the expression includes a top level alternation, no literal is
+ * required and the function returns an empty string.
+ *
+ * \param[in] regex  The regular expression.
+ *
+ * \return The longest required literal, possibly empty.
+ */
+std::string search_engine::required_literal(std::string const & regex)
+{
+    std::string best;
+    std::string current;
+    auto flush = [&best, &current]()
+        {
+            if(current.length() > best.length())
+            {
+                best = current;
+            }
+            current.clear();
+        };
+
+    std::size_t const max(regex.length());
+    std::size_t pos(0);
+    while(pos < max)
+    {
+        char c(regex[pos]);
+        switch(c)
+        {
+        case '|':
+            // top level alternation, nothing is required
+            //
+            return std::string();
+
+        case '(':
+        case '[':
+            flush();
+            skip_block(regex, pos);
+            skip_quantifier(regex, pos);
+            continue;
+
+        case '.':
+        case '^':
+        case '$':
+            flush();
+            ++pos;
+            skip_quantifier(regex, pos);
+            continue;
+
+        case '*':
+        case '+':
+        case '?':
+        case '{':
+            flush();
+            skip_quantifier(regex, pos);
+            continue;
+
+        case '\\':
+            if(pos + 1 >= max)
+            {
+                flush();
+                return best;
+            }
+            c = regex[pos + 1];
+            if((c >= '0' && c <= '9')
+            || (c >= 'a' && c <= 'z')
+            || (c >= 'A' && c <= 'Z'))
+            {
+                // character classes (\d, \w...), assertions (\b...),
+                // back references and character codes are not literals
+                //
+                flush();
+                pos += 2;
+                switch(c)
+                {
+                case 'x':
+                    pos += 2;
+                    break;
+
+                case 'u':
+                    pos += 4;
+                    break;
+
+                case 'c':
+                    pos += 1;
+                    break;
+
+                default:
+                    while(pos < max
+                       && c >= '1'
+                       && c <= '9'
+                       && regex[pos] >= '0'
+                       && regex[pos] <= '9')
+                    {
+                        ++pos;
+                    }
+                    break;
+
+                }
+                skip_quantifier(regex, pos);
+                continue;
+            }
+            pos += 2;
+            break;
+
+        default:
+            ++pos;
+            break;
+
+        }
+
+        // c is a literal character, check the quantifier, if any
+        //
+        if(is_optional(regex, pos))
+        {
+            flush();
+            skip_quantifier(regex, pos);
+        }
+        else if(pos < max
+             && (regex[pos] == '+' || regex[pos] == '{'))
+        {
+            current += c;
+            flush();
+            skip_quantifier(regex, pos);
+        }
+        else
+        {
+            current += c;
+        }
+    }
+    flush();
+
+    return best;
+}
+
+
+/** \brief Record one match.
+ *
+ * \param[in] idx  The index of the search which matched.
+ * \param[in] line  The start of the line which matched.
+ * \param[in] end  The end of the line.
+ */
+void search_engine::record_match(
+      std::size_t idx
+    , char const * line
+    , char const * end)
+{
+    match_t & m(f_matches[idx]);
+    if(m.f_count == 0)
+    {
+        m.f_first_line.assign(line, std::min(static_cast<std::size_t>(end - line), MAXIMUM_LINE_LENGTH));
+    }
+    ++m.f_count;
+}
+
+
+
+} // namespace log
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,99 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    "search.h"
+
+
+// C++
+//
+#include    <cstdint>
+#include    <regex>
+
+
+
+namespace sitter
+{
+namespace log
+{
+
+
+
+typedef std::vector<std::string>    string_list_t;
+
+
+class search_engine
+{
+public:
+    static constexpr std::size_t const  MAXIMUM_LINE_LENGTH = 256;
+
+    struct match_t
+    {
+        std::size_t             f_count = 0;
+        std::string             f_first_line = std::string();
+    };
+    typedef std::vector<match_t>        match_vector_t;
+
+    void                        compile(search::vector_t const & searches);
+    std::size_t                 size() const;
+    search const &              get_search(std::size_t idx) const;
+    std::string const &         get_error(std::size_t idx) const;
+
+    void                        reset_matches();
+    void                        search_block(char const * block, std::size_t size);
+    match_vector_t const &      get_matches() const;
+
+    static std::string          required_literal(std::string const & regex);
+    static string_list_t        required_literals(std::string const & regex);
+
+private:
+    struct pattern_t
+    {
+        search                  f_search = search(std::string(), std::string(), std::string());
+        std::regex              f_regex = std::regex();
+        string_list_t           f_literals = string_list_t();
+        std::string             f_error = std::string();
+        bool                    f_valid = false;
+    };
+    typedef std::vector<pattern_t>      pattern_vector_t;
+
+    typedef std::vector<std::size_t>    index_list_t;
+    typedef std::vector<index_list_t>   output_vector_t;
+
+    static constexpr std::size_t const  ALPHABET_SIZE = 256;
+
+    void                        build_prefilter();
+    void                        record_match(
+                                      std::size_t idx
+                                    , char const * line
+                                    , char const * end);
+
+    std::string                 f_signature = std::string();
+    pattern_vector_t            f_patterns = pattern_vector_t();
+    match_vector_t              f_matches = match_vector_t();
+    std::vector<std::uint32_t>  f_transitions = std::vector<std::uint32_t>();
+    output_vector_t             f_outputs = output_vector_t();
+};
+
+
+
+} // namespace log
+} // namespace sitter
+// vim: ts=4 sw=4 et
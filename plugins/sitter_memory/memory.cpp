@@ -124,10 +124,11 @@ void memory::on_process_watch(as2js::json::json_value_ref & json)
             }());
     if(high_memory_usage)
     {
-        plugins()->get_server<sitter::server>()->append_error(
+        sitter::server::pointer_t server(plugins()->get_server<sitter::server>());
+        server->append_error(
               e
             , "memory"
-            , "High memory usage"
+            , "High memory usage." + server->output_top_processes(e, resource_t::RESOURCE_RSS)
             , 75);
     }
 
@@ -141,10 +142,11 @@ void memory::on_process_watch(as2js::json::json_value_ref & json)
             }());
     if(high_swap_usage)
     {
-        plugins()->get_server<sitter::server>()->append_error(
+        sitter::server::pointer_t server(plugins()->get_server<sitter::server>());
+        server->append_error(
               e
             , "memory"
-            , "High swap usage"
+            , "High swap usage." + server->output_top_processes(e, resource_t::RESOURCE_SWAP)
             , 65);
     }
 
@@ -0,0 +1,182 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "interface_stats.h"
+
+
+// sitter
+//
+#include    <sitter/monotonic_clock.h>
+
+
+// snapdev
+//
+#include    <snapdev/file_contents.h>
+#include    <snapdev/trim_string.h>
+
+
+// C++
+//
+#include    <sstream>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the network interface statistics.
+ *
+ * The kernel keeps counters of the bytes, packets, errors, and drops
+ * received and transmitted by each network interface in /proc/net/dev.
+ * These counters are totals since the interface was created so we keep
+ * the previous sample and compute the values over the last interval.
+ */
+
+
+
+namespace sitter
+{
+namespace network
+{
+
+
+
+namespace
+{
+
+
+
+std::uint64_t delta(std::uint64_t current, std::uint64_t previous)
+{
+    // the counters restart at zero when an interface gets re-created
+    //
+    return current >= previous ? current - previous : 0;
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Read /proc/net/dev and compute the interval values.
+ *
+ * The first call only loads the counters. The following calls also
+ * compute the rates since the previous call.
+ */
+void interface_stats::refresh()
+{
+    f_interfaces.clear();
+
+    snapdev::file_contents dev("/proc/net/dev");
+    if(!dev.read_all())
+    {
+        return;
+    }
+
+    double const now(monotonic_seconds());
+    double const elapsed(f_previous_time > 0.0 ? now - f_previous_time : 0.0);
+
+    std::istringstream in(dev.contents());
+    std::string line;
+    while(std::getline(in, line))
+    {
+        // the first two lines are headers and do not include a ':'
+        //
+        std::string::size_type const colon(line.find(':'));
+        if(colon == std::string::npos)
+        {
+            continue;
+        }
+
+        interface_t i;
+        i.f_name = snapdev::trim_string(line.substr(0, colon));
+
+        std::uint64_t ignore(0);
+        std::istringstream fields(line.substr(colon + 1));
+        fields >> i.f_rx_bytes
+               >> i.f_rx_packets
+               >> i.f_rx_errors
+               >> i.f_rx_dropped
+               >> ignore            // fifo
+               >> ignore            // frame
+               >> ignore            // compressed
+               >> ignore            // multicast
+               >> i.f_tx_bytes
+               >> i.f_tx_packets
+               >> i.f_tx_errors
+               >> i.f_tx_dropped;
+        if(fields.fail())
+        {
+            continue;
+        }
+
+        auto const previous(f_previous.find(i.f_name));
+        if(previous != f_previous.end()
+        && elapsed > 0.0)
+        {
+            interface_t const & p(previous->second);
+
+            i.f_has_rates = true;
+            i.f_interval = elapsed;
+            i.f_rx_new_packets = delta(i.f_rx_packets, p.f_rx_packets);
+            i.f_tx_new_packets = delta(i.f_tx_packets, p.f_tx_packets);
+            i.f_rx_byte_rate = static_cast<double>(delta(i.f_rx_bytes, p.f_rx_bytes)) / elapsed;
+            i.f_tx_byte_rate = static_cast<double>(delta(i.f_tx_bytes, p.f_tx_bytes)) / elapsed;
+            i.f_rx_packet_rate = static_cast<double>(i.f_rx_new_packets) / elapsed;
+            i.f_tx_packet_rate = static_cast<double>(i.f_tx_new_packets) / elapsed;
+            i.f_rx_new_errors = delta(i.f_rx_errors, p.f_rx_errors);
+            i.f_tx_new_errors = delta(i.f_tx_errors, p.f_tx_errors);
+            i.f_rx_new_dropped = delta(i.f_rx_dropped, p.f_rx_dropped);
+            i.f_tx_new_dropped = delta(i.f_tx_dropped, p.f_tx_dropped);
+        }
+
+        f_interfaces.push_back(i);
+    }
+
+    f_previous.clear();
+    for(auto const & i : f_interfaces)
+    {
+        f_previous[i.f_name] = i;
+    }
+    f_previous_time = now;
+}
+
+
+/** \brief Get the interfaces found by the last refresh().
+ *
+ * \return A reference to the list of interfaces.
+ */
+interface_vector_t const & interface_stats::get_interfaces() const
+{
+    return f_interfaces;
+}
+
+
+
+} // namespace network
+} // namespace sitter
+// vim: ts=4 sw=4 et
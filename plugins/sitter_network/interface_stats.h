@@ -0,0 +1,85 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <cstdint>
+#include    <map>
+#include    <string>
+#include    <vector>
+
+
+
+namespace sitter
+{
+namespace network
+{
+
+
+
+struct interface_t
+{
+    // raw counters as found in /proc/net/dev
+    //
+    std::string                 f_name = std::string();
+    std::uint64_t               f_rx_bytes = 0;
+    std::uint64_t               f_rx_packets = 0;
+    std::uint64_t               f_rx_errors = 0;
+    std::uint64_t               f_rx_dropped = 0;
+    std::uint64_t               f_tx_bytes = 0;
+    std::uint64_t               f_tx_packets = 0;
+    std::uint64_t               f_tx_errors = 0;
+    std::uint64_t               f_tx_dropped = 0;
+
+    // interval values, valid only when f_has_rates is true
+    //
+    bool                        f_has_rates = false;
+    double                      f_interval = 0.0;           // seconds
+    double                      f_rx_byte_rate = 0.0;       // bytes per second
+    double                      f_tx_byte_rate = 0.0;
+    double                      f_rx_packet_rate = 0.0;     // packets per second
+    double                      f_tx_packet_rate = 0.0;
+    std::uint64_t               f_rx_new_packets = 0;
+    std::uint64_t               f_tx_new_packets = 0;
+    std::uint64_t               f_rx_new_errors = 0;
+    std::uint64_t               f_tx_new_errors = 0;
+    std::uint64_t               f_rx_new_dropped = 0;
+    std::uint64_t               f_tx_new_dropped = 0;
+};
+typedef std::vector<interface_t>    interface_vector_t;
+
+
+class interface_stats
+{
+public:
+    void                        refresh();
+    interface_vector_t const &  get_interfaces() const;
+
+private:
+    interface_vector_t          f_interfaces = interface_vector_t();
+    std::map<std::string, interface_t>
+                                f_previous = std::map<std::string, interface_t>();
+    double                      f_previous_time = 0.0;
+};
+
+
+
+} // namespace network
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,377 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "kernel_counters.h"
+
+
+// sitter
+//
+#include    <sitter/monotonic_clock.h>
+
+
+// snapdev
+//
+#include    <snapdev/file_contents.h>
+
+
+// C
+//
+#include    <stdlib.h>
+#include    <string.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the kernel networking counters.
+ *
+ * The /proc/net/snmp and /proc/net/netstat files include hundreds of
+ * counters. Each section is defined on two lines: the first line lists
+ * the names of the counters and the second line their values, both
+ * lines starting with the name of the section (i.e. "Tcp:").
+ *
+ * We are only interested in a few of those counters so they are defined
+ * in a fixed table. The parser walks the files in place and saves the
+ * values in a fixed size array; no map and no per counter allocation.
+ *
+ * The conntrack counters are only available when the nf_conntrack
+ * module is loaded.
+ */
+
+
+
+namespace sitter
+{
+namespace network
+{
+
+
+
+namespace
+{
+
+
+
+struct counter_definition_t
+{
+    counter_t               f_counter = COUNTER_MAX;
+    char const *            f_section = nullptr;
+    char const *            f_name = nullptr;
+};
+
+
+constexpr counter_definition_t const g_counters[] =
+{
+    { COUNTER_IP_IN_DISCARDS,               "Ip",       "InDiscards" },
+    { COUNTER_IP_OUT_DISCARDS,              "Ip",       "OutDiscards" },
+    { COUNTER_TCP_ACTIVE_OPENS,             "Tcp",      "ActiveOpens" },
+    { COUNTER_TCP_PASSIVE_OPENS,            "Tcp",      "PassiveOpens" },
+    { COUNTER_TCP_ATTEMPT_FAILS,            "Tcp",      "AttemptFails" },
+    { COUNTER_TCP_ESTAB_RESETS,             "Tcp",      "EstabResets" },
+    { COUNTER_TCP_IN_SEGS,                  "Tcp",      "InSegs" },
+    { COUNTER_TCP_OUT_SEGS,                 "Tcp",      "OutSegs" },
+    { COUNTER_TCP_RETRANS_SEGS,             "Tcp",      "RetransSegs" },
+    { COUNTER_TCP_IN_ERRS,                  "Tcp",      "InErrs" },
+    { COUNTER_TCP_OUT_RSTS,                 "Tcp",      "OutRsts" },
+    { COUNTER_UDP_NO_PORTS,                 "Udp",      "NoPorts" },
+    { COUNTER_UDP_IN_ERRORS,                "Udp",      "InErrors" },
+    { COUNTER_UDP_RCVBUF_ERRORS,            "Udp",      "RcvbufErrors" },
+    { COUNTER_UDP_SNDBUF_ERRORS,            "Udp",      "SndbufErrors" },
+    { COUNTER_TCPEXT_SYNCOOKIES_SENT,       "TcpExt",   "SyncookiesSent" },
+    { COUNTER_TCPEXT_LISTEN_OVERFLOWS,      "TcpExt",   "ListenOverflows" },
+    { COUNTER_TCPEXT_LISTEN_DROPS,          "TcpExt",   "ListenDrops" },
+    { COUNTER_TCPEXT_TCP_TIMEOUTS,          "TcpExt",   "TCPTimeouts" },
+    { COUNTER_TCPEXT_TCP_BACKLOG_DROP,      "TcpExt",   "TCPBacklogDrop" },
+    { COUNTER_TCPEXT_TCP_REQ_Q_FULL_DROP,   "TcpExt",   "TCPReqQFullDrop" },
+    { COUNTER_TCPEXT_TCP_SYN_RETRANS,       "TcpExt",   "TCPSynRetrans" },
+};
+
+static_assert(sizeof(g_counters) / sizeof(g_counters[0]) == COUNTER_MAX
+            , "the g_counters table must define all the counters");
+
+
+bool same_word(char const * s, std::size_t len, char const * word)
+{
+    return strlen(word) == len
+        && strncmp(s, word, len) == 0;
+}
+
+
+counter_t find_counter(
+      char const * section
+    , std::size_t section_len
+    , char const * name
+    , std::size_t name_len)
+{
+    for(auto const & c : g_counters)
+    {
+        if(same_word(section, section_len, c.f_section)
+        && same_word(name, name_len, c.f_name))
+        {
+            return c.f_counter;
+        }
+    }
+    return COUNTER_MAX;
+}
+
+
+std::int64_t read_number(char const * filename)
+{
+    snapdev::file_contents file(filename);
+    if(!file.read_all())
+    {
+        return kernel_counters::NO_CONNTRACK;
+    }
+    return strtoll(file.contents().c_str(), nullptr, 10);
+}
+
+
+char const * skip_spaces(char const * s, char const * end)
+{
+    while(s < end && *s == ' ')
+    {
+        ++s;
+    }
+    return s;
+}
+
+
+char const * end_of_word(char const * s, char const * end)
+{
+    while(s < end && *s != ' ' && *s != '\n')
+    {
+        ++s;
+    }
+    return s;
+}
+
+
+char const * end_of_line(char const * s, char const * end)
+{
+    while(s < end && *s != '\n')
+    {
+        ++s;
+    }
+    return s;
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Read the counters and compute the deltas.
+ *
+ * The first call only loads the counters. The following calls also
+ * make the deltas since the previous call available.
+ */
+void kernel_counters::refresh()
+{
+    double const now(monotonic_seconds());
+
+    f_previous = f_values;
+    f_values.fill(0);
+
+    snapdev::file_contents snmp("/proc/net/snmp");
+    if(snmp.read_all())
+    {
+        parse(snmp.contents());
+    }
+    snapdev::file_contents netstat("/proc/net/netstat");
+    if(netstat.read_all())
+    {
+        parse(netstat.contents());
+    }
+
+    f_conntrack_count = read_number("/proc/sys/net/netfilter/nf_conntrack_count");
+    f_conntrack_max = read_number("/proc/sys/net/netfilter/nf_conntrack_max");
+
+    f_has_previous = f_previous_time > 0.0;
+    f_interval = f_has_previous ? now - f_previous_time : 0.0;
+    f_previous_time = now;
+}
+
+
+/** \brief Check whether the deltas are available.
+ *
+ * \return true if refresh() was called at least twice.
+ */
+bool kernel_counters::has_deltas() const
+{
+    return f_has_previous;
+}
+
+
+/** \brief Get the time between the last two refresh() calls.
+ *
+ * \return The number of seconds.
+ */
+double kernel_counters::get_interval() const
+{
+    return f_interval;
+}
+
+
+/** \brief Get the current value of a counter.
+ *
+ * \param[in] counter  The counter to retrieve.
+ *
+ * \return The value of the counter.
+ */
+std::uint64_t kernel_counters::get_value(counter_t counter) const
+{
+    return f_values[counter];
+}
+
+
+/** \brief Get the increase of a counter since the previous refresh().
+ *
+ * \param[in] counter  The counter to retrieve.
+ *
+ * \return The delta or 0 if not available.
+ */
+std::uint64_t kernel_counters::get_delta(counter_t counter) const
+{
+    if(!f_has_previous
+    || f_values[counter] < f_previous[counter])
+    {
+        return 0;
+    }
+    return f_values[counter] - f_previous[counter];
+}
+
+
+/** \brief Get the number of entries in the conntrack table.
+ *
+ * \return The number of entries or NO_CONNTRACK.
+ */
+std::int64_t kernel_counters::get_conntrack_count() const
+{
+    return f_conntrack_count;
+}
+
+
+/** \brief Get the size of the conntrack table.
+ *
+ * \return The maximum number of entries or NO_CONNTRACK.
+ */
+std::int64_t kernel_counters::get_conntrack_max() const
+{
+    return f_conntrack_max;
+}
+
+
+/** \brief Get the name of a counter.
+ *
+ * \param[in] counter  The counter.
+ *
+ * \return The name of the counter as found in the /proc file.
+ */
+char const * kernel_counters::counter_name(counter_t counter)
+{
+    if(counter >= COUNTER_MAX)
+    {
+        return "unknown";
+    }
+    return g_counters[counter].f_name;
+}
+
+
+/** \brief Parse one of the snmp or netstat files.
+ *
+ * Each section uses two lines. The names of the first line are matched
+ * against the table of counters and the values of the second line are
+ * saved at the corresponding position.
+ *
+ * \param[in] contents  The contents of the file.
+ */
+void kernel_counters::parse(std::string const & contents)
+{
+    char const * s(contents.data());
+    char const * const end(s + contents.length());
+    while(s < end)
+    {
+        char const * const names(s);
+        char const * const names_end(end_of_line(s, end));
+        if(names_end >= end)
+        {
+            return;
+        }
+        char const * const values(names_end + 1);
+        char const * const values_end(end_of_line(values, end));
+        s = values_end + 1;
+
+        char const * colon(static_cast<char const *>(memchr(names, ':', names_end - names)));
+        if(colon == nullptr)
+        {
+            continue;
+        }
+        std::size_t const section_len(colon - names);
+        if(static_cast<std::size_t>(values_end - values) <= section_len
+        || strncmp(names, values, section_len) != 0)
+        {
+            // the two lines do not belong to the same section
+            //
+            s = values;
+            continue;
+        }
+
+        char const * n(colon + 1);
+        char const * v(values + section_len + 1);
+        for(;;)
+        {
+            n = skip_spaces(n, names_end);
+            v = skip_spaces(v, values_end);
+            if(n >= names_end
+            || v >= values_end)
+            {
+                break;
+            }
+            char const * const n_end(end_of_word(n, names_end));
+            char const * const v_end(end_of_word(v, values_end));
+
+            counter_t const counter(find_counter(names, section_len, n, n_end - n));
+            if(counter != COUNTER_MAX)
+            {
+                // some values can be negative (i.e. MaxConn is -1) but
+                // none of the counters we keep
+                //
+                f_values[counter] = strtoull(v, nullptr, 10);
+            }
+
+            n = n_end;
+            v = v_end;
+        }
+    }
+}
+
+
+
+} // namespace network
+} // namespace sitter
+// vim: ts=4 sw=4 et
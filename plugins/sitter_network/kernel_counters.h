@@ -0,0 +1,97 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <array>
+#include    <cstdint>
+#include    <string>
+
+
+
+namespace sitter
+{
+namespace network
+{
+
+
+
+enum counter_t
+{
+    COUNTER_IP_IN_DISCARDS,
+    COUNTER_IP_OUT_DISCARDS,
+    COUNTER_TCP_ACTIVE_OPENS,
+    COUNTER_TCP_PASSIVE_OPENS,
+    COUNTER_TCP_ATTEMPT_FAILS,
+    COUNTER_TCP_ESTAB_RESETS,
+    COUNTER_TCP_IN_SEGS,
+    COUNTER_TCP_OUT_SEGS,
+    COUNTER_TCP_RETRANS_SEGS,
+    COUNTER_TCP_IN_ERRS,
+    COUNTER_TCP_OUT_RSTS,
+    COUNTER_UDP_NO_PORTS,
+    COUNTER_UDP_IN_ERRORS,
+    COUNTER_UDP_RCVBUF_ERRORS,
+    COUNTER_UDP_SNDBUF_ERRORS,
+    COUNTER_TCPEXT_SYNCOOKIES_SENT,
+    COUNTER_TCPEXT_LISTEN_OVERFLOWS,
+    COUNTER_TCPEXT_LISTEN_DROPS,
+    COUNTER_TCPEXT_TCP_TIMEOUTS,
+    COUNTER_TCPEXT_TCP_BACKLOG_DROP,
+    COUNTER_TCPEXT_TCP_REQ_Q_FULL_DROP,
+    COUNTER_TCPEXT_TCP_SYN_RETRANS,
+
+    COUNTER_MAX
+};
+
+typedef std::array<std::uint64_t, COUNTER_MAX>      counter_values_t;
+
+
+class kernel_counters
+{
+public:
+    static constexpr std::int64_t const NO_CONNTRACK = -1;
+
+    void                        refresh();
+    bool                        has_deltas() const;
+    double                      get_interval() const;
+    std::uint64_t               get_value(counter_t counter) const;
+    std::uint64_t               get_delta(counter_t counter) const;
+    std::int64_t                get_conntrack_count() const;
+    std::int64_t                get_conntrack_max() const;
+
+    static char const *         counter_name(counter_t counter);
+
+private:
+    void                        parse(std::string const & contents);
+
+    counter_values_t            f_values = counter_values_t();
+    counter_values_t            f_previous = counter_values_t();
+    bool                        f_has_previous = false;
+    double                      f_previous_time = 0.0;
+    double                      f_interval = 0.0;
+    std::int64_t                f_conntrack_count = NO_CONNTRACK;
+    std::int64_t                f_conntrack_max = NO_CONNTRACK;
+};
+
+
+
+} // namespace network
+} // namespace sitter
+// vim: ts=4 sw=4 et
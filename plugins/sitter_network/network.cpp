@@ -20,6 +20,12 @@
 // self
 //
 #include    "network.h"
+#include    "names.h"
+
+
+// sitter
+//
+#include    <sitter/monotonic_clock.h>
 
 
 // cppprocess
@@ -34,8 +40,10 @@
 
 // snapdev
 //
+#include    <snapdev/gethostname.h>
 #include    <snapdev/not_used.h>
 #include    <snapdev/not_reached.h>
+#include    <snapdev/timespec_ex.h>
 
 
 // serverplugins
@@ -43,6 +51,14 @@
 #include    <serverplugins/collection.h>
 
 
+// C++
+//
+#include    <algorithm>
+#include    <iomanip>
+#include    <map>
+#include    <sstream>
+
+
 // last include
 //
 #include    <snapdev/poison.h>
@@ -67,6 +83,28 @@ SERVERPLUGINS_END(network)
 
 
 
+namespace
+{
+
+
+
+constexpr std::int64_t const    DEFAULT_CONNTRACK_THRESHOLD = 90;   // percent
+constexpr std::int64_t const    DEFAULT_RETRANSMIT_THRESHOLD = 5;   // percent
+
+
+std::string format_double(double value)
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1) << value;
+    return ss.str();
+}
+
+
+
+} // no name namespace
+
+
+
 
 
 /** \brief Initialize network.
@@ -93,6 +131,12 @@ void network::on_process_watch(as2js::json::json_value_ref & json)
         << SNAP_LOG_SEND;
 
     as2js::json::json_value_ref results(json["network"]);
+
+    check_interfaces(results);
+    check_link_events(results);
+    check_sockets(results);
+    check_kernel_counters(results);
+
     if(find_communicatord(results))
     {
         // communicatord is running, it should have been giving us
@@ -122,8 +166,10 @@ void network::on_process_watch(as2js::json::json_value_ref & json)
 
 bool network::find_communicatord(as2js::json::json_value_ref & json)
 {
-    cppprocess::process_list list;
-    cppprocess::process_info::pointer_t info(list.find("communicatord"));
+    // the server keeps a pidfd on communicatord once found so this
+    // does not scan /proc on each tick
+    //
+    cppprocess::process_info::pointer_t info(plugins()->get_server<sitter::server>()->find_process("communicatord"));
 
     // TODO: check whether the service is disabled if the output_process()
     //       function returns false; but really for communicatord that
@@ -214,6 +260,396 @@ bool network::verify_communicatord_connection(as2js::json::json_value_ref & json
 
 
 
+/** \brief Check the counters of each network interface.
+ *
+ * This function saves the counters of each interface along the rates
+ * computed over the last interval. Receive and transmit errors generate
+ * an error. Dropped packets generate an error when they represent 1% or
+ * more of the packets of the interval.
+ *
+ * \param[in] json  The "network" object.
+ */
+void network::check_interfaces(as2js::json::json_value_ref & json)
+{
+    f_interface_stats.refresh();
+
+    for(auto const & i : f_interface_stats.get_interfaces())
+    {
+        as2js::json::json_value_ref iface(json["interface"][-1]);
+        iface["name"] = i.f_name;
+        iface["rx_bytes"] = i.f_rx_bytes;
+        iface["rx_packets"] = i.f_rx_packets;
+        iface["rx_errors"] = i.f_rx_errors;
+        iface["rx_dropped"] = i.f_rx_dropped;
+        iface["tx_bytes"] = i.f_tx_bytes;
+        iface["tx_packets"] = i.f_tx_packets;
+        iface["tx_errors"] = i.f_tx_errors;
+        iface["tx_dropped"] = i.f_tx_dropped;
+
+        if(!i.f_has_rates)
+        {
+            continue;
+        }
+
+        iface["rx_byte_rate"] = i.f_rx_byte_rate;
+        iface["tx_byte_rate"] = i.f_tx_byte_rate;
+        iface["rx_packet_rate"] = i.f_rx_packet_rate;
+        iface["tx_packet_rate"] = i.f_tx_packet_rate;
+
+        if(i.f_rx_new_errors != 0
+        || i.f_tx_new_errors != 0)
+        {
+            iface["error"] = "errors";
+            plugins()->get_server<sitter::server>()->append_error(
+                  json
+                , "network"
+                , "network interface \""
+                    + i.f_name
+                    + "\" on \""
+                    + snapdev::gethostname()
+                    + "\" had "
+                    + std::to_string(i.f_rx_new_errors)
+                    + " receive errors and "
+                    + std::to_string(i.f_tx_new_errors)
+                    + " transmit errors in the last "
+                    + std::to_string(static_cast<std::int64_t>(i.f_interval))
+                    + " seconds."
+                , 40);
+        }
+
+        // a few drops on a nearly idle interface (i.e. an unsupported
+        // protocol received on the LAN) do not mean anything
+        //
+        std::uint64_t const dropped(i.f_rx_new_dropped + i.f_tx_new_dropped);
+        std::uint64_t const packets(i.f_rx_new_packets + i.f_tx_new_packets);
+        if(dropped != 0
+        && packets + dropped >= DROP_MINIMUM_PACKETS
+        && dropped * 100 >= packets)
+        {
+            iface["error"] = "dropped packets";
+            plugins()->get_server<sitter::server>()->append_error(
+                  json
+                , "network"
+                , "network interface \""
+                    + i.f_name
+                    + "\" on \""
+                    + snapdev::gethostname()
+                    + "\" dropped "
+                    + std::to_string(dropped)
+                    + " packets out of "
+                    + std::to_string(packets + dropped)
+                    + " in the last "
+                    + std::to_string(static_cast<std::int64_t>(i.f_interval))
+                    + " seconds."
+                , 30);
+        }
+    }
+}
+
+
+/** \brief Report the link state changes.
+ *
+ * The link monitor records the interfaces going up and down as it
+ * happens. This function saves those events and generates an error for
+ * each interface which went down since the last tick. An interface
+ * which went down several times (flapping) gets a higher priority.
+ *
+ * \param[in] json  The "network" object.
+ */
+void network::check_link_events(as2js::json::json_value_ref & json)
+{
+    sitter::server::pointer_t server(plugins()->get_server<sitter::server>());
+    link_monitor::pointer_t monitor(server->get_link_monitor());
+    if(monitor == nullptr)
+    {
+        return;
+    }
+
+    struct link_summary_t
+    {
+        int             f_downs = 0;
+        bool            f_up = true;
+        time_t          f_last_down = 0;
+    };
+    std::map<std::string, link_summary_t> links;
+
+    link_monitor::link_event_vector_t const events(monitor->get_events());
+    for(auto const & ev : events)
+    {
+        as2js::json::json_value_ref e(json["link_event"][-1]);
+        e["name"] = ev.f_name;
+        e["state"] = ev.f_up ? "up" : "down";
+        e["date"] = ev.f_date;
+
+        link_summary_t & l(links[ev.f_name]);
+        l.f_up = ev.f_up;
+        if(!ev.f_up)
+        {
+            ++l.f_downs;
+            l.f_last_down = ev.f_date;
+        }
+    }
+
+    for(auto const & l : links)
+    {
+        if(l.second.f_downs == 0)
+        {
+            continue;
+        }
+
+        std::string const date(snapdev::timespec_ex(l.second.f_last_down, 0).to_string());
+        std::string message("network interface \""
+                + l.first
+                + "\" on \""
+                + snapdev::gethostname()
+                + "\" ");
+        if(l.second.f_up)
+        {
+            message += "went down "
+                    + std::to_string(l.second.f_downs)
+                    + " time(s) since the last check (last time on "
+                    + date
+                    + ") and is now back up.";
+        }
+        else
+        {
+            message += "is down since "
+                    + date
+                    + '.';
+        }
+
+        int priority(l.second.f_up ? 50 : 65);
+        if(l.second.f_downs >= 3)
+        {
+            // flapping
+            //
+            priority = 75;
+        }
+        server->append_error(json, "network", message, priority);
+    }
+}
+
+
+
+/** \brief Check the state of the TCP sockets.
+ *
+ * This function counts the TCP sockets by state and checks the accept
+ * queue of each listening socket. A queue which reaches 90% of its
+ * backlog means the service does not accept connections fast enough.
+ *
+ * The number of sockets in CLOSE_WAIT is also tracked over the last
+ * CLOSE_WAIT_PERIOD seconds. When it keeps growing, a service does not
+ * close its sockets once the other side closed the connection (a leak).
+ *
+ * \param[in] json  The "network" object.
+ */
+void network::check_sockets(as2js::json::json_value_ref & json)
+{
+    if(!f_socket_stats.refresh())
+    {
+        return;
+    }
+
+    sitter::server::pointer_t server(plugins()->get_server<sitter::server>());
+
+    as2js::json::json_value_ref sockets(json["socket"]);
+    state_counts_t const & counts(f_socket_stats.get_state_counts());
+    for(int state(TCP_STATE_ESTABLISHED); state < TCP_STATE_MAX; ++state)
+    {
+        sockets[socket_stats::state_name(state)] = counts[state];
+    }
+
+    for(auto const & l : f_socket_stats.get_listeners())
+    {
+        as2js::json::json_value_ref listener(json["listener"][-1]);
+        listener["address"] = l.f_address;
+        listener["port"] = l.f_port;
+        listener["queue"] = l.f_queue;
+        listener["backlog"] = l.f_backlog;
+
+        if(l.f_backlog != 0
+        && l.f_queue * 10 >= l.f_backlog * 9)
+        {
+            listener["error"] = "accept queue full";
+            server->append_error(
+                  json
+                , "network"
+                , "the accept queue of "
+                    + l.f_address
+                    + " port "
+                    + std::to_string(l.f_port)
+                    + " on \""
+                    + snapdev::gethostname()
+                    + "\" has "
+                    + std::to_string(l.f_queue)
+                    + " connections waiting out of a backlog of "
+                    + std::to_string(l.f_backlog)
+                    + "."
+                , 60);
+        }
+    }
+
+    // keep the samples of the last CLOSE_WAIT_PERIOD seconds plus the
+    // one just before so the window covers the whole period
+    //
+    double const now(monotonic_seconds());
+    f_close_wait.push_back(std::make_pair(now, counts[TCP_STATE_CLOSE_WAIT]));
+    while(f_close_wait.size() > 2
+       && now - f_close_wait[1].first >= CLOSE_WAIT_PERIOD)
+    {
+        f_close_wait.pop_front();
+    }
+    if(f_close_wait.size() >= CLOSE_WAIT_MINIMUM_SAMPLES
+    && now - f_close_wait.front().first >= CLOSE_WAIT_PERIOD
+    && std::adjacent_find(
+              f_close_wait.begin()
+            , f_close_wait.end()
+            , [](auto const & a, auto const & b)
+            {
+                return a.second >= b.second;
+            }) == f_close_wait.end()
+    && f_close_wait.back().second - f_close_wait.front().second >= CLOSE_WAIT_MINIMUM_GROWTH)
+    {
+        sockets["error"] = "close_wait growing";
+        server->append_error(
+              json
+            , "network"
+            , "the number of sockets in CLOSE_WAIT on \""
+                + snapdev::gethostname()
+                + "\" went from "
+                + std::to_string(f_close_wait.front().second)
+                + " to "
+                + std::to_string(f_close_wait.back().second)
+                + " in the last "
+                + std::to_string(static_cast<std::int64_t>((now - f_close_wait.front().first) / 60.0))
+                + " minutes; a service is likely not closing its connections."
+            , 45);
+    }
+}
+
+
+
+/** \brief Check the kernel networking counters.
+ *
+ * This function reads the IP, TCP, and UDP counters maintained by the
+ * kernel (/proc/net/snmp and /proc/net/netstat) and the usage of the
+ * connection tracking table.
+ *
+ * The following generate errors:
+ *
+ * \li connections dropped because the accept queue of a listening
+ * socket overflowed (ListenOverflows and ListenDrops);
+ * \li a percentage of retransmitted TCP segments over the interval
+ * larger than the network_retransmit_threshold parameter;
+ * \li a conntrack table filled at network_conntrack_threshold percent
+ * or more; once full, the kernel drops new connections.
+ *
+ * \param[in] json  The "network" object.
+ */
+void network::check_kernel_counters(as2js::json::json_value_ref & json)
+{
+    f_kernel_counters.refresh();
+
+    sitter::server::pointer_t server(plugins()->get_server<sitter::server>());
+
+    as2js::json::json_value_ref kernel(json["kernel"]);
+    for(int c(0); c < COUNTER_MAX; ++c)
+    {
+        counter_t const counter(static_cast<counter_t>(c));
+        kernel[kernel_counters::counter_name(counter)] = f_kernel_counters.get_value(counter);
+    }
+
+    std::int64_t const conntrack_count(f_kernel_counters.get_conntrack_count());
+    std::int64_t const conntrack_max(f_kernel_counters.get_conntrack_max());
+    if(conntrack_count != kernel_counters::NO_CONNTRACK
+    && conntrack_max > 0)
+    {
+        kernel["conntrack_count"] = conntrack_count;
+        kernel["conntrack_max"] = conntrack_max;
+
+        std::int64_t const threshold(server->get_integer_parameter(g_name_network_conntrack_threshold, DEFAULT_CONNTRACK_THRESHOLD));
+        if(threshold > 0
+        && conntrack_count * 100 >= conntrack_max * threshold)
+        {
+            bool const full(conntrack_count >= conntrack_max);
+            kernel["error"] = full ? "conntrack table full" : "conntrack table filling up";
+            server->append_error(
+                  json
+                , "network"
+                , "the connection tracking table on \""
+                    + snapdev::gethostname()
+                    + "\" has "
+                    + std::to_string(conntrack_count)
+                    + " entries out of "
+                    + std::to_string(conntrack_max)
+                    + (full
+                        ? "; new connections are being dropped."
+                        : "; new connections will be dropped once it is full.")
+                , full ? 90 : 70);
+        }
+    }
+
+    if(!f_kernel_counters.has_deltas())
+    {
+        return;
+    }
+
+    std::string const interval(std::to_string(static_cast<std::int64_t>(f_kernel_counters.get_interval())));
+
+    std::uint64_t const overflows(f_kernel_counters.get_delta(COUNTER_TCPEXT_LISTEN_OVERFLOWS));
+    std::uint64_t const drops(f_kernel_counters.get_delta(COUNTER_TCPEXT_LISTEN_DROPS));
+    if(overflows != 0
+    || drops != 0)
+    {
+        kernel["error"] = "listen overflows";
+        server->append_error(
+              json
+            , "network"
+            , "the accept queue of a listening socket on \""
+                + snapdev::gethostname()
+                + "\" overflowed "
+                + std::to_string(overflows)
+                + " times and "
+                + std::to_string(drops)
+                + " incoming connections were dropped in the last "
+                + interval
+                + " seconds."
+            , 55);
+    }
+
+    std::uint64_t const out_segments(f_kernel_counters.get_delta(COUNTER_TCP_OUT_SEGS));
+    std::uint64_t const retransmitted(f_kernel_counters.get_delta(COUNTER_TCP_RETRANS_SEGS));
+    if(out_segments >= RETRANSMIT_MINIMUM_SEGMENTS)
+    {
+        double const rate(static_cast<double>(retransmitted) * 100.0 / static_cast<double>(out_segments));
+        kernel["retransmit_rate"] = rate;
+
+        std::int64_t const threshold(server->get_integer_parameter(g_name_network_retransmit_threshold, DEFAULT_RETRANSMIT_THRESHOLD));
+        if(threshold > 0
+        && rate >= static_cast<double>(threshold))
+        {
+            kernel["error"] = "high retransmit rate";
+            server->append_error(
+                  json
+                , "network"
+                , "TCP on \""
+                    + snapdev::gethostname()
+                    + "\" retransmitted "
+                    + format_double(rate)
+                    + "% of its segments ("
+                    + std::to_string(retransmitted)
+                    + " out of "
+                    + std::to_string(out_segments)
+                    + ") in the last "
+                    + interval
+                    + " seconds."
+                , 45);
+        }
+    }
+}
+
+
+
 } // namespace network
 } // namespace sitter
 // vim: ts=4 sw=4 et
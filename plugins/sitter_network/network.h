@@ -17,6 +17,13 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
+// self
+//
+#include    "interface_stats.h"
+#include    "kernel_counters.h"
+#include    "socket_stats.h"
+
+
 // sitter
 //
 #include    <sitter/sitter.h>
@@ -27,6 +34,11 @@
 #include    <serverplugins/plugin.h>
 
 
+// C++
+//
+#include    <deque>
+
+
 
 namespace sitter
 {
@@ -42,6 +54,12 @@ class network
     : public serverplugins::plugin
 {
 public:
+    static constexpr double const       CLOSE_WAIT_PERIOD = 5.0 * 60.0;    // 5 minutes
+    static constexpr std::size_t const  CLOSE_WAIT_MINIMUM_SAMPLES = 3;
+    static constexpr std::uint32_t const CLOSE_WAIT_MINIMUM_GROWTH = 10;
+    static constexpr std::uint64_t const DROP_MINIMUM_PACKETS = 1'000;
+    static constexpr std::uint64_t const RETRANSMIT_MINIMUM_SEGMENTS = 1'000;
+
     SERVERPLUGINS_DEFAULTS(network);
 
     // cppthread::plugin implementation
@@ -53,8 +71,17 @@ public:
 private:
     bool                find_communicatord(as2js::json::json_value_ref & json);
     bool                verify_communicatord_connection(as2js::json::json_value_ref & json);
+    void                check_interfaces(as2js::json::json_value_ref & json);
+    void                check_kernel_counters(as2js::json::json_value_ref & json);
+    void                check_link_events(as2js::json::json_value_ref & json);
+    void                check_sockets(as2js::json::json_value_ref & json);
 
     std::string         f_network_data_path = std::string();
+    interface_stats     f_interface_stats = interface_stats();
+    kernel_counters     f_kernel_counters = kernel_counters();
+    socket_stats        f_socket_stats = socket_stats();
+    std::deque<std::pair<double, std::uint32_t>>
+                        f_close_wait = std::deque<std::pair<double, std::uint32_t>>();
 };
 
 } // namespace network
@@ -0,0 +1,261 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "socket_stats.h"
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// snapdev
+//
+#include    <snapdev/raii_generic_deleter.h>
+
+
+// C
+//
+#include    <arpa/inet.h>
+#include    <linux/inet_diag.h>
+#include    <linux/netlink.h>
+#include    <linux/sock_diag.h>
+#include    <netinet/in.h>
+#include    <string.h>
+#include    <sys/socket.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the TCP socket statistics.
+ *
+ * Reading /proc/net/tcp on a front end with 100,000 sockets takes a lot
+ * of time since the kernel formats one line of text per socket. The
+ * sock_diag netlink interface returns the same information in binary
+ * form. We do not request any of the optional attributes so each socket
+ * costs a few bytes.
+ *
+ * The dump gives us the number of sockets in each state and, for the
+ * listening sockets, the number of connections waiting to be accepted
+ * (idiag_rqueue) and the backlog defined with listen() (idiag_wqueue).
+ */
+
+
+
+namespace sitter
+{
+namespace network
+{
+
+
+
+/** \brief Dump the TCP sockets.
+ *
+ * This function retrieves all the IPv4 and IPv6 TCP sockets and counts
+ * them by state. It also saves the accept queue of each listening
+ * socket.
+ *
+ * \return true if the dump succeeded.
+ */
+bool socket_stats::refresh()
+{
+    f_state_counts.fill(0);
+    f_listeners.clear();
+
+    snapdev::raii_fd_t fd(socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG));
+    if(fd.get() == -1)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not create the sock_diag socket (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << ")."
+            << SNAP_LOG_SEND;
+        return false;
+    }
+
+    // the inet_diag requests are per family
+    //
+    return dump(fd.get(), AF_INET)
+        && dump(fd.get(), AF_INET6);
+}
+
+
+/** \brief Get the number of sockets in each state.
+ *
+ * \return The array of counts indexed by tcp_state_t.
+ */
+state_counts_t const & socket_stats::get_state_counts() const
+{
+    return f_state_counts;
+}
+
+
+/** \brief Get the listening sockets.
+ *
+ * \return The list of listening sockets.
+ */
+listener_vector_t const & socket_stats::get_listeners() const
+{
+    return f_listeners;
+}
+
+
+/** \brief Get the name of a TCP state.
+ *
+ * \param[in] state  The state to convert.
+ *
+ * \return The name of the state as used by ss(8).
+ */
+char const * socket_stats::state_name(int state)
+{
+    switch(state)
+    {
+    case TCP_STATE_ESTABLISHED:     return "established";
+    case TCP_STATE_SYN_SENT:        return "syn_sent";
+    case TCP_STATE_SYN_RECV:        return "syn_recv";
+    case TCP_STATE_FIN_WAIT1:       return "fin_wait1";
+    case TCP_STATE_FIN_WAIT2:       return "fin_wait2";
+    case TCP_STATE_TIME_WAIT:       return "time_wait";
+    case TCP_STATE_CLOSE:           return "close";
+    case TCP_STATE_CLOSE_WAIT:      return "close_wait";
+    case TCP_STATE_LAST_ACK:        return "last_ack";
+    case TCP_STATE_LISTEN:          return "listen";
+    case TCP_STATE_CLOSING:         return "closing";
+    case TCP_STATE_NEW_SYN_RECV:    return "new_syn_recv";
+    default:                        return "unknown";
+    }
+}
+
+
+/** \brief Send one dump request and read the answer.
+ *
+ * \param[in] fd  The sock_diag socket.
+ * \param[in] family  The family to dump (AF_INET or AF_INET6).
+ *
+ * \return true if the dump succeeded.
+ */
+bool socket_stats::dump(int fd, int family)
+{
+    struct
+    {
+        nlmsghdr                f_header;
+        inet_diag_req_v2        f_request;
+    } request = {};
+    request.f_header.nlmsg_len = sizeof(request);
+    request.f_header.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    request.f_header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.f_request.sdiag_family = static_cast<std::uint8_t>(family);
+    request.f_request.sdiag_protocol = IPPROTO_TCP;
+    request.f_request.idiag_states = ~0U;   // all states
+
+    if(send(fd, &request, sizeof(request), 0) < 0)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not send the sock_diag request (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << ")."
+            << SNAP_LOG_SEND;
+        return false;
+    }
+
+    alignas(nlmsghdr) char buf[32768];
+    for(;;)
+    {
+        ssize_t const r(recv(fd, buf, sizeof(buf), 0));
+        if(r < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            int const e(errno);
+            SNAP_LOG_ERROR
+                << "could not read the sock_diag answer (errno: "
+                << e
+                << ", "
+                << strerror(e)
+                << ")."
+                << SNAP_LOG_SEND;
+            return false;
+        }
+        if(r == 0)
+        {
+            return true;
+        }
+
+        int len(static_cast<int>(r));
+        for(nlmsghdr const * nlh(reinterpret_cast<nlmsghdr const *>(buf));
+            NLMSG_OK(nlh, len);
+            nlh = NLMSG_NEXT(nlh, len))
+        {
+            if(nlh->nlmsg_type == NLMSG_DONE)
+            {
+                return true;
+            }
+            if(nlh->nlmsg_type == NLMSG_ERROR)
+            {
+                // i.e. IPv6 not available in this kernel
+                //
+                return family == AF_INET6;
+            }
+
+            inet_diag_msg const * msg(reinterpret_cast<inet_diag_msg const *>(reinterpret_cast<char const *>(nlh) + NLMSG_HDRLEN));
+            int const state(msg->idiag_state < TCP_STATE_MAX ? static_cast<int>(msg->idiag_state) : static_cast<int>(TCP_STATE_UNKNOWN));
+            ++f_state_counts[state];
+
+            if(state == TCP_STATE_LISTEN)
+            {
+                char address[INET6_ADDRSTRLEN] = {};
+                inet_ntop(
+                      family
+                    , msg->id.idiag_src
+                    , address
+                    , sizeof(address));
+
+                listener_t l;
+                l.f_address = address;
+                l.f_port = ntohs(msg->id.idiag_sport);
+                l.f_queue = msg->idiag_rqueue;
+                l.f_backlog = msg->idiag_wqueue;
+                f_listeners.push_back(l);
+            }
+        }
+    }
+}
+
+
+
+} // namespace network
+} // namespace sitter
+// vim: ts=4 sw=4 et
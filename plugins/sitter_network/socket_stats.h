@@ -0,0 +1,90 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <array>
+#include    <cstdint>
+#include    <string>
+#include    <vector>
+
+
+
+namespace sitter
+{
+namespace network
+{
+
+
+
+// the TCP states as defined in the kernel (include/net/tcp_states.h)
+//
+enum tcp_state_t
+{
+    TCP_STATE_UNKNOWN,
+    TCP_STATE_ESTABLISHED,
+    TCP_STATE_SYN_SENT,
+    TCP_STATE_SYN_RECV,
+    TCP_STATE_FIN_WAIT1,
+    TCP_STATE_FIN_WAIT2,
+    TCP_STATE_TIME_WAIT,
+    TCP_STATE_CLOSE,
+    TCP_STATE_CLOSE_WAIT,
+    TCP_STATE_LAST_ACK,
+    TCP_STATE_LISTEN,
+    TCP_STATE_CLOSING,
+    TCP_STATE_NEW_SYN_RECV,
+
+    TCP_STATE_MAX
+};
+
+typedef std::array<std::uint32_t, TCP_STATE_MAX>    state_counts_t;
+
+
+struct listener_t
+{
+    std::string                 f_address = std::string();
+    int                         f_port = 0;
+    std::uint32_t               f_queue = 0;        // connections waiting for accept()
+    std::uint32_t               f_backlog = 0;      // listen() backlog
+};
+typedef std::vector<listener_t>     listener_vector_t;
+
+
+class socket_stats
+{
+public:
+    bool                        refresh();
+    state_counts_t const &      get_state_counts() const;
+    listener_vector_t const &   get_listeners() const;
+
+    static char const *         state_name(int state);
+
+private:
+    bool                        dump(int fd, int family);
+
+    state_counts_t              f_state_counts = state_counts_t();
+    listener_vector_t           f_listeners = listener_vector_t();
+};
+
+
+
+} // namespace network
+} // namespace sitter
+// vim: ts=4 sw=4 et
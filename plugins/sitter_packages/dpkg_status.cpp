@@ -0,0 +1,858 @@
+// Copyright (c) 2013-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "dpkg_status.h"
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// snapdev
+//
+#include    <snapdev/raii_generic_deleter.h>
+
+
+// C++
+//
+#include    <algorithm>
+#include    <cstring>
+#include    <fstream>
+
+
+// C
+//
+#include    <fcntl.h>
+#include    <stdio.h>
+#include    <sys/mman.h>
+#include    <unistd.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+/** \file
+ * \brief Read the status of the Debian packages.
+ *
+ * The packages plugin used to run `dpkg-query` once for each package
+ * which was not yet in its cache. This implementation reads the dpkg
+ * database directly instead: the /var/lib/dpkg/status file is mapped in
+ * memory and parsed in a single pass. The result is an index from the
+ * name of a package to its status and version.
+ *
+ * dpkg replaces the status file each time a package gets installed,
+ * upgraded, or removed. The file is parsed again only when its inode,
+ * size, or modification time changes, so the results are correct right
+ * after an installation without having to parse the file on each tick.
+ *
+ * Each new index is compared against the previous one to find the
+ * packages which were installed, removed, upgraded, or downgraded. A
+ * snapshot of the installed versions is kept in the cache so changes
+ * made while the sitter was not running are found too.
+ */
+
+
+
+namespace sitter
+{
+namespace packages
+{
+
+
+
+namespace
+{
+
+
+
+/** \brief Check whether a field has the specified name.
+ *
+ * \param[in] field  The start of the field name.
+ * \param[in] length  The length of the field name.
+ * \param[in] name  The name to compare against.
+ *
+ * \return true if the field is named \p name.
+ */
+bool is_field(char const * field, std::size_t length, char const * name)
+{
+    return length == strlen(name)
+        && memcmp(field, name, length) == 0;
+}
+
+
+/** \brief Get the weight of a character in a version.
+ *
+ * In a Debian version, the tilde sorts before anything, even the end
+ * of the string, then letters sort before all the other characters.
+ *
+ * \param[in] c  The character to weigh.
+ *
+ * \return The weight of \p c.
+ */
+int order(char c)
+{
+    if(c >= '0' && c <= '9')
+    {
+        return 0;
+    }
+    if((c >= 'a' && c <= 'z')
+    || (c >= 'A' && c <= 'Z'))
+    {
+        return c;
+    }
+    if(c == '~')
+    {
+        return -1;
+    }
+    if(c != '\0')
+    {
+        return c + 256;
+    }
+    return 0;
+}
+
+
+/** \brief Compare the upstream version or revision of two versions.
+ *
+ * The strings are compared by alternating non-digit parts, compared
+ * with order(), and digit parts, compared numerically.
+ *
+ * \param[in] a  The null terminated left hand side string.
+ * \param[in] b  The null terminated right hand side string.
+ *
+ * \return -1, 0, or 1 depending on the order of \p a and \p b.
+ */
+int compare_part(char const * a, char const * b)
+{
+    auto is_digit = [](char c)
+        {
+            return c >= '0' && c <= '9';
+        };
+
+    while(*a != '\0' || *b != '\0')
+    {
+        while((*a != '\0' && !is_digit(*a))
+           || (*b != '\0' && !is_digit(*b)))
+        {
+            int const ac(order(*a));
+            int const bc(order(*b));
+            if(ac != bc)
+            {
+                return ac < bc ? -1 : 1;
+            }
+            ++a;
+            ++b;
+        }
+
+        while(*a == '0')
+        {
+            ++a;
+        }
+        while(*b == '0')
+        {
+            ++b;
+        }
+
+        int first_diff(0);
+        while(is_digit(*a) && is_digit(*b))
+        {
+            if(first_diff == 0)
+            {
+                first_diff = *a - *b;
+            }
+            ++a;
+            ++b;
+        }
+        if(is_digit(*a))
+        {
+            return 1;
+        }
+        if(is_digit(*b))
+        {
+            return -1;
+        }
+        if(first_diff != 0)
+        {
+            return first_diff < 0 ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/** \brief Break a version in its epoch, upstream version, and revision.
+ *
+ * \param[in] version  The version to break up.
+ * \param[out] epoch  The epoch, 0 when not specified.
+ * \param[out] upstream  The upstream version.
+ * \param[out] revision  The Debian revision, empty when not specified.
+ */
+void split_version(
+      std::string const & version
+    , std::int64_t & epoch
+    , std::string & upstream
+    , std::string & revision)
+{
+    epoch = 0;
+    std::string::size_type start(0);
+    std::string::size_type const colon(version.find(':'));
+    if(colon != std::string::npos)
+    {
+        for(std::string::size_type idx(0); idx < colon; ++idx)
+        {
+            if(version[idx] >= '0' && version[idx] <= '9')
+            {
+                epoch = epoch * 10 + (version[idx] - '0');
+            }
+        }
+        start = colon + 1;
+    }
+
+    std::string::size_type const dash(version.rfind('-'));
+    if(dash != std::string::npos
+    && dash >= start)
+    {
+        upstream = version.substr(start, dash - start);
+        revision = version.substr(dash + 1);
+    }
+    else
+    {
+        upstream = version.substr(start);
+        revision.clear();
+    }
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Initialize the dpkg status object.
+ *
+ * The file is not read until refresh() gets called.
+ *
+ * \param[in] filename  The path to the dpkg status file.
+ */
+dpkg_status::dpkg_status(std::string const & filename)
+    : f_filename(filename)
+{
+}
+
+
+/** \brief Load the snapshot of the installed packages.
+ *
+ * The snapshot holds the name and version of each package present (see
+ * parse()) the last time the status file was parsed. It is used as the previous index
+ * the first time refresh() gets called so the packages which changed
+ * while the sitter was not running get reported.
+ *
+ * The snapshot is saved to the same file each time a change is found.
+ *
+ * \param[in] filename  The path to the snapshot.
+ */
+void dpkg_status::load_snapshot(std::string const & filename)
+{
+    f_snapshot_filename = filename;
+
+    std::ifstream in(filename);
+    std::string line;
+    while(std::getline(in, line))
+    {
+        std::string::size_type const space(line.find(' '));
+        if(space == std::string::npos
+        || space == 0)
+        {
+            continue;
+        }
+        package_t & package(f_packages[line.substr(0, space)]);
+        package.f_version = line.substr(space + 1);
+        package.f_installed = true;
+        package.f_present = true;
+    }
+}
+
+
+/** \brief Load the status file if it changed.
+ *
+ * This function checks the inode, size, and modification time of the
+ * status file. If any one of them changed since the last time the file
+ * was parsed, the file is parsed again and the new index is compared
+ * against the previous one (see get_changes()).
+ *
+ * On an error, the previous index is kept so the changes can still be
+ * computed once the file can be read again.
+ *
+ * \return true if the status of the packages is available.
+ */
+bool dpkg_status::refresh()
+{
+    f_changes.clear();
+
+    struct stat st = {};
+    if(stat(f_filename.c_str(), &st) != 0)
+    {
+        if(f_loaded)
+        {
+            int const e(errno);
+            SNAP_LOG_ERROR
+                << "could not stat \""
+                << f_filename
+                << "\" (errno: "
+                << e
+                << ", "
+                << strerror(e)
+                << ")."
+                << SNAP_LOG_SEND;
+        }
+        f_loaded = false;
+        return false;
+    }
+
+    if(f_loaded
+    && st.st_ino == f_stat.st_ino
+    && st.st_size == f_stat.st_size
+    && st.st_mtim.tv_sec == f_stat.st_mtim.tv_sec
+    && st.st_mtim.tv_nsec == f_stat.st_mtim.tv_nsec)
+    {
+        return true;
+    }
+
+    snapdev::raii_fd_t fd(open(f_filename.c_str(), O_RDONLY | O_CLOEXEC));
+    if(fd.get() == -1)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not open \""
+            << f_filename
+            << "\" (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << ")."
+            << SNAP_LOG_SEND;
+        f_loaded = false;
+        return false;
+    }
+
+    // use the stat() of the file we opened; dpkg may have replaced the
+    // file in between
+    //
+    if(fstat(fd.get(), &st) != 0)
+    {
+        f_loaded = false;
+        return false;
+    }
+
+    package_map_t previous;
+    previous.swap(f_packages);
+    if(st.st_size > 0)
+    {
+        std::size_t const size(static_cast<std::size_t>(st.st_size));
+        void * data(mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.get(), 0));
+        if(data == MAP_FAILED)
+        {
+            int const e(errno);
+            SNAP_LOG_ERROR
+                << "could not mmap() \""
+                << f_filename
+                << "\" (errno: "
+                << e
+                << ", "
+                << strerror(e)
+                << ")."
+                << SNAP_LOG_SEND;
+            f_loaded = false;
+            f_packages.swap(previous);
+            return false;
+        }
+        madvise(data, size, MADV_SEQUENTIAL);
+
+        try
+        {
+            parse(static_cast<char const *>(data), size);
+        }
+        catch(...)
+        {
+            munmap(data, size);
+            throw;
+        }
+        munmap(data, size);
+    }
+
+    f_stat = st;
+    f_loaded = true;
+
+    if(previous.empty())
+    {
+        save_snapshot();
+    }
+    else
+    {
+        diff(previous);
+        if(!f_changes.empty())
+        {
+            save_snapshot();
+        }
+    }
+
+    SNAP_LOG_DEBUG
+        << "loaded the status of "
+        << f_packages.size()
+        << " packages from \""
+        << f_filename
+        << "\"."
+        << SNAP_LOG_SEND;
+
+    return true;
+}
+
+
+/** \brief Check whether the status file was loaded.
+ *
+ * \return true if the last refresh() succeeded.
+ */
+bool dpkg_status::is_loaded() const
+{
+    return f_loaded;
+}
+
+
+/** \brief Check whether a package is installed.
+ *
+ * The \p name can include an architecture (i.e. `libc6:i386`). Without
+ * an architecture, the package is considered installed if it is
+ * installed for any architecture.
+ *
+ * \param[in] name  The name of the package.
+ *
+ * \return true if the package is installed.
+ */
+bool dpkg_status::is_installed(std::string const & name) const
+{
+    auto it(f_packages.find(name));
+    if(it == f_packages.end())
+    {
+        return false;
+    }
+    return it->second.f_installed;
+}
+
+
+/** \brief Get the version of a package.
+ *
+ * \param[in] name  The name of the package.
+ *
+ * \return The version of the package or an empty string if unknown.
+ */
+std::string dpkg_status::get_version(std::string const & name) const
+{
+    auto it(f_packages.find(name));
+    if(it == f_packages.end())
+    {
+        return std::string();
+    }
+    return it->second.f_version;
+}
+
+
+/** \brief Get the index of all the packages.
+ *
+ * Each package is found under its name and under its name followed by
+ * a colon and its architecture.
+ *
+ * \return The map of packages.
+ */
+dpkg_status::package_map_t const & dpkg_status::get_packages() const
+{
+    return f_packages;
+}
+
+
+/** \brief Get the time when dpkg last modified its database.
+ *
+ * \return The modification time of the status file or 0 if not loaded.
+ */
+time_t dpkg_status::get_last_modification() const
+{
+    return f_loaded ? f_stat.st_mtime : 0;
+}
+
+
+/** \brief Get the changes found by the last call to refresh().
+ *
+ * Each time the status file gets parsed again, the installed packages
+ * are compared against the previous index. Packages which appeared,
+ * disappeared, or changed version are listed here. The date of a change
+ * is the modification time of the status file.
+ *
+ * \return The list of changes, empty if the file did not change.
+ */
+dpkg_status::change_vector_t const & dpkg_status::get_changes() const
+{
+    return f_changes;
+}
+
+
+/** \brief Compare two Debian versions.
+ *
+ * This function compares two versions the way dpkg does: the epochs
+ * are compared numerically, then the upstream versions and the Debian
+ * revisions are compared with the Debian ordering (a tilde sorts before
+ * anything, letters sort before other characters, and digit sequences
+ * are compared numerically). For example "1.0~rc1" is smaller than "1.0"
+ * and "1.10" is larger than "1.9".
+ *
+ * \param[in] lhs  The left hand side version.
+ * \param[in] rhs  The right hand side version.
+ *
+ * \return -1 if \p lhs is smaller, 0 if equal, 1 if \p lhs is larger.
+ */
+int dpkg_status::compare_versions(std::string const & lhs, std::string const & rhs)
+{
+    std::int64_t lhs_epoch(0);
+    std::string lhs_upstream;
+    std::string lhs_revision;
+    split_version(lhs, lhs_epoch, lhs_upstream, lhs_revision);
+
+    std::int64_t rhs_epoch(0);
+    std::string rhs_upstream;
+    std::string rhs_revision;
+    split_version(rhs, rhs_epoch, rhs_upstream, rhs_revision);
+
+    if(lhs_epoch != rhs_epoch)
+    {
+        return lhs_epoch < rhs_epoch ? -1 : 1;
+    }
+
+    int const r(compare_part(lhs_upstream.c_str(), rhs_upstream.c_str()));
+    if(r != 0)
+    {
+        return r;
+    }
+
+    return compare_part(lhs_revision.c_str(), rhs_revision.c_str());
+}
+
+
+/** \brief Convert an action to a string.
+ *
+ * \param[in] action  The action to convert.
+ *
+ * \return The name of the action.
+ */
+char const * dpkg_status::action_to_string(action_t action)
+{
+    switch(action)
+    {
+    case action_t::ACTION_INSTALLED:
+        return "installed";
+
+    case action_t::ACTION_REMOVED:
+        return "removed";
+
+    case action_t::ACTION_UPGRADED:
+        return "upgraded";
+
+    case action_t::ACTION_DOWNGRADED:
+        return "downgraded";
+
+    default:
+        return "unknown";
+
+    }
+}
+
+
+/** \brief Parse the content of the status file.
+ *
+ * The file is composed of stanzas separated by empty lines. Each stanza
+ * describes one package with one field per line (`Name: value`). Lines
+ * starting with a space or a tab are the continuation of the previous
+ * field; none of the fields we are interested in uses them.
+ *
+ * A package is considered installed when the last word of its Status
+ * field is "installed" (i.e. "install ok installed" or "hold ok
+ * installed").
+ *
+ * For the list of changes, a package is considered present in any state
+ * other than "not-installed" and "config-files". While apt upgrades,
+ * it first unpacks all the packages (with their new Version) and
+ * configures them afterward. A tick in between sees states such as
+ * "unpacked", "half-configured", or "triggers-pending". Those packages
+ * are still on the system and must not be reported as removed and then
+ * installed again; the upgrade gets recorded as such instead.
+ *
+ * \param[in] s  The content of the file.
+ * \param[in] size  The size of the content.
+ */
+void dpkg_status::parse(char const * s, std::size_t size)
+{
+    char const * const end(s + size);
+
+    std::string name;
+    package_t package;
+    auto flush = [this, &name, &package]()
+        {
+            if(!name.empty())
+            {
+                if(!package.f_architecture.empty())
+                {
+                    f_packages[name + ':' + package.f_architecture] = package;
+                }
+
+                // with multi-arch, the same package may appear once per
+                // architecture; keep the installed one
+                //
+                auto it(f_packages.find(name));
+                if(it == f_packages.end()
+                || (!it->second.f_installed && package.f_installed)
+                || (!it->second.f_present && package.f_present))
+                {
+                    f_packages[name] = package;
+                }
+            }
+            name.clear();
+            package = package_t();
+        };
+
+    while(s < end)
+    {
+        char const * eol(static_cast<char const *>(memchr(s, '\n', end - s)));
+        if(eol == nullptr)
+        {
+            eol = end;
+        }
+        char const * const line(s);
+        s = eol + 1;
+
+        if(line == eol)
+        {
+            flush();
+            continue;
+        }
+        if(*line == ' '
+        || *line == '\t')
+        {
+            continue;
+        }
+
+        char const * const colon(static_cast<char const *>(memchr(line, ':', eol - line)));
+        if(colon == nullptr)
+        {
+            continue;
+        }
+        std::size_t const length(colon - line);
+
+        char const * value(colon + 1);
+        while(value < eol && (*value == ' ' || *value == '\t'))
+        {
+            ++value;
+        }
+        char const * value_end(eol);
+        while(value_end > value && (value_end[-1] == ' ' || value_end[-1] == '\t' || value_end[-1] == '\r'))
+        {
+            --value_end;
+        }
+
+        if(is_field(line, length, "Package"))
+        {
+            name.assign(value, value_end);
+        }
+        else if(is_field(line, length, "Status"))
+        {
+            char const * word(value_end);
+            while(word > value && word[-1] != ' ')
+            {
+                --word;
+            }
+            std::size_t const word_length(value_end - word);
+            package.f_installed = is_field(word, word_length, "installed");
+            package.f_present = !is_field(word, word_length, "not-installed")
+                             && !is_field(word, word_length, "config-files");
+        }
+        else if(is_field(line, length, "Version"))
+        {
+            package.f_version.assign(value, value_end);
+        }
+        else if(is_field(line, length, "Architecture"))
+        {
+            package.f_architecture.assign(value, value_end);
+        }
+    }
+    flush();
+}
+
+
+/** \brief Compare the new index against the previous one.
+ *
+ * Only the entries without an architecture are compared so a package
+ * installed for several architectures is reported once.
+ *
+ * The packages in a transitional state (i.e. unpacked but not yet
+ * configured) are present; their Version is already the new one.
+ *
+ * \param[in] previous  The index before the status file changed.
+ */
+void dpkg_status::diff(package_map_t const & previous)
+{
+    auto is_plain = [](std::string const & name)
+        {
+            return name.find(':') == std::string::npos;
+        };
+
+    change_vector_t changes;
+    for(auto const & p : f_packages)
+    {
+        if(!is_plain(p.first)
+        || !p.second.f_present)
+        {
+            continue;
+        }
+
+        change_t c;
+        c.f_name = p.first;
+        c.f_new_version = p.second.f_version;
+        c.f_date = f_stat.st_mtime;
+
+        auto it(previous.find(p.first));
+        if(it == previous.end()
+        || !it->second.f_present)
+        {
+            c.f_action = action_t::ACTION_INSTALLED;
+            changes.push_back(c);
+            continue;
+        }
+
+        int const r(compare_versions(it->second.f_version, p.second.f_version));
+        if(r == 0)
+        {
+            continue;
+        }
+        c.f_action = r < 0
+                        ? action_t::ACTION_UPGRADED
+                        : action_t::ACTION_DOWNGRADED;
+        c.f_old_version = it->second.f_version;
+        changes.push_back(c);
+    }
+
+    for(auto const & p : previous)
+    {
+        if(!is_plain(p.first)
+        || !p.second.f_present)
+        {
+            continue;
+        }
+        auto const it(f_packages.find(p.first));
+        if(it != f_packages.end()
+        && it->second.f_present)
+        {
+            continue;
+        }
+
+        change_t c;
+        c.f_name = p.first;
+        c.f_action = action_t::ACTION_REMOVED;
+        c.f_old_version = p.second.f_version;
+        c.f_date = f_stat.st_mtime;
+        changes.push_back(c);
+    }
+
+    std::sort(
+          changes.begin()
+        , changes.end()
+        , [](change_t const & a, change_t const & b)
+        {
+            return a.f_name < b.f_name;
+        });
+    f_changes.swap(changes);
+}
+
+
+/** \brief Save the snapshot of the installed packages.
+ *
+ * The snapshot is written only if load_snapshot() was called with a
+ * filename. It is first written in a temporary file which is then
+ * renamed so a crash never leaves a partial snapshot behind (the
+ * missing packages would be reported as newly installed on restart).
+ */
+void dpkg_status::save_snapshot()
+{
+    if(f_snapshot_filename.empty())
+    {
+        return;
+    }
+
+    std::string const tmp(f_snapshot_filename + ".tmp");
+    {
+        std::ofstream out(tmp);
+        for(auto const & p : f_packages)
+        {
+            if(p.second.f_present
+            && p.first.find(':') == std::string::npos)
+            {
+                out << p.first
+                    << ' '
+                    << p.second.f_version
+                    << '\n';
+            }
+        }
+        out.close();
+        if(!out)
+        {
+            SNAP_LOG_ERROR
+                << "could not save the package snapshot to \""
+                << tmp
+                << "\"."
+                << SNAP_LOG_SEND;
+            unlink(tmp.c_str());
+            return;
+        }
+    }
+
+    if(rename(tmp.c_str(), f_snapshot_filename.c_str()) != 0)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not rename \""
+            << tmp
+            << "\" to \""
+            << f_snapshot_filename
+            << "\" (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << ")."
+            << SNAP_LOG_SEND;
+        unlink(tmp.c_str());
+    }
+}
+
+
+
+} // namespace packages
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,101 @@
+// Copyright (c) 2013-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <string>
+#include    <unordered_map>
+#include    <vector>
+
+
+// C
+//
+#include    <sys/stat.h>
+
+
+
+namespace sitter
+{
+namespace packages
+{
+
+
+
+class dpkg_status
+{
+public:
+    struct package_t
+    {
+        std::string             f_version = std::string();
+        std::string             f_architecture = std::string();
+        bool                    f_installed = false;
+        bool                    f_present = false;
+    };
+    typedef std::unordered_map<std::string, package_t>  package_map_t;
+
+    enum class action_t
+    {
+        ACTION_INSTALLED,
+        ACTION_REMOVED,
+        ACTION_UPGRADED,
+        ACTION_DOWNGRADED,
+    };
+
+    struct change_t
+    {
+        std::string             f_name = std::string();
+        action_t                f_action = action_t::ACTION_INSTALLED;
+        std::string             f_old_version = std::string();
+        std::string             f_new_version = std::string();
+        time_t                  f_date = 0;
+    };
+    typedef std::vector<change_t>                       change_vector_t;
+
+                                dpkg_status(std::string const & filename = "/var/lib/dpkg/status");
+
+    void                        load_snapshot(std::string const & filename);
+    bool                        refresh();
+    bool                        is_loaded() const;
+    bool                        is_installed(std::string const & name) const;
+    std::string                 get_version(std::string const & name) const;
+    package_map_t const &       get_packages() const;
+    time_t                      get_last_modification() const;
+    change_vector_t const &     get_changes() const;
+
+    static int                  compare_versions(std::string const & lhs, std::string const & rhs);
+    static char const *         action_to_string(action_t action);
+
+private:
+    void                        parse(char const * s, std::size_t size);
+    void                        diff(package_map_t const & previous);
+    void                        save_snapshot();
+
+    std::string                 f_filename = std::string();
+    std::string                 f_snapshot_filename = std::string();
+    struct stat                 f_stat = {};
+    bool                        f_loaded = false;
+    package_map_t               f_packages = package_map_t();
+    change_vector_t             f_changes = change_vector_t();
+};
+
+
+
+} // namespace packages
+} // namespace sitter
+// vim: ts=4 sw=4 et
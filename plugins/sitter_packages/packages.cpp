@@ -21,6 +21,7 @@
 //
 #include    "packages.h"
 
+#include    "dpkg_status.h"
 #include    "names.h"
 
 
@@ -41,16 +42,9 @@
 #include    <snaplogger/message.h>
 
 
-// cppprocess
-//
-#include    <cppprocess/process.h>
-#include    <cppprocess/io_capture_pipe.h>
-
-
 // snapdev
 //
 #include    <snapdev/enumerate.h>
-#include    <snapdev/file_contents.h>
 #include    <snapdev/glob_to_list.h>
 #include    <snapdev/join_strings.h>
 #include    <snapdev/not_reached.h>
@@ -65,6 +59,7 @@
 
 // C++
 //
+#include    <fstream>
 #include    <sstream>
 
 
@@ -140,6 +135,8 @@ namespace
  *     installation=<optional|required|unwanted>
  *     description="<description>"
  *     conflicts=<package-name>[,...]
+ *     minimum_version=<version>
+ *     maximum_version=<version>
  * \endcode
  *
  * The `priority` parameter is the priority used to send an error message.
@@ -152,6 +149,11 @@ namespace
  * The `conflicts` parameter defines one or more package names that
  * cannot be installed along this package (i.e. `ntp` vs `ntpdate`).
  * Separate multiple names with commas.
+ *
+ * The `minimum_version` and `maximum_version` parameters define the range
+ * of versions accepted when the package is installed. The versions are
+ * compared using the Debian ordering (i.e. `1.0~rc1` is smaller than
+ * `1.0`). An installed version outside of that range generates an error.
  */
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Weffc++"
@@ -160,7 +162,6 @@ class sitter_package_t
 public:
     typedef std::vector<sitter_package_t>               vector_t;
     typedef std::set<std::string>                       package_name_set_t;
-    typedef std::map<std::string, bool>                 installed_packages_t;
 
     enum class installation_t
     {
@@ -177,6 +178,8 @@ public:
 
     void                        set_description(std::string const & description);
     void                        add_conflict(std::string const & package_name);
+    void                        set_minimum_version(std::string const & version);
+    void                        set_maximum_version(std::string const & version);
 
     std::string const &         get_name() const;
     installation_t              get_installation() const;
@@ -185,6 +188,8 @@ public:
     package_name_set_t const &  get_conflicts() const;
     package_name_set_t const &  get_packages_in_conflict() const;
     int                         get_priority() const;
+    std::string const &         get_minimum_version() const;
+    std::string const &         get_maximum_version() const;
 
     bool                        is_package_installed(std::string const & package_name);
     bool                        is_in_conflict();
@@ -197,15 +202,16 @@ private:
     std::string                 f_description = std::string();
     package_name_set_t          f_conflicts = package_name_set_t();
     package_name_set_t          f_in_conflict = package_name_set_t();
+    std::string                 f_minimum_version = std::string();
+    std::string                 f_maximum_version = std::string();
     installation_t              f_installation = installation_t::PACKAGE_INSTALLATION_OPTIONAL;
     int                         f_priority = 15;
 };
 #pragma GCC diagnostic pop
 
 sitter_package_t::vector_t                  g_packages = sitter_package_t::vector_t();
-sitter_package_t::installed_packages_t      g_installed_packages = sitter_package_t::installed_packages_t();
-bool                                        g_cache_loaded = false;
-bool                                        g_cache_modified = false;
+dpkg_status                                 g_dpkg_status = dpkg_status();
+bool                                        g_snapshot_loaded = false;
 
 
 /** \brief Initializes a sitter_package_t object.
@@ -270,6 +276,33 @@ void sitter_package_t::add_conflict(std::string const & package_name)
 }
 
 
+/** \brief Set the minimum version of this package.
+ *
+ * When the package is installed, its version must be at least this
+ * version. The versions are compared the way dpkg compares them.
+ *
+ * \param[in] version  The minimum version.
+ */
+void sitter_package_t::set_minimum_version(std::string const & version)
+{
+    f_minimum_version = snapdev::trim_string(version);
+}
+
+
+/** \brief Set the maximum version of this package.
+ *
+ * When the package is installed, its version must be at most this
+ * version. This is useful to detect an upgrade to a version known
+ * to cause problems.
+ *
+ * \param[in] version  The maximum version.
+ */
+void sitter_package_t::set_maximum_version(std::string const & version)
+{
+    f_maximum_version = snapdev::trim_string(version);
+}
+
+
 /** \brief Get the name of the package concerned.
  *
  * This function returns the name of the package concerned by this
@@ -395,105 +428,37 @@ int sitter_package_t::get_priority() const
 }
 
 
-/** \brief Check whether the specified package is installed.
- *
- * This function returns true if the named package is installed.
+/** \brief Get the minimum version of this package.
  *
- * \return true if the named package is installed.
+ * \return The minimum version or an empty string if not defined.
  */
-bool sitter_package_t::is_package_installed(std::string const & package_name)
+std::string const & sitter_package_t::get_minimum_version() const
 {
-    bool result(false);
-
-    if(!g_cache_loaded)
-    {
-        g_cache_loaded = true;
-
-        std::string const packages_filename(f_server->get_cache_path(g_name_packages_cache_filename));
-        snapdev::file_contents in(packages_filename);
-        if(in.read_all())
-        {
-            std::string const content(in.contents());
-            std::string::size_type pos(0);
-            while(pos != std::string::npos)
-            {
-                std::string::size_type s(pos);
-                pos = content.find('\n', pos);
-                std::string line;
-                if(pos == std::string::npos)
-                {
-                    line = content.substr(s);
-                }
-                else
-                {
-                    line = content.substr(s, pos - s);
-                    ++pos;  // skip the '\n'
-                }
-                std::string::size_type equal(line.find('='));
-                if(equal != std::string::npos)
-                {
-                    std::string const name(line.substr(0, equal));
-                    if(!name.empty())
-                    {
-                        std::string const value(line.substr(equal + 1));
-                        g_installed_packages[name] = value == "t";
-                    }
-                }
-            }
-        }
-    }
-
-    auto it(g_installed_packages.find(package_name));
-    if(it != g_installed_packages.end())
-    {
-        // already determined, return the cached result
-        //
-        result = it->second;
-    }
-    else
-    {
-        // get the system status now
-        //
-        cppprocess::process p("query package status");
-        p.set_command("dpkg-query");
-        p.add_argument("--showformat='${Status}'");
-        p.add_argument("--show");
-        p.add_argument(package_name);
-        cppprocess::io_capture_pipe::pointer_t out(std::make_shared<cppprocess::io_capture_pipe>());
-        p.set_output_io(out);
-        int r(p.start());
-        if(r == 0)
-        {
-            r = p.wait();
-        }
+    return f_minimum_version;
+}
 
-SNAP_LOG_TRACE
-<< "output of dpkg-query is: "
-<< r
-<< " -> "
-<< out->get_trimmed_output()
-<< SNAP_LOG_SEND;
-        if(r == 0)
-        {
-            std::string const output(out->get_trimmed_output());
-            result = output == "install ok installed";
-SNAP_LOG_TRACE
-<< "output: ["
-<< output
-<< "] -> "
-<< (result ? "TRUE" : "FALSE")
-<< SNAP_LOG_SEND;
-        }
 
-        // cache the result in case the same package is checked multiple
-        // times...
-        //
-        g_installed_packages[package_name] = result;
+/** \brief Get the maximum version of this package.
+ *
+ * \return The maximum version or an empty string if not defined.
+ */
+std::string const & sitter_package_t::get_maximum_version() const
+{
+    return f_maximum_version;
+}
 
-        g_cache_modified = true;
-    }
 
-    return result;
+/** \brief Check whether the specified package is installed.
+ *
+ * This function returns true if the named package is installed. The
+ * status comes from the dpkg database which is refreshed at the start
+ * of each tick (see dpkg_status).
+ *
+ * \return true if the named package is installed.
+ */
+bool sitter_package_t::is_package_installed(std::string const & package_name)
+{
+    return g_dpkg_status.is_installed(package_name);
 }
 
 
@@ -573,34 +538,66 @@ sitter_package_t::installation_t sitter_package_t::installation_from_string(std:
 }
 
 
-
-/** \brief Save the cache if it was updated.
+/** \brief Record the package changes.
  *
- * This function updates the cache used to save the installed packages
- * in the event it was modified (i.e. a new package was listed somewhere.)
+ * When the dpkg status file changed since the last tick, the packages
+ * which were installed, removed, upgraded, or downgraded are added to
+ * the JSON data of this tick and appended to the history of changes
+ * in the cache. This makes it possible to line up a regression with
+ * the package change which happened just before. The daily cron script
+ * keeps the last 10,000 changes of that history.
  *
- * The cache is used so we can still check for the conflicts once a minute
- * but not spend the time it takes (very long) to check whether each package
- * is or is not installed.
- *
- * The cache gets reset once a day so it can be redefined anew at that time
- * and a new status determined.
- *
- * \param[in] server  A pointer to the child so we can get the path to the cache.
+ * \param[in] server  A pointer to the server to get the cache path.
+ * \param[in] json  The "packages" object where the changes are added.
  */
-void save_cache(sitter::server::pointer_t server)
+void record_changes(sitter::server::pointer_t server, as2js::json::json_value_ref & json)
 {
-    if(g_cache_modified)
+    json["dpkg_modified"] = static_cast<std::int64_t>(g_dpkg_status.get_last_modification());
+
+    dpkg_status::change_vector_t const & changes(g_dpkg_status.get_changes());
+    if(changes.empty())
     {
-        std::string const packages_filename(server->get_cache_path(g_name_packages_cache_filename));
-        std::ofstream out(packages_filename);
-        for(auto const & p : g_installed_packages)
+        return;
+    }
+
+    std::ofstream out(server->get_cache_path(g_name_packages_changes_filename), std::ios::app);
+    for(auto const & c : changes)
+    {
+        char const * action(dpkg_status::action_to_string(c.f_action));
+
+        as2js::json::json_value_ref change(json["change"][-1]);
+        change["name"] = c.f_name;
+        change["action"] = action;
+        change["date"] = static_cast<std::int64_t>(c.f_date);
+        if(!c.f_old_version.empty())
+        {
+            change["old_version"] = c.f_old_version;
+        }
+        if(!c.f_new_version.empty())
         {
-            out << p.first
-                << '='
-                << (p.second ? 't' : 'f')
-                << '\n';
+            change["new_version"] = c.f_new_version;
         }
+
+        out << c.f_date
+            << ' '
+            << action
+            << ' '
+            << c.f_name
+            << ' '
+            << (c.f_old_version.empty() ? "-" : c.f_old_version)
+            << ' '
+            << (c.f_new_version.empty() ? "-" : c.f_new_version)
+            << '\n';
+
+        SNAP_LOG_INFO
+            << "package \""
+            << c.f_name
+            << "\" was "
+            << action
+            << (c.f_old_version.empty() ? "" : " from " + c.f_old_version)
+            << (c.f_new_version.empty() ? "" : " to " + c.f_new_version)
+            << "."
+            << SNAP_LOG_SEND;
     }
 }
 
@@ -640,6 +637,24 @@ void packages::on_process_watch(as2js::json::json_value_ref & json)
 
     as2js::json::json_value_ref e(json["packages"]);
 
+    if(!g_snapshot_loaded)
+    {
+        g_snapshot_loaded = true;
+        g_dpkg_status.load_snapshot(plugins()->get_server<sitter::server>()->get_cache_path(g_name_packages_snapshot_filename));
+    }
+
+    if(!g_dpkg_status.refresh())
+    {
+        plugins()->get_server<sitter::server>()->append_error(
+                  e
+                , "packages"
+                , "could not read the status of the installed packages from the dpkg database."
+                , 35);
+        return;
+    }
+
+    record_changes(plugins()->get_server<sitter::server>(), e);
+
 SNAP_LOG_TRACE
 << "got "
 << g_packages.size()
@@ -708,6 +723,46 @@ SNAP_LOG_TRACE
 
         }
 
+        if(pc.is_package_installed(name))
+        {
+            std::string const version(g_dpkg_status.get_version(name));
+            package["version"] = version;
+
+            std::string const & minimum_version(pc.get_minimum_version());
+            if(!minimum_version.empty()
+            && dpkg_status::compare_versions(version, minimum_version) < 0)
+            {
+                plugins()->get_server<sitter::server>()->append_error(
+                          package
+                        , "packages"
+                        , "The \""
+                          + name
+                          + "\" package version "
+                          + version
+                          + " is older than the minimum version "
+                          + minimum_version
+                          + ". Please upgrade this package at your earliest convenience."
+                        , pc.get_priority());
+            }
+
+            std::string const & maximum_version(pc.get_maximum_version());
+            if(!maximum_version.empty()
+            && dpkg_status::compare_versions(version, maximum_version) > 0)
+            {
+                plugins()->get_server<sitter::server>()->append_error(
+                          package
+                        , "packages"
+                        , "The \""
+                          + name
+                          + "\" package version "
+                          + version
+                          + " is newer than the maximum version "
+                          + maximum_version
+                          + ". Please check whether this version is safe to use."
+                        , pc.get_priority());
+            }
+        }
+
         if(pc.is_in_conflict())
         {
             // conflict discovered, generate an error
@@ -732,10 +787,6 @@ SNAP_LOG_TRACE
         }
         // else -- everything's fine
     }
-
-    // the cache may have been modified, save it if so
-    //
-    save_cache(plugins()->get_server<sitter::server>());
 }
 
 
@@ -836,6 +887,15 @@ void packages::load_package(int index, std::string package_filename)
 
     wp.set_description(description);
 
+    if(package->has_parameter("minimum_version"))
+    {
+        wp.set_minimum_version(package->get_parameter("minimum_version"));
+    }
+    if(package->has_parameter("maximum_version"))
+    {
+        wp.set_maximum_version(package->get_parameter("maximum_version"));
+    }
+
     for(auto c : conflicts)
     {
         wp.add_conflict(c);
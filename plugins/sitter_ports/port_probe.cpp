@@ -0,0 +1,339 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "port_probe.h"
+
+
+// sitter
+//
+#include    <sitter/monotonic_clock.h>
+
+
+// libaddr
+//
+#include    <libaddr/addr_parser.h>
+#include    <libaddr/exception.h>
+
+
+// snapdev
+//
+#include    <snapdev/raii_generic_deleter.h>
+
+
+// C++
+//
+#include    <cstring>
+
+
+// C
+//
+#include    <poll.h>
+#include    <sys/socket.h>
+#include    <sys/un.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the port probes.
+ *
+ * Each endpoint is probed with a non-blocking connect(). All the
+ * connections are started at once and the answers are collected with
+ * a single poll() so the probes take at most the timeout whatever the
+ * number of endpoints.
+ *
+ * An endpoint is either a TCP address and port (i.e. 127.0.0.1:4040 or
+ * [::1]:443) or the full path to a Unix socket (i.e. /run/service.sock).
+ * The connection is closed as soon as it is established; no data is
+ * sent.
+ *
+ * A non-blocking connect() to a Unix socket does not wait for the
+ * service to accept the connection. When the listen() backlog is full
+ * it fails immediately with EAGAIN. This means the service is alive
+ * but too busy, so it gets its own status (CONNECT_STATUS_BUSY).
+ */
+
+
+
+namespace sitter
+{
+namespace ports
+{
+
+
+
+namespace
+{
+
+
+
+/** \brief Convert an endpoint to a socket address.
+ *
+ * \param[in] endpoint  The endpoint as found in the ports_endpoints
+ * parameter.
+ * \param[out] address  The resulting address.
+ * \param[out] length  The size of the resulting address.
+ *
+ * \return true if the endpoint is valid.
+ */
+bool get_address(
+      std::string const & endpoint
+    , sockaddr_storage & address
+    , socklen_t & length)
+{
+    if(!endpoint.empty()
+    && endpoint[0] == '/')
+    {
+        sockaddr_un un = {};
+        if(endpoint.length() >= sizeof(un.sun_path))
+        {
+            return false;
+        }
+        un.sun_family = AF_UNIX;
+        std::memcpy(un.sun_path, endpoint.c_str(), endpoint.length());
+        std::memcpy(&address, &un, sizeof(un));
+        length = sizeof(un);
+        return true;
+    }
+
+    try
+    {
+        addr::addr const a(addr::string_to_addr(endpoint, "127.0.0.1", -1, "tcp"));
+        if(a.get_port() <= 0)
+        {
+            return false;
+        }
+        if(a.is_ipv4())
+        {
+            sockaddr_in in = {};
+            a.get_ipv4(in);
+            std::memcpy(&address, &in, sizeof(in));
+            length = sizeof(in);
+        }
+        else
+        {
+            sockaddr_in6 in6 = {};
+            a.get_ipv6(in6);
+            std::memcpy(&address, &in6, sizeof(in6));
+            length = sizeof(in6);
+        }
+        return true;
+    }
+    catch(addr::addr_invalid_argument const &)
+    {
+        return false;
+    }
+}
+
+
+void set_error(connect_result_t & result, int e)
+{
+    result.f_errno = e;
+    switch(e)
+    {
+    case ECONNREFUSED:
+    case ENOENT:            // Unix socket file missing
+        result.f_status = connect_status_t::CONNECT_STATUS_REFUSED;
+        break;
+
+    case ETIMEDOUT:
+        result.f_status = connect_status_t::CONNECT_STATUS_TIMED_OUT;
+        break;
+
+    case EAGAIN:            // Unix socket backlog is full
+        result.f_status = connect_status_t::CONNECT_STATUS_BUSY;
+        break;
+
+    default:
+        result.f_status = connect_status_t::CONNECT_STATUS_FAILED;
+        break;
+
+    }
+}
+
+
+struct pending_t
+{
+    std::size_t             f_index = 0;
+    std::int64_t            f_start = 0;
+    snapdev::raii_fd_t      f_socket = snapdev::raii_fd_t();
+};
+
+
+
+} // no name namespace
+
+
+
+/** \brief Probe a set of endpoints.
+ *
+ * This function connects to each one of the \p endpoints and returns
+ * the results in the same order.
+ *
+ * An endpoint which does not accept the connection within \p timeout
+ * microseconds gets its status set to CONNECT_STATUS_TIMED_OUT.
+ *
+ * \param[in] endpoints  The list of endpoints to probe.
+ * \param[in] timeout  The maximum amount of time the probes can take in
+ * microseconds.
+ *
+ * \return The list of results.
+ */
+connect_result_vector_t port_probe::probe(
+      std::vector<std::string> const & endpoints
+    , std::int64_t timeout)
+{
+    connect_result_vector_t result(endpoints.size());
+
+    std::vector<pending_t> pending;
+    for(std::size_t idx(0); idx < endpoints.size(); ++idx)
+    {
+        connect_result_t & r(result[idx]);
+        r.f_endpoint = endpoints[idx];
+
+        sockaddr_storage address = {};
+        socklen_t length(0);
+        if(!get_address(endpoints[idx], address, length))
+        {
+            r.f_status = connect_status_t::CONNECT_STATUS_INVALID;
+            r.f_errno = EINVAL;
+            continue;
+        }
+
+        int const s(socket(address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+        if(s == -1)
+        {
+            set_error(r, errno);
+            continue;
+        }
+
+        pending_t p;
+        p.f_index = idx;
+        p.f_socket = snapdev::raii_fd_t(s);
+        p.f_start = monotonic_usec();
+        if(connect(s, reinterpret_cast<sockaddr const *>(&address), length) == 0)
+        {
+            // Unix sockets usually connect immediately
+            //
+            r.f_status = connect_status_t::CONNECT_STATUS_SUCCESS;
+            r.f_latency = static_cast<double>(monotonic_usec() - p.f_start);
+            continue;
+        }
+        if(errno != EINPROGRESS)
+        {
+            set_error(r, errno);
+            continue;
+        }
+
+        pending.push_back(std::move(p));
+    }
+
+    std::vector<pollfd> fds(pending.size());
+    for(std::size_t idx(0); idx < pending.size(); ++idx)
+    {
+        fds[idx].fd = pending[idx].f_socket.get();
+        fds[idx].events = POLLOUT;
+    }
+
+    std::int64_t const deadline(monotonic_usec() + timeout);
+    std::size_t remaining(pending.size());
+    while(remaining > 0)
+    {
+        std::int64_t const now(monotonic_usec());
+        if(now >= deadline)
+        {
+            break;
+        }
+
+        int const r(poll(fds.data(), fds.size(), static_cast<int>((deadline - now + 999) / 1'000)));
+        if(r < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            int const e(errno);
+            for(std::size_t idx(0); idx < pending.size(); ++idx)
+            {
+                if(fds[idx].fd != -1)
+                {
+                    set_error(result[pending[idx].f_index], e);
+                    fds[idx].fd = -1;
+                }
+            }
+            break;
+        }
+
+        std::int64_t const done(monotonic_usec());
+        for(std::size_t idx(0); idx < pending.size(); ++idx)
+        {
+            if(fds[idx].fd == -1
+            || fds[idx].revents == 0)
+            {
+                continue;
+            }
+
+            int error(0);
+            socklen_t error_length(sizeof(error));
+            if(getsockopt(fds[idx].fd, SOL_SOCKET, SO_ERROR, &error, &error_length) != 0)
+            {
+                error = errno;
+            }
+
+            connect_result_t & c(result[pending[idx].f_index]);
+            if(error == 0)
+            {
+                c.f_status = connect_status_t::CONNECT_STATUS_SUCCESS;
+                c.f_latency = static_cast<double>(done - pending[idx].f_start);
+            }
+            else
+            {
+                set_error(c, error);
+            }
+            fds[idx].fd = -1;
+            --remaining;
+        }
+    }
+
+    for(std::size_t idx(0); idx < pending.size(); ++idx)
+    {
+        if(fds[idx].fd != -1)
+        {
+            connect_result_t & c(result[pending[idx].f_index]);
+            c.f_status = connect_status_t::CONNECT_STATUS_TIMED_OUT;
+            c.f_errno = ETIMEDOUT;
+        }
+    }
+
+    return result;
+}
+
+
+
+} // namespace ports
+} // namespace sitter
+// vim: ts=4 sw=4 et
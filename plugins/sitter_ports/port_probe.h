@@ -0,0 +1,70 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <cstdint>
+#include    <string>
+#include    <vector>
+
+
+
+namespace sitter
+{
+namespace ports
+{
+
+
+
+enum class connect_status_t
+{
+    CONNECT_STATUS_SUCCESS,
+    CONNECT_STATUS_REFUSED,
+    CONNECT_STATUS_TIMED_OUT,
+    CONNECT_STATUS_BUSY,
+    CONNECT_STATUS_FAILED,
+    CONNECT_STATUS_INVALID,
+};
+
+
+struct connect_result_t
+{
+    std::string                 f_endpoint = std::string();
+    connect_status_t            f_status = connect_status_t::CONNECT_STATUS_FAILED;
+    int                         f_errno = 0;
+    double                      f_latency = 0.0;    // microseconds
+};
+typedef std::vector<connect_result_t>   connect_result_vector_t;
+
+
+class port_probe
+{
+public:
+    static constexpr std::int64_t const DEFAULT_TIMEOUT = 2'000'000;    // 2 seconds in microseconds
+
+    connect_result_vector_t     probe(
+                                      std::vector<std::string> const & endpoints
+                                    , std::int64_t timeout = DEFAULT_TIMEOUT);
+};
+
+
+
+} // namespace ports
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,298 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "ports.h"
+
+#include    "names.h"
+
+
+// advgetopt
+//
+#include    <advgetopt/utils.h>
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// snapdev
+//
+#include    <snapdev/gethostname.h>
+
+
+// serverplugins
+//
+#include    <serverplugins/collection.h>
+
+
+// C++
+//
+#include    <algorithm>
+#include    <cstring>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+/** \file
+ * \brief Check that services accept connections.
+ *
+ * A running process does not mean that the service accepts connections.
+ * This plugin connects to each one of the endpoints listed in the
+ * ports_endpoints parameter (local TCP ports and Unix sockets) on each
+ * tick and reports the endpoints which refuse the connection, which do
+ * not answer in time, or which take much longer than usual to accept
+ * the connection.
+ *
+ * The connect latencies are saved in two histograms per endpoint: a
+ * baseline which represents the usual latency over the last few hours
+ * and a recent histogram which represents the last few ticks.
+ */
+
+
+
+namespace sitter
+{
+namespace ports
+{
+
+SERVERPLUGINS_START(ports)
+    , ::serverplugins::description(
+            "Check that the local services accept connections on their ports.")
+    , ::serverplugins::dependency("server")
+    , ::serverplugins::help_uri("https://snapwebsites.org/help")
+    , ::serverplugins::categorization_tag("network")
+SERVERPLUGINS_END(ports)
+
+
+
+
+namespace
+{
+
+
+
+// the baseline covers the last few hours and the recent latencies the
+// last few minutes; the baseline is trusted after 30 minutes
+//
+latency_settings_t const    g_latency_settings =
+{
+    100.0 * 60.0,   // baseline period
+    3.0 * 60.0,     // recent period
+    30.0,           // minimum samples
+    30.0 * 60.0,    // minimum period
+};
+
+
+
+} // no name namespace
+
+
+
+
+/** \brief Initialize ports.
+ *
+ * This function terminates the initialization of the ports plugin
+ * by registering for different events.
+ */
+void ports::bootstrap()
+{
+    SERVERPLUGINS_LISTEN(ports, server, process_watch, std::placeholders::_1);
+}
+
+
+/** \brief Process this sitter data.
+ *
+ * This function probes all the endpoints at once and updates the
+ * histograms.
+ *
+ * \param[in] json  The document where the results are collected.
+ */
+void ports::on_process_watch(as2js::json::json_value_ref & json)
+{
+    SNAP_LOG_DEBUG
+        << "ports::on_process_watch(): processing"
+        << SNAP_LOG_SEND;
+
+    sitter::server::pointer_t server(plugins()->get_server<sitter::server>());
+
+    advgetopt::string_list_t endpoints;
+    advgetopt::split_string(server->get_server_parameter(g_name_ports_endpoints), endpoints, { "," });
+
+    // forget about endpoints which were removed from the list
+    //
+    for(auto it(f_endpoints.begin()); it != f_endpoints.end(); )
+    {
+        if(std::find(endpoints.begin(), endpoints.end(), it->first) == endpoints.end())
+        {
+            it = f_endpoints.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    if(endpoints.empty())
+    {
+        return;
+    }
+
+    as2js::json::json_value_ref e(json["ports"]);
+
+    std::int64_t const timeout(server->get_integer_parameter(g_name_ports_timeout, 2'000) * 1'000);
+    connect_result_vector_t const results(f_probe.probe(endpoints, timeout));
+    for(auto const & r : results)
+    {
+        as2js::json::json_value_ref p(e["endpoint"][-1]);
+        p["endpoint"] = r.f_endpoint;
+
+        switch(r.f_status)
+        {
+        case connect_status_t::CONNECT_STATUS_SUCCESS:
+            check_latency(e, p, r);
+            break;
+
+        case connect_status_t::CONNECT_STATUS_REFUSED:
+            p["error"] = "refused";
+            server->append_error(
+                  e
+                , "ports"
+                , "nothing accepts connections on \""
+                    + r.f_endpoint
+                    + "\" on \""
+                    + snapdev::gethostname()
+                    + "\": "
+                    + strerror(r.f_errno)
+                    + "."
+                , 70);
+            break;
+
+        case connect_status_t::CONNECT_STATUS_TIMED_OUT:
+            p["error"] = "timed out";
+            server->append_error(
+                  e
+                , "ports"
+                , "the service listening on \""
+                    + r.f_endpoint
+                    + "\" on \""
+                    + snapdev::gethostname()
+                    + "\" did not accept the connection within "
+                    + format_ms(static_cast<double>(timeout))
+                    + "."
+                , 65);
+            break;
+
+        case connect_status_t::CONNECT_STATUS_BUSY:
+            p["error"] = "backlog full";
+            server->append_error(
+                  e
+                , "ports"
+                , "the service listening on \""
+                    + r.f_endpoint
+                    + "\" on \""
+                    + snapdev::gethostname()
+                    + "\" is busy; its backlog of connections waiting to be accepted is full."
+                , 60);
+            break;
+
+        case connect_status_t::CONNECT_STATUS_INVALID:
+            p["error"] = "invalid endpoint";
+            server->append_error(
+                  e
+                , "ports"
+                , "\""
+                    + r.f_endpoint
+                    + "\" is not a valid endpoint; expected an IP address and port or the full path to a Unix socket."
+                , 20);
+            break;
+
+        case connect_status_t::CONNECT_STATUS_FAILED:
+        default:
+            p["error"] = strerror(r.f_errno);
+            server->append_error(
+                  e
+                , "ports"
+                , "could not connect to \""
+                    + r.f_endpoint
+                    + "\" on \""
+                    + snapdev::gethostname()
+                    + "\": "
+                    + strerror(r.f_errno)
+                    + "."
+                , 40);
+            break;
+
+        }
+    }
+}
+
+
+/** \brief Add the latency of a connection and check for a regression.
+ *
+ * \param[in] e  The "ports" object where errors are added.
+ * \param[in] p  The object of the endpoint in the JSON data.
+ * \param[in] r  The result of the connection.
+ */
+void ports::check_latency(
+      as2js::json::json_value_ref & e
+    , as2js::json::json_value_ref & p
+    , connect_result_t const & r)
+{
+    sitter::server::pointer_t server(plugins()->get_server<sitter::server>());
+
+    latency_tracker & t(f_endpoints.try_emplace(r.f_endpoint, g_latency_settings).first->second);
+    t.add(r.f_latency);
+
+    p["latency"] = r.f_latency;
+    p["p99"] = t.recent_percentile(0.99);
+    p["baseline_p99"] = t.baseline_percentile(0.99);
+
+    double const minimum(static_cast<double>(server->get_integer_parameter(g_name_ports_minimum, 5)) * 1000.0);
+    double const regression(static_cast<double>(server->get_integer_parameter(g_name_ports_regression, 300)) / 100.0);
+    if(t.is_regression(minimum, regression))
+    {
+        p["error"] = "latency regression";
+        server->append_error(
+              e
+            , "ports"
+            , "the p99 connect latency of \""
+                + r.f_endpoint
+                + "\" on \""
+                + snapdev::gethostname()
+                + "\" went from "
+                + format_ms(t.previous_baseline_p99())
+                + " to "
+                + format_ms(t.recent_percentile(0.99))
+                + "."
+            , 50);
+    }
+}
+
+
+
+} // namespace ports
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -52,6 +52,7 @@
 #include    <snapdev/glob_to_list.h>
 #include    <snapdev/not_reached.h>
 #include    <snapdev/not_used.h>
+#include    <snapdev/timespec_ex.h>
 #include    <snapdev/trim_string.h>
 
 
@@ -65,6 +66,11 @@
 #include    <regex>
 
 
+// C
+//
+#include    <sys/wait.h>
+
+
 // last include
 //
 #include    <snapdev/poison.h>
@@ -833,6 +839,82 @@ void processes::bootstrap()
 }
 
 
+/** \brief Search for a process definition matching a running process.
+ *
+ * This function goes through the list of processes that still need to
+ * be found and returns the index of the first one that matches.
+ *
+ * \param[in] name  The basename of the command.
+ * \param[in] cmdline  The full command line.
+ *
+ * \return The index of the matching process or -1.
+ */
+int processes::find_process(std::string const & name, std::string const & cmdline)
+{
+    size_t const max_re(g_processes.size());
+//std::cerr << "check process [" << name << "] -> [" << cmdline << "]\n";
+    for(size_t j(0); j < max_re; ++j)
+    {
+        if(g_processes[j].match(name, cmdline))
+        {
+            return static_cast<int>(j);
+        }
+    }
+
+    return -1;
+}
+
+
+/** \brief Output a process that was found.
+ *
+ * This function outputs the process information to the JSON document
+ * and then removes the process definition from the list of processes
+ * to be found.
+ *
+ * \param[in] e  The JSON document where the process gets saved.
+ * \param[in] j  The index of the process definition.
+ * \param[in] info  The information about the running process.
+ */
+void processes::found_process(
+      as2js::json::json_value_ref & e
+    , int j
+    , cppprocess::process_info::pointer_t info)
+{
+    plugins()->get_server<sitter::server>()->output_process(
+          "processes"
+        , e
+        , info
+        , g_processes[j].get_name()
+        , 35);      // <- priority is not used, the pointer cannot be nullptr
+
+    // for backends we have a special case when they are running,
+    // we may actually have them turned off and still running
+    // which is not correct
+    //
+    if(g_processes[j].is_backend()
+    && !g_processes[j].is_process_expected_to_run())
+    {
+        // TODO: get the correct json::json_value_ref to update (i.e. last
+        //       item of array of processes is the process where
+        //       we need to stick this error)
+        //
+        plugins()->get_server<sitter::server>()->append_error(
+                  e
+                , "processes"
+                , "found process \""
+                    + g_processes[j].get_name()
+                    + "\" running when disabled."
+                , 35);
+    }
+
+    // remove from the list, if the list is empty, we are
+    // done; if the list is not empty by the time we return
+    // some processes are missing
+    //
+    g_processes.erase(g_processes.begin() + j);
+}
+
+
 /** \brief Process this sitter data.
  *
  * This function runs this plugin actual check.
@@ -849,80 +931,78 @@ void processes::on_process_watch(as2js::json::json_value_ref & json)
 
     as2js::json::json_value_ref e(json["processes"]);
 
-    cppprocess::process_list list;
-    for(auto it(list.begin()); it != list.end() && !g_processes.empty(); ++it)
+    sitter::server::pointer_t s(plugins()->get_server<sitter::server>());
+    process_connector::pointer_t connector(s->get_process_connector());
+    if(connector != nullptr)
     {
-        std::string name(it->second->get_name());
-
-        // keep the full path in the cmdline parameter
+        // the process connector keeps an index of the running processes
+        // so we do not have to scan the whole /proc directory
         //
-        std::string cmdline(name);
-
-        // compute basename
-        //
-        std::string::size_type p(name.find_last_of('/'));
-        if(p != std::string::npos)
+        std::map<pid_t, std::string> watched;
+        process_connector::process_vector_t const list(connector->get_processes());
+        for(auto it(list.begin()); it != list.end() && !g_processes.empty(); ++it)
         {
-            name = name.substr(p + 1);
+            int const j(find_process(it->f_name, it->f_cmdline));
+            if(j >= 0)
+            {
+                if(g_processes[j].is_mandatory())
+                {
+                    watched[it->f_pid] = g_processes[j].get_name();
+                }
+                found_process(e, j, std::make_shared<cppprocess::process_info>(it->f_pid));
+            }
         }
+        connector->set_watched(watched);
 
-        // add command line arguments
+        // report the mandatory processes which exited since the last tick
+        // (they may have been restarted since, but a crash is still worth
+        // an error)
         //
-        int const count_max(it->second->get_args_size());
-        for(int c(0); c < count_max; ++c)
+        process_connector::exit_vector_t const exits(connector->get_exits());
+        for(auto const & ex : exits)
         {
-            // skip empty arguments
-            //
-            if(!it->second->get_arg(c).empty())
+            std::string message("mandatory process \"");
+            message += ex.f_name;
+            message += "\" (";
+            message += std::to_string(ex.f_pid);
+            message += ") exited ";
+            if(WIFSIGNALED(ex.f_status))
             {
-                cmdline += ' ';
-
-                // IMPORTANT NOTE: we should escape special characters
-                //                 only it would make the command line
-                //                 regular expression more complicated
-                //
-                cmdline += it->second->get_arg(c);
+                message += "on signal ";
+                message += std::to_string(WTERMSIG(ex.f_status));
             }
+            else
+            {
+                message += "with code ";
+                message += std::to_string(WEXITSTATUS(ex.f_status));
+            }
+            message += " on ";
+            message += snapdev::timespec_ex(ex.f_date, 0).to_string();
+            message += '.';
+
+            s->append_error(
+                      e
+                    , "processes"
+                    , message
+                    , 70);
         }
-        size_t const max_re(g_processes.size());
-//std::cerr << "check process [" << name << "] -> [" << cmdline << "]\n";
-        for(size_t j(0); j < max_re; ++j)
+    }
+    else
+    {
+        std::vector<pid_t> const pids(process_snapshot::get_pids());
+        for(auto it(pids.begin()); it != pids.end() && !g_processes.empty(); ++it)
         {
-            if(g_processes[j].match(name, cmdline))
+            process_snapshot::process_t p;
+            p.f_pid = *it;
+            if(!process_snapshot::load_command(p))
             {
-                plugins()->get_server<sitter::server>()->output_process(
-                      "processes"
-                    , e
-                    , it->second
-                    , g_processes[j].get_name()
-                    , 35);      // <- priority is not used, the pointer cannot be nullptr
-
-                // for backends we have a special case when they are running,
-                // we may actually have them turned off and still running
-                // which is not correct
-                //
-                if(g_processes[j].is_backend()
-                && !g_processes[j].is_process_expected_to_run())
-                {
-                    // TODO: get the correct json::json_value_ref to update (i.e. last
-                    //       item of array of processes is the process where
-                    //       we need to stick this error)
-                    //
-                    plugins()->get_server<sitter::server>()->append_error(
-                              e
-                            , "processes"
-                            , "found process \""
-                                + g_processes[j].get_name()
-                                + "\" running when disabled."
-                            , 35);
-                }
+                continue;
+            }
 
-                // remove from the list, if the list is empty, we are
-                // done; if the list is not empty by the time we return
-                // some processes are missing
-                //
-                g_processes.erase(g_processes.begin() + j);
-                break;
+            int const j(find_process(p.f_command, p.f_cmdline));
+            if(j >= 0)
+            {
+                found_process(e, j, std::make_shared<cppprocess::process_info>(p.f_pid));
             }
         }
     }
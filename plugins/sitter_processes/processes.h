@@ -51,6 +51,11 @@ public:
     void                on_process_watch(as2js::json::json_value_ref & json);
 
 private:
+    int                 find_process(std::string const & name, std::string const & cmdline);
+    void                found_process(
+                              as2js::json::json_value_ref & e
+                            , int j
+                            , cppprocess::process_info::pointer_t info);
 };
 
 } // namespace processes
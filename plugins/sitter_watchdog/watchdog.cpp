@@ -0,0 +1,168 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "watchdog.h"
+
+#include    "names.h"
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// snapdev
+//
+#include    <snapdev/gethostname.h>
+
+
+// serverplugins
+//
+#include    <serverplugins/collection.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+/** \file
+ * \brief Report services which do not answer ALIVE messages.
+ *
+ * The service watchdog (see sitter/service_watchdog.cpp) sends an ALIVE
+ * message to each service listed in the watchdog_services parameter,
+ * one service at a time, and measures the round trip time of the
+ * ABSOLUTELY replies.
+ *
+ * This plugin reports the services which missed several ALIVE messages
+ * in a row and the services whose recent p99 round trip time regressed
+ * compared to their usual p99 round trip time.
+ */
+
+
+
+namespace sitter
+{
+namespace watchdog
+{
+
+SERVERPLUGINS_START(watchdog)
+    , ::serverplugins::description(
+            "Check that the services answer messages in a timely manner.")
+    , ::serverplugins::dependency("server")
+    , ::serverplugins::help_uri("https://snapwebsites.org/help")
+    , ::serverplugins::categorization_tag("network")
+SERVERPLUGINS_END(watchdog)
+
+
+
+
+/** \brief Initialize watchdog.
+ *
+ * This function terminates the initialization of the watchdog plugin
+ * by registering for different events.
+ */
+void watchdog::bootstrap()
+{
+    SERVERPLUGINS_LISTEN(watchdog, server, process_watch, std::placeholders::_1);
+}
+
+
+/** \brief Process this sitter data.
+ *
+ * This function saves the status of each watched service and reports
+ * the services which stopped answering or became slow.
+ *
+ * \param[in] json  The document where the results are collected.
+ */
+void watchdog::on_process_watch(as2js::json::json_value_ref & json)
+{
+    SNAP_LOG_DEBUG
+        << "watchdog::on_process_watch(): processing"
+        << SNAP_LOG_SEND;
+
+    sitter::server::pointer_t server(plugins()->get_server<sitter::server>());
+    service_watchdog::pointer_t w(server->get_service_watchdog());
+    if(w == nullptr)
+    {
+        return;
+    }
+
+    as2js::json::json_value_ref e(json["watchdog"]);
+
+    double const minimum(static_cast<double>(server->get_integer_parameter(g_name_watchdog_minimum, 10)) * 1000.0);
+    double const regression(static_cast<double>(server->get_integer_parameter(g_name_watchdog_regression, 300)) / 100.0);
+
+    for(auto const & s : w->get_status())
+    {
+        as2js::json::json_value_ref p(e["service"][-1]);
+        p["name"] = s.f_name;
+        p["sent"] = s.f_sent;
+        p["replies"] = s.f_replies;
+        p["missed"] = s.f_missed;
+        p["last_reply"] = s.f_last_reply;
+        p["last_latency"] = s.f_last_latency;
+        p["p99"] = s.f_latency.recent_percentile(0.99);
+        p["baseline_p99"] = s.f_latency.baseline_percentile(0.99);
+
+        if(s.f_missed >= MISSED_LIMIT)
+        {
+            p["error"] = "not answering";
+            server->append_error(
+                  e
+                , "watchdog"
+                , "service \""
+                    + s.f_name
+                    + "\" on \""
+                    + snapdev::gethostname()
+                    + "\" did not answer the last "
+                    + std::to_string(s.f_missed)
+                    + " ALIVE messages."
+                , 80);
+            continue;
+        }
+
+        if(s.f_latency.is_regression(minimum, regression))
+        {
+            p["error"] = "latency regression";
+            server->append_error(
+                  e
+                , "watchdog"
+                , "the p99 round trip time of the ALIVE messages sent to service \""
+                    + s.f_name
+                    + "\" on \""
+                    + snapdev::gethostname()
+                    + "\" went from "
+                    + format_ms(s.f_latency.previous_baseline_p99())
+                    + " to "
+                    + format_ms(s.f_latency.recent_percentile(0.99))
+                    + "."
+                , 55);
+        }
+    }
+}
+
+
+
+} // namespace watchdog
+} // namespace sitter
+// vim: ts=4 sw=4 et
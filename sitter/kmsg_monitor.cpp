@@ -0,0 +1,489 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "sitter/kmsg_monitor.h"
+
+#include    "sitter/sitter.h"
+
+
+// cppthread
+//
+#include    <cppthread/guard.h>
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// C++
+//
+#include    <algorithm>
+#include    <functional>
+
+
+// C
+//
+#include    <fcntl.h>
+#include    <string.h>
+#include    <syslog.h>
+#include    <unistd.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the kernel log reader.
+ *
+ * Each read() of /dev/kmsg returns exactly one record. The record starts
+ * with a header: the syslog priority (facility and level), a sequence
+ * number, a timestamp, and flags. The header ends with a semicolon and
+ * is followed by the message and a newline. Continuation lines starting
+ * with a space may follow; they are ignored here.
+ *
+ * The file is opened at its end. The records which were in the ring
+ * buffer before the sitter started are not classified again; this
+ * avoids reporting the same out of memory kill after each restart of
+ * the sitter. When the kernel overwrites records before we read them,
+ * read() fails with EPIPE. The number of records lost is computed from
+ * the gap in the sequence numbers.
+ *
+ * Reading /dev/kmsg requires the CAP_SYSLOG capability when the
+ * kernel.dmesg_restrict sysctl is set.
+ */
+
+
+
+namespace sitter
+{
+
+
+
+namespace
+{
+
+
+
+struct kmsg_rule_t
+{
+    char const *        f_class = nullptr;
+    char const *        f_description = nullptr;
+    int                 f_priority = 0;
+    char const *        f_literal = nullptr;
+};
+
+
+/** \brief The rules used to classify the kernel records.
+ *
+ * The first rule with a literal found in the message defines the class
+ * of the record. Rules of the same class must follow each other.
+ *
+ * A record which does not match any rule is classified using its level
+ * if it was sent by the kernel (see the "critical" and "error" classes
+ * in the constructor).
+ */
+constexpr kmsg_rule_t const g_rules[] =
+{
+    { "oom_kill",          "out of memory kill",        90, "Out of memory: Killed process" },
+    { "cgroup_oom_kill",   "cgroup out of memory kill", 70, "Memory cgroup out of memory: Killed process" },
+    { "kernel_bug",        "kernel bug",                85, "kernel BUG at" },
+    { "kernel_bug",        "kernel bug",                85, "BUG: unable to handle" },
+    { "kernel_bug",        "kernel bug",                85, "general protection fault" },
+    { "kernel_bug",        "kernel bug",                85, "Oops: " },
+    { "lockup",            "CPU lockup",                85, "soft lockup - CPU#" },
+    { "lockup",            "CPU lockup",                85, "Watchdog detected hard LOCKUP" },
+    { "rcu_stall",         "RCU stall",                 70, "detected stall" },
+    { "hung_task",         "hung task",                 70, "blocked for more than" },
+    { "machine_check",     "hardware error",            80, "Machine check events logged" },
+    { "machine_check",     "hardware error",            80, "[Hardware Error]" },
+    { "fs_error",          "file system error",         80, "EXT4-fs error" },
+    { "fs_error",          "file system error",         80, "BTRFS error" },
+    { "fs_error",          "file system error",         80, "xfs_do_force_shutdown" },
+    { "fs_error",          "file system error",         80, "Remounting filesystem read-only" },
+    { "io_error",          "I/O error",                 75, "I/O error" },
+    { "io_error",          "I/O error",                 75, "exception Emask" },
+    { "nic_reset",         "network card reset",        60, "NETDEV WATCHDOG" },
+    { "nic_reset",         "network card reset",        60, "Reset adapter" },
+    { "nic_reset",         "network card reset",        60, "Detected Hardware Unit Hang" },
+    { "segfault",          "segmentation fault",        30, " segfault at " },
+    { "kernel_warning",    "kernel warning",            40, "WARNING: CPU:" },
+};
+
+
+
+constexpr char const         TRAPS_PREFIX[] = "traps: ";
+constexpr std::size_t const  TRAPS_PREFIX_LENGTH = sizeof(TRAPS_PREFIX) - 1;
+
+
+
+} // no name namespace
+
+
+
+/** \class kmsg_monitor
+ * \brief Read the kernel log as records arrive.
+ *
+ * This class is a connection added to the ed::communicator. The records
+ * are classified from the main thread and the counters are read from
+ * the worker thread so all accesses are protected by a mutex.
+ */
+
+
+
+/** \brief Initialize the kernel log monitor.
+ *
+ * The constructor compiles the rules and opens /dev/kmsg in non-blocking
+ * mode. The position is moved to the end of the ring buffer so only new
+ * records get classified.
+ *
+ * \param[in] s  A pointer to the server object.
+ */
+kmsg_monitor::kmsg_monitor(server * s)
+    : f_server(s)
+    , f_kmsg(open("/dev/kmsg", O_RDONLY | O_NONBLOCK | O_CLOEXEC))
+{
+    set_name("kmsg_monitor");
+
+    if(f_kmsg.get() == -1)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not open /dev/kmsg (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << "); the kernel log will not be monitored."
+            << SNAP_LOG_SEND;
+        return;
+    }
+
+    if(lseek(f_kmsg.get(), 0, SEEK_END) == -1)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not seek to the end of /dev/kmsg (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << "); the kernel log will not be monitored."
+            << SNAP_LOG_SEND;
+        f_kmsg.reset();
+        return;
+    }
+
+    compile_rules();
+}
+
+
+kmsg_monitor::~kmsg_monitor()
+{
+}
+
+
+/** \brief Check whether the monitor is reading the kernel log.
+ *
+ * \return true if /dev/kmsg is open.
+ */
+bool kmsg_monitor::is_listening() const
+{
+    return f_kmsg.get() != -1;
+}
+
+
+/** \brief Retrieve the counters.
+ *
+ * This function returns the classes which had at least one record since
+ * the last call along with the total number of records read and lost.
+ * The internal counters are reset.
+ *
+ * \return The counters since the last call.
+ */
+kmsg_monitor::kmsg_counts_t kmsg_monitor::get_counts()
+{
+    cppthread::guard lock(f_mutex);
+
+    kmsg_counts_t result;
+    result.f_records = f_counts.f_records;
+    result.f_lost = f_counts.f_lost;
+    f_counts.f_records = 0;
+    f_counts.f_lost = 0;
+    for(auto & c : f_counts.f_classes)
+    {
+        if(c.f_count > 0)
+        {
+            result.f_classes.push_back(c);
+            c.f_count = 0;
+            c.f_last_message.clear();
+        }
+    }
+    return result;
+}
+
+
+/** \brief The kernel log monitor is a reader.
+ *
+ * \return Always true.
+ */
+bool kmsg_monitor::is_reader() const
+{
+    return true;
+}
+
+
+/** \brief Return the /dev/kmsg file descriptor.
+ *
+ * \return The file descriptor or -1 if it is not open.
+ */
+int kmsg_monitor::get_socket() const
+{
+    return f_kmsg.get();
+}
+
+
+/** \brief Read the new kernel records.
+ *
+ * This function reads the records currently available. To not block the
+ * event loop during a storm of kernel messages, at most
+ * MAXIMUM_RECORDS_PER_READ records are read at once; the descriptor
+ * remains readable so the communicator calls us again.
+ *
+ * A record of a class with a priority of FORCE_TICK_PRIORITY or more
+ * forces a tick so it gets reported right away.
+ */
+void kmsg_monitor::process_read()
+{
+    char buf[MAXIMUM_RECORD_SIZE];
+
+    bool force_tick(false);
+    for(std::size_t count(0); count < MAXIMUM_RECORDS_PER_READ; ++count)
+    {
+        ssize_t const r(read(f_kmsg.get(), buf, sizeof(buf)));
+        if(r < 0)
+        {
+            int const e(errno);
+            if(e == EINTR)
+            {
+                continue;
+            }
+            if(e == EPIPE)
+            {
+                // the kernel overwrote records before we could read
+                // them; the next read() returns the oldest record
+                // still available and the gap in the sequence numbers
+                // tells us how many were lost
+                //
+                continue;
+            }
+            if(e != EAGAIN)
+            {
+                SNAP_LOG_ERROR
+                    << "kernel log monitor failed reading /dev/kmsg (errno: "
+                    << e
+                    << ", "
+                    << strerror(e)
+                    << ")."
+                    << SNAP_LOG_SEND;
+            }
+            break;
+        }
+        if(r == 0)
+        {
+            break;
+        }
+
+        if(classify(buf, static_cast<std::size_t>(r)))
+        {
+            force_tick = true;
+        }
+    }
+
+    if(force_tick)
+    {
+        f_server->force_tick();
+    }
+}
+
+
+/** \brief Compile the classification rules.
+ *
+ * Each literal gets its own Boyer-Moore-Horspool searcher so the tables
+ * are computed once instead of on each record. The classes are created
+ * in the order of the rules, followed by the "critical" and "error"
+ * classes used for the records which do not match any rule.
+ */
+void kmsg_monitor::compile_rules()
+{
+    kmsg_class_vector_t & classes(f_counts.f_classes);
+    for(auto const & r : g_rules)
+    {
+        if(classes.empty()
+        || classes.back().f_name != r.f_class)
+        {
+            kmsg_class_t c;
+            c.f_name = r.f_class;
+            c.f_description = r.f_description;
+            c.f_priority = r.f_priority;
+            classes.push_back(c);
+        }
+
+        char const * const literal(r.f_literal);
+        std::boyer_moore_horspool_searcher<char const *> const searcher(
+                  literal
+                , literal + strlen(literal));
+
+        rule_t rule;
+        rule.f_class = classes.size() - 1;
+        rule.f_searcher = [searcher](char const * begin, char const * end)
+            {
+                char const * const pos(std::search(begin, end, searcher));
+                return pos == end ? nullptr : pos;
+            };
+        f_rules.push_back(rule);
+    }
+
+    kmsg_class_t critical;
+    critical.f_name = "critical";
+    critical.f_description = "critical kernel message";
+    critical.f_priority = 60;
+    f_critical = classes.size();
+    classes.push_back(critical);
+
+    kmsg_class_t error;
+    error.f_name = "error";
+    error.f_description = "kernel error message";
+    error.f_priority = 20;
+    f_error = classes.size();
+    classes.push_back(error);
+}
+
+
+/** \brief Classify one record.
+ *
+ * The record header is parsed to get the syslog priority and the
+ * sequence number. The message is then searched for the literal of each
+ * rule. A record which matches no rule is classified using its level,
+ * but only if it was sent by the kernel itself (facility 0); user space
+ * tools can also write to /dev/kmsg. The faults of user space processes
+ * ("traps: ..." records) do not go through the rules.
+ *
+ * \param[in] record  The record as read from /dev/kmsg.
+ * \param[in] size  The size of the record.
+ *
+ * \return true if the class of the record requires a tick right away.
+ */
+bool kmsg_monitor::classify(char const * record, std::size_t size)
+{
+    char const * const end(record + size);
+    char const * const semicolon(static_cast<char const *>(memchr(record, ';', size)));
+    if(semicolon == nullptr)
+    {
+        return false;
+    }
+
+    int syslog_priority(0);
+    char const * s(record);
+    for(; s < semicolon && *s >= '0' && *s <= '9'; ++s)
+    {
+        syslog_priority = syslog_priority * 10 + (*s - '0');
+    }
+    std::uint64_t sequence(0);
+    if(s < semicolon
+    && *s == ',')
+    {
+        for(++s; s < semicolon && *s >= '0' && *s <= '9'; ++s)
+        {
+            sequence = sequence * 10 + (*s - '0');
+        }
+    }
+    int const level(LOG_PRI(syslog_priority));
+    bool const from_kernel((syslog_priority & LOG_FACMASK) == LOG_KERN);
+
+    char const * const message(semicolon + 1);
+    char const * eol(static_cast<char const *>(memchr(message, '\n', end - message)));
+    if(eol == nullptr)
+    {
+        eol = end;
+    }
+
+    // the kernel reports faults of user space processes with a "traps:"
+    // prefix (i.e. "traps: app[123] general protection fault ip:...");
+    // those are not kernel bugs so the rules are skipped
+    //
+    std::size_t idx(f_counts.f_classes.size());
+    if(static_cast<std::size_t>(eol - message) < TRAPS_PREFIX_LENGTH
+    || memcmp(message, TRAPS_PREFIX, TRAPS_PREFIX_LENGTH) != 0)
+    {
+        for(auto const & r : f_rules)
+        {
+            if(r.f_searcher(message, eol) != nullptr)
+            {
+                idx = r.f_class;
+                break;
+            }
+        }
+    }
+    if(idx == f_counts.f_classes.size()
+    && from_kernel)
+    {
+        if(level <= LOG_CRIT)
+        {
+            idx = f_critical;
+        }
+        else if(level == LOG_ERR)
+        {
+            idx = f_error;
+        }
+    }
+
+    cppthread::guard lock(f_mutex);
+
+    ++f_counts.f_records;
+    if(f_sequence != 0
+    && sequence > f_sequence + 1)
+    {
+        f_counts.f_lost += static_cast<std::int64_t>(sequence - f_sequence - 1);
+    }
+    f_sequence = sequence;
+
+    if(idx == f_counts.f_classes.size())
+    {
+        return false;
+    }
+
+    kmsg_class_t & c(f_counts.f_classes[idx]);
+    ++c.f_count;
+    c.f_last_message.assign(
+              message
+            , std::min(static_cast<std::size_t>(eol - message), MAXIMUM_MESSAGE_LENGTH));
+
+    return c.f_priority >= FORCE_TICK_PRIORITY;
+}
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,132 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// eventdispatcher
+//
+#include    <eventdispatcher/connection.h>
+
+
+// cppthread
+//
+#include    <cppthread/mutex.h>
+
+
+// snapdev
+//
+#include    <snapdev/raii_generic_deleter.h>
+
+
+// C++
+//
+#include    <functional>
+#include    <string>
+#include    <vector>
+
+
+
+/** \file
+ * \brief This file declares a reader of the kernel log.
+ *
+ * Out of memory kills, hung tasks, I/O errors, and network card resets
+ * only appear in the kernel ring buffer. The monitor keeps /dev/kmsg
+ * open and classifies each record as it arrives so the kernel plugin
+ * can report the number of events of each class on each tick.
+ *
+ * This is considered an internal class.
+ */
+
+
+
+
+namespace sitter
+{
+
+
+
+class server;
+
+class kmsg_monitor
+    : public ed::connection
+{
+public:
+    typedef std::shared_ptr<kmsg_monitor>       pointer_t;
+
+    struct kmsg_class_t
+    {
+        std::string             f_name = std::string();
+        std::string             f_description = std::string();
+        int                     f_priority = 0;
+        std::int64_t            f_count = 0;
+        std::string             f_last_message = std::string();
+    };
+    typedef std::vector<kmsg_class_t>           kmsg_class_vector_t;
+
+    struct kmsg_counts_t
+    {
+        kmsg_class_vector_t     f_classes = kmsg_class_vector_t();
+        std::int64_t            f_records = 0;
+        std::int64_t            f_lost = 0;
+    };
+
+    static constexpr int const                  FORCE_TICK_PRIORITY = 80;
+    static constexpr std::size_t const          MAXIMUM_RECORD_SIZE = 8192;
+    static constexpr std::size_t const          MAXIMUM_RECORDS_PER_READ = 1000;
+    static constexpr std::size_t const          MAXIMUM_MESSAGE_LENGTH = 256;
+
+                                kmsg_monitor(server * s);
+                                kmsg_monitor(kmsg_monitor const & rhs) = delete;
+    virtual                     ~kmsg_monitor() override;
+    kmsg_monitor &              operator = (kmsg_monitor const & rhs) = delete;
+
+    bool                        is_listening() const;
+    kmsg_counts_t               get_counts();
+
+    // ed::connection implementation
+    virtual bool                is_reader() const override;
+    virtual int                 get_socket() const override;
+    virtual void                process_read() override;
+
+private:
+    typedef std::function<char const *(char const *, char const *)>
+                                                searcher_t;
+
+    struct rule_t
+    {
+        std::size_t             f_class = 0;
+        searcher_t              f_searcher = searcher_t();
+    };
+    typedef std::vector<rule_t>                 rule_vector_t;
+
+    void                        compile_rules();
+    bool                        classify(char const * record, std::size_t size);
+
+    server *                    f_server = nullptr;
+    snapdev::raii_fd_t          f_kmsg = snapdev::raii_fd_t();
+    rule_vector_t               f_rules = rule_vector_t();
+    std::size_t                 f_critical = 0;
+    std::size_t                 f_error = 0;
+    std::uint64_t               f_sequence = 0;
+    cppthread::mutex            f_mutex = cppthread::mutex();
+    kmsg_counts_t               f_counts = kmsg_counts_t();
+};
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,135 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "sitter/latency_histogram.h"
+
+
+// C++
+//
+#include    <cmath>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements a latency histogram.
+ *
+ * The histogram uses logarithmic buckets so it covers latencies from
+ * one microsecond to over an hour with a constant relative precision
+ * (about 19%) in a fixed amount of memory.
+ *
+ * The counts are doubles so the histogram can be decayed: multiplying
+ * all the counts by a factor smaller than 1.0 before adding new samples
+ * gives more weight to the recent samples.
+ */
+
+
+
+namespace sitter
+{
+
+
+
+/** \brief Add one sample to the histogram.
+ *
+ * \param[in] usec  The latency in microseconds.
+ */
+void latency_histogram::add(double usec)
+{
+    std::size_t idx(0);
+    if(usec > 1.0)
+    {
+        idx = static_cast<std::size_t>(std::log2(usec) * BUCKETS_PER_POWER);
+        if(idx >= BUCKETS)
+        {
+            idx = BUCKETS - 1;
+        }
+    }
+    f_buckets[idx] += 1.0;
+    f_count += 1.0;
+}
+
+
+/** \brief Reduce the weight of the existing samples.
+ *
+ * \param[in] factor  The factor applied to all the counts, between 0.0
+ * and 1.0.
+ */
+void latency_histogram::decay(double factor)
+{
+    for(auto & b : f_buckets)
+    {
+        b *= factor;
+    }
+    f_count *= factor;
+}
+
+
+/** \brief Get the (weighted) number of samples in the histogram.
+ *
+ * \return The number of samples.
+ */
+double latency_histogram::count() const
+{
+    return f_count;
+}
+
+
+/** \brief Compute a percentile.
+ *
+ * The function returns the upper bound of the bucket where the
+ * percentile falls.
+ *
+ * \param[in] p  The percentile, between 0.0 and 1.0 (i.e. 0.99 for p99).
+ *
+ * \return The latency in microseconds or 0.0 if the histogram is empty.
+ */
+double latency_histogram::percentile(double p) const
+{
+    if(f_count <= 0.0)
+    {
+        return 0.0;
+    }
+
+    double const target(f_count * p);
+    double sum(0.0);
+    for(std::size_t idx(0); idx < BUCKETS; ++idx)
+    {
+        sum += f_buckets[idx];
+        if(sum >= target)
+        {
+            return std::exp2(static_cast<double>(idx + 1) / BUCKETS_PER_POWER);
+        }
+    }
+
+    return std::exp2(static_cast<double>(BUCKETS) / BUCKETS_PER_POWER);
+}
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
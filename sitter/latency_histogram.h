@@ -0,0 +1,67 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <array>
+#include    <cstddef>
+
+
+
+/** \file
+ * \brief This file declares a latency histogram.
+ *
+ * The histogram is used by the latency tracker (see latency_tracker.h)
+ * which keeps a decaying baseline and a recent window of latencies for
+ * the service watchdog and the plugins measuring latencies (i.e.
+ * iolatency and ports).
+ */
+
+
+
+
+namespace sitter
+{
+
+
+
+class latency_histogram
+{
+public:
+    // 4 buckets per power of 2 starting at 1 microsecond, so the last
+    // bucket starts at about 1h10m
+    //
+    static constexpr std::size_t const  BUCKETS_PER_POWER = 4;
+    static constexpr std::size_t const  BUCKETS = 32 * BUCKETS_PER_POWER;
+
+    void                    add(double usec);
+    void                    decay(double factor);
+    double                  count() const;
+    double                  percentile(double p) const;
+
+private:
+    std::array<double, BUCKETS>
+                            f_buckets = std::array<double, BUCKETS>();
+    double                  f_count = 0.0;
+};
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
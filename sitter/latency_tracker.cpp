@@ -0,0 +1,211 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "sitter/latency_tracker.h"
+
+#include    "sitter/monotonic_clock.h"
+
+
+// C++
+//
+#include    <cmath>
+#include    <iomanip>
+#include    <sstream>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements a latency regression tracker.
+ *
+ * Each time samples get added, both histograms are first decayed by
+ * a factor computed from the time elapsed since the previous samples:
+ * a sample added T seconds ago weights exp(-T / period). This way the
+ * baseline covers about the same amount of time whether the samples
+ * come once a minute or once every few seconds (i.e. forced ticks).
+ *
+ * The baseline used to detect a regression is the one from before the
+ * last samples were added so a sudden jump does not hide itself by
+ * raising the baseline.
+ */
+
+
+
+namespace sitter
+{
+
+
+
+/** \brief Initialize the tracker.
+ *
+ * \param[in] settings  The periods and minimums used by this tracker.
+ */
+latency_tracker::latency_tracker(latency_settings_t const & settings)
+    : f_settings(settings)
+{
+}
+
+
+/** \brief Add one latency sample.
+ *
+ * \param[in] usec  The latency in microseconds.
+ */
+void latency_tracker::add(double usec)
+{
+    decay();
+    f_baseline.add(usec);
+    f_recent.add(usec);
+}
+
+
+/** \brief Add a set of latency samples taken at the same time.
+ *
+ * \param[in] usec  The latencies in microseconds.
+ */
+void latency_tracker::add(std::vector<double> const & usec)
+{
+    decay();
+    for(auto const s : usec)
+    {
+        f_baseline.add(s);
+        f_recent.add(s);
+    }
+}
+
+
+/** \brief Get a percentile of the recent latencies.
+ *
+ * \param[in] p  The percentile, between 0.0 and 1.0.
+ *
+ * \return The latency in microseconds.
+ */
+double latency_tracker::recent_percentile(double p) const
+{
+    return f_recent.percentile(p);
+}
+
+
+/** \brief Get a percentile of the baseline latencies.
+ *
+ * \param[in] p  The percentile, between 0.0 and 1.0.
+ *
+ * \return The latency in microseconds.
+ */
+double latency_tracker::baseline_percentile(double p) const
+{
+    return f_baseline.percentile(p);
+}
+
+
+/** \brief Get the p99 of the baseline before the last samples.
+ *
+ * \return The latency in microseconds.
+ */
+double latency_tracker::previous_baseline_p99() const
+{
+    return f_previous_baseline_p99;
+}
+
+
+/** \brief Check whether the baseline can be trusted.
+ *
+ * The baseline must include enough samples and cover a long enough
+ * period of time before it gets compared against the recent latencies.
+ *
+ * \return true if the baseline is usable.
+ */
+bool latency_tracker::has_baseline() const
+{
+    return f_previous_baseline_count >= f_settings.f_minimum_samples
+        && f_last_time - f_first_time >= f_settings.f_minimum_period;
+}
+
+
+/** \brief Check whether the recent latencies regressed.
+ *
+ * \param[in] minimum  The recent p99 must be at least this latency, in
+ * microseconds, to be considered a regression.
+ * \param[in] factor  The recent p99 must be at least this many times
+ * the baseline p99.
+ *
+ * \return true if the recent p99 regressed compared to the baseline.
+ */
+bool latency_tracker::is_regression(double minimum, double factor) const
+{
+    if(!has_baseline())
+    {
+        return false;
+    }
+
+    double const recent_p99(f_recent.percentile(0.99));
+    return recent_p99 >= minimum
+        && recent_p99 >= f_previous_baseline_p99 * factor;
+}
+
+
+/** \brief Decay the histograms before adding new samples.
+ *
+ * This function also saves the state of the baseline before the new
+ * samples get added.
+ */
+void latency_tracker::decay()
+{
+    double const now(monotonic_seconds());
+    if(f_last_time <= 0.0)
+    {
+        f_first_time = now;
+    }
+    else
+    {
+        double const elapsed(now - f_last_time);
+        f_baseline.decay(std::exp(-elapsed / f_settings.f_baseline_period));
+        f_recent.decay(std::exp(-elapsed / f_settings.f_recent_period));
+    }
+    f_last_time = now;
+
+    f_previous_baseline_count = f_baseline.count();
+    f_previous_baseline_p99 = f_baseline.percentile(0.99);
+}
+
+
+/** \brief Format a latency in milliseconds.
+ *
+ * \param[in] usec  The latency in microseconds.
+ *
+ * \return The latency as a string such as "12.3 ms".
+ */
+std::string format_ms(double usec)
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1) << usec / 1000.0 << " ms";
+    return ss.str();
+}
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
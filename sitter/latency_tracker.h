@@ -0,0 +1,90 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    <sitter/latency_histogram.h>
+
+
+// C++
+//
+#include    <string>
+#include    <vector>
+
+
+
+/** \file
+ * \brief This file declares a latency regression tracker.
+ *
+ * The service watchdog and the plugins measuring latencies (ports,
+ * iolatency) all compare the recent p99 latency against a long term
+ * baseline. The tracker keeps both histograms and decays them with the
+ * time elapsed between samples so the result does not depend on how
+ * often the samples are taken.
+ */
+
+
+
+
+namespace sitter
+{
+
+
+
+struct latency_settings_t
+{
+    double                  f_baseline_period = 3600.0;     // seconds, the baseline weight is divided by e over that period
+    double                  f_recent_period = 300.0;        // seconds, the recent weight is divided by e over that period
+    double                  f_minimum_samples = 30.0;       // weighted count of samples in the baseline
+    double                  f_minimum_period = 1800.0;      // seconds of history before the baseline is trusted
+};
+
+
+class latency_tracker
+{
+public:
+                            latency_tracker(latency_settings_t const & settings = latency_settings_t());
+
+    void                    add(double usec);
+    void                    add(std::vector<double> const & usec);
+    double                  recent_percentile(double p) const;
+    double                  baseline_percentile(double p) const;
+    double                  previous_baseline_p99() const;
+    bool                    has_baseline() const;
+    bool                    is_regression(double minimum, double factor) const;
+
+private:
+    void                    decay();
+
+    latency_settings_t      f_settings = latency_settings_t();
+    latency_histogram       f_baseline = latency_histogram();
+    latency_histogram       f_recent = latency_histogram();
+    double                  f_first_time = 0.0;
+    double                  f_last_time = 0.0;
+    double                  f_previous_baseline_count = 0.0;
+    double                  f_previous_baseline_p99 = 0.0;
+};
+
+
+std::string                 format_ms(double usec);
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
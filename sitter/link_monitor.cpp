@@ -0,0 +1,379 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "sitter/link_monitor.h"
+
+#include    "sitter/sitter.h"
+
+
+// cppthread
+//
+#include    <cppthread/guard.h>
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// C
+//
+#include    <linux/if.h>
+#include    <linux/netlink.h>
+#include    <linux/rtnetlink.h>
+#include    <string.h>
+#include    <sys/socket.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the network link listener.
+ *
+ * The network plugin samples the interface counters once per tick. A
+ * link which goes down and back up between two ticks would never be
+ * noticed. This listener receives the link events from the kernel as
+ * they happen and records the transitions of the operational state
+ * (carrier) of each interface. The network plugin reports them on the
+ * next tick. A link going down forces a tick so the error is reported
+ * right away.
+ *
+ * The RTMGRP_LINK group does not require any special capability.
+ */
+
+
+
+namespace sitter
+{
+
+
+
+/** \class link_monitor
+ * \brief Listen to the kernel link events.
+ *
+ * This class is a connection added to the ed::communicator. The events
+ * are recorded from the main thread and read from the worker thread so
+ * all accesses are protected by a mutex.
+ */
+
+
+
+/** \brief Initialize the link monitor.
+ *
+ * The constructor creates the netlink socket, subscribes to the link
+ * events, and requests a dump of all the links so the current state of
+ * each interface is known before the first event arrives.
+ *
+ * \param[in] s  A pointer to the server object.
+ */
+link_monitor::link_monitor(server * s)
+    : f_server(s)
+{
+    set_name("link_monitor");
+
+    if(!subscribe()
+    || !request_dump())
+    {
+        f_socket.reset();
+    }
+}
+
+
+link_monitor::~link_monitor()
+{
+}
+
+
+/** \brief Check whether the monitor is listening to link events.
+ *
+ * \return true if the link events are being received.
+ */
+bool link_monitor::is_listening() const
+{
+    return f_socket.get() != -1;
+}
+
+
+/** \brief Retrieve the link events.
+ *
+ * This function returns the list of link state changes which happened
+ * since the last call. The internal list is cleared.
+ *
+ * \return The list of link events.
+ */
+link_monitor::link_event_vector_t link_monitor::get_events()
+{
+    cppthread::guard lock(f_mutex);
+
+    link_event_vector_t result;
+    result.swap(f_events);
+    return result;
+}
+
+
+/** \brief The link monitor is a reader.
+ *
+ * \return Always true.
+ */
+bool link_monitor::is_reader() const
+{
+    return true;
+}
+
+
+/** \brief Return the netlink socket.
+ *
+ * \return The netlink socket or -1 if it is not open.
+ */
+int link_monitor::get_socket() const
+{
+    return f_socket.get();
+}
+
+
+/** \brief Read the link events.
+ *
+ * This function reads all the messages currently available on the
+ * socket. The answer to the initial dump and the asynchronous events
+ * are both RTM_NEWLINK messages. The first message about an interface
+ * only records its state; the following ones record an event when the
+ * state changes.
+ */
+void link_monitor::process_read()
+{
+    alignas(nlmsghdr) char buf[16384];
+
+    bool force_tick(false);
+    for(;;)
+    {
+        ssize_t const r(recv(f_socket.get(), buf, sizeof(buf), 0));
+        if(r < 0)
+        {
+            int const e(errno);
+            if(e == EINTR)
+            {
+                continue;
+            }
+            if(e == ENOBUFS)
+            {
+                // we lost some events, get the current state again
+                //
+                SNAP_LOG_WARNING
+                    << "link monitor lost events; requesting the state of all the links."
+                    << SNAP_LOG_SEND;
+                request_dump();
+                continue;
+            }
+            if(e != EAGAIN)
+            {
+                SNAP_LOG_ERROR
+                    << "link monitor failed reading events (errno: "
+                    << e
+                    << ", "
+                    << strerror(e)
+                    << ")."
+                    << SNAP_LOG_SEND;
+            }
+            break;
+        }
+        if(r == 0)
+        {
+            break;
+        }
+
+        cppthread::guard lock(f_mutex);
+
+        int len(static_cast<int>(r));
+        for(nlmsghdr const * nlh(reinterpret_cast<nlmsghdr const *>(buf));
+            NLMSG_OK(nlh, len);
+            nlh = NLMSG_NEXT(nlh, len))
+        {
+            if(nlh->nlmsg_type == RTM_DELLINK)
+            {
+                ifinfomsg const * ifi(reinterpret_cast<ifinfomsg const *>(reinterpret_cast<char const *>(nlh) + NLMSG_HDRLEN));
+                f_links.erase(ifi->ifi_index);
+                continue;
+            }
+            if(nlh->nlmsg_type != RTM_NEWLINK)
+            {
+                continue;
+            }
+
+            ifinfomsg const * ifi(reinterpret_cast<ifinfomsg const *>(reinterpret_cast<char const *>(nlh) + NLMSG_HDRLEN));
+
+            // search for the name of the interface
+            //
+            std::string name;
+            int attr_len(static_cast<int>(nlh->nlmsg_len - NLMSG_LENGTH(sizeof(ifinfomsg))));
+            for(rtattr const * attr(reinterpret_cast<rtattr const *>(reinterpret_cast<char const *>(ifi) + NLMSG_ALIGN(sizeof(ifinfomsg))));
+                RTA_OK(attr, attr_len);
+                attr = RTA_NEXT(attr, attr_len))
+            {
+                if(attr->rta_type == IFLA_IFNAME)
+                {
+                    name = reinterpret_cast<char const *>(attr) + RTA_LENGTH(0);
+                    break;
+                }
+            }
+
+            // the link is considered up when it is administratively up
+            // and has a carrier
+            //
+            bool const up((ifi->ifi_flags & IFF_UP) != 0
+                       && (ifi->ifi_flags & IFF_LOWER_UP) != 0);
+
+            auto it(f_links.find(ifi->ifi_index));
+            if(it == f_links.end())
+            {
+                link_t l;
+                l.f_name = name;
+                l.f_up = up;
+                f_links[ifi->ifi_index] = l;
+                continue;
+            }
+            if(!name.empty())
+            {
+                it->second.f_name = name;
+            }
+            if(it->second.f_up == up)
+            {
+                continue;
+            }
+            it->second.f_up = up;
+
+            SNAP_LOG_INFO
+                << "network interface \""
+                << it->second.f_name
+                << "\" is now "
+                << (up ? "up" : "down")
+                << '.'
+                << SNAP_LOG_SEND;
+
+            if(f_events.size() < MAXIMUM_EVENTS)
+            {
+                link_event_t event;
+                event.f_name = it->second.f_name;
+                event.f_up = up;
+                event.f_date = time(nullptr);
+                f_events.push_back(event);
+            }
+
+            if(!up)
+            {
+                force_tick = true;
+            }
+        }
+    }
+
+    if(force_tick)
+    {
+        f_server->force_tick();
+    }
+}
+
+
+/** \brief Create the netlink socket and subscribe to the link events.
+ *
+ * \return true if the subscription succeeded.
+ */
+bool link_monitor::subscribe()
+{
+    int const s(socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE));
+    if(s < 0)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not create the link monitor socket (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << ")."
+            << SNAP_LOG_SEND;
+        return false;
+    }
+    f_socket.reset(s);
+
+    sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK;
+    addr.nl_pid = 0;    // let the kernel assign our port ID
+    if(bind(s, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not bind the link monitor socket (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << ")."
+            << SNAP_LOG_SEND;
+        return false;
+    }
+
+    return true;
+}
+
+
+/** \brief Request the state of all the links.
+ *
+ * The answer is received in process_read() like any other event.
+ *
+ * \return true if the request was sent.
+ */
+bool link_monitor::request_dump()
+{
+    struct
+    {
+        nlmsghdr                f_header;
+        ifinfomsg               f_info;
+    } request = {};
+    request.f_header.nlmsg_len = NLMSG_LENGTH(sizeof(ifinfomsg));
+    request.f_header.nlmsg_type = RTM_GETLINK;
+    request.f_header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.f_header.nlmsg_seq = 1;
+    request.f_info.ifi_family = AF_UNSPEC;
+
+    if(send(f_socket.get(), &request, request.f_header.nlmsg_len, 0) < 0)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not request the list of links (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << ")."
+            << SNAP_LOG_SEND;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
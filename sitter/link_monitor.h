@@ -0,0 +1,114 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// eventdispatcher
+//
+#include    <eventdispatcher/connection.h>
+
+
+// cppthread
+//
+#include    <cppthread/mutex.h>
+
+
+// snapdev
+//
+#include    <snapdev/raii_generic_deleter.h>
+
+
+// C++
+//
+#include    <map>
+#include    <string>
+#include    <vector>
+
+
+
+/** \file
+ * \brief This file declares a listener of the network link events.
+ *
+ * The kernel sends an RTM_NEWLINK message on the RTMGRP_LINK netlink
+ * group each time the state of a network interface changes. Listening
+ * to those messages lets us record link flaps as they happen instead
+ * of sampling the state once per tick.
+ *
+ * This is considered an internal class.
+ */
+
+
+
+
+namespace sitter
+{
+
+
+
+class server;
+
+class link_monitor
+    : public ed::connection
+{
+public:
+    typedef std::shared_ptr<link_monitor>       pointer_t;
+
+    struct link_event_t
+    {
+        std::string             f_name = std::string();
+        bool                    f_up = false;
+        time_t                  f_date = 0;
+    };
+    typedef std::vector<link_event_t>           link_event_vector_t;
+
+    static constexpr std::size_t const          MAXIMUM_EVENTS = 1000;
+
+                                link_monitor(server * s);
+                                link_monitor(link_monitor const & rhs) = delete;
+    virtual                     ~link_monitor() override;
+    link_monitor &              operator = (link_monitor const & rhs) = delete;
+
+    bool                        is_listening() const;
+    link_event_vector_t         get_events();
+
+    // ed::connection implementation
+    virtual bool                is_reader() const override;
+    virtual int                 get_socket() const override;
+    virtual void                process_read() override;
+
+private:
+    struct link_t
+    {
+        std::string             f_name = std::string();
+        bool                    f_up = false;
+    };
+    typedef std::map<int, link_t>               link_map_t;
+
+    bool                        subscribe();
+    bool                        request_dump();
+
+    server *                    f_server = nullptr;
+    snapdev::raii_fd_t          f_socket = snapdev::raii_fd_t();
+    cppthread::mutex            f_mutex = cppthread::mutex();
+    link_map_t                  f_links = link_map_t();
+    link_event_vector_t         f_events = link_event_vector_t();
+};
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -80,6 +80,10 @@ messenger::messenger(server * s, advgetopt::getopt & opts)
     set_name("sitter_messenger");
 
     get_dispatcher()->add_matches({
+        ed::define_match(
+              ed::Expression(g_name_sitter_cmd_absolutely)
+            , ed::Callback(std::bind(&server::msg_absolutely, f_server, std::placeholders::_1))
+        ),
         ed::define_match(
               ed::Expression(g_name_sitter_cmd_rusage)
             , ed::Callback(std::bind(&server::msg_rusage, f_server, std::placeholders::_1))
@@ -0,0 +1,78 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "sitter/monotonic_clock.h"
+
+
+// C++
+//
+#include    <chrono>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the monotonic clock helpers.
+ *
+ * Both functions read the same clock (std::chrono::steady_clock, which
+ * is CLOCK_MONOTONIC under Linux) so values obtained from one can be
+ * compared to values obtained from the other once converted.
+ */
+
+
+
+namespace sitter
+{
+
+
+
+/** \brief Get the current monotonic time in microseconds.
+ *
+ * \return The number of microseconds since an unspecified point in time.
+ */
+std::int64_t monotonic_usec()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/** \brief Get the current monotonic time in seconds.
+ *
+ * \return The number of seconds, with a fractional part, since an
+ * unspecified point in time.
+ */
+double monotonic_seconds()
+{
+    return std::chrono::duration<double>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
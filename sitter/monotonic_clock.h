@@ -0,0 +1,48 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <cstdint>
+
+
+
+/** \file
+ * \brief This file declares the monotonic clock helpers.
+ *
+ * The sitter and its plugins compute rates and time windows between
+ * samples. These functions use the monotonic clock so a change of the
+ * wall clock (NTP, manual adjustment) does not distort the results.
+ */
+
+
+
+
+namespace sitter
+{
+
+
+
+std::int64_t                monotonic_usec();
+double                      monotonic_seconds();
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,339 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "sitter/pidfd_watcher.h"
+
+#include    "sitter/sitter.h"
+
+
+// cppthread
+//
+#include    <cppthread/guard.h>
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// C
+//
+#include    <string.h>
+#include    <sys/epoll.h>
+#include    <sys/syscall.h>
+#include    <unistd.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the pidfd watcher.
+ *
+ * The network and firewall plugins verify that a mandatory process
+ * (communicatord and ipwall) is running. Without a watcher, they have
+ * to load the list of processes on each tick.
+ *
+ * The watcher opens a pidfd (see pidfd_open(2)) for each process once
+ * found. All the pidfd are added to one epoll file descriptor which is
+ * what the communicator polls. When a process exits, its pidfd becomes
+ * readable, the watch is removed, the exit is logged, and a tick is
+ * forced so the error gets reported immediately.
+ *
+ * \note
+ * The pidfd_open() system call was added in Linux 5.3. On older kernels
+ * the watcher is not valid and the plugins search for the processes on
+ * each tick as before.
+ */
+
+
+
+namespace sitter
+{
+
+
+
+/** \brief Initialize the pidfd watcher.
+ *
+ * This function creates the epoll file descriptor used to listen to
+ * all the pidfd at once.
+ *
+ * It also opens a pidfd for our own process to verify that the kernel
+ * supports pidfd_open(). If not (i.e. ENOSYS), the watcher is marked as
+ * not valid so the server does not use it and the plugins do not try
+ * (and log a failure) on each tick.
+ *
+ * The watcher must be created and added to the communicator by the main
+ * thread. The watch() function can then be called from the worker thread.
+ *
+ * \param[in] s  A pointer to the server object.
+ */
+pidfd_watcher::pidfd_watcher(server * s)
+    : f_server(s)
+    , f_epoll(epoll_create1(EPOLL_CLOEXEC))
+{
+    set_name("pidfd_watcher");
+
+    if(f_epoll.get() == -1)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not create the epoll file descriptor for the pidfd watcher (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << ")."
+            << SNAP_LOG_SEND;
+        return;
+    }
+
+    int const pidfd(static_cast<int>(syscall(SYS_pidfd_open, getpid(), 0)));
+    if(pidfd < 0)
+    {
+        int const e(errno);
+        SNAP_LOG_WARNING
+            << "pidfd_open() is not available (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << "); processes will be searched on each tick."
+            << SNAP_LOG_SEND;
+        return;
+    }
+    close(pidfd);
+    f_supported = true;
+}
+
+
+pidfd_watcher::~pidfd_watcher()
+{
+    cppthread::guard lock(f_mutex);
+    while(!f_watches.empty())
+    {
+        unwatch(f_watches.begin());
+    }
+}
+
+
+/** \brief Check whether the watcher can be used.
+ *
+ * \return true if the epoll file descriptor was created and the kernel
+ * supports pidfd_open().
+ */
+bool pidfd_watcher::is_valid() const
+{
+    return f_epoll.get() != -1
+        && f_supported;
+}
+
+
+/** \brief Start watching a process.
+ *
+ * This function opens a pidfd for \p pid and adds it to the epoll file
+ * descriptor. From then on, get_pid() returns \p pid for \p name until
+ * the process exits.
+ *
+ * If a process with the same name is already being watched, the old
+ * watch is replaced.
+ *
+ * \param[in] name  The name of the process.
+ * \param[in] pid  The process identifier.
+ *
+ * \return true if the process is now being watched.
+ */
+bool pidfd_watcher::watch(std::string const & name, pid_t pid)
+{
+    if(!is_valid())
+    {
+        return false;
+    }
+
+    int const pidfd(static_cast<int>(syscall(SYS_pidfd_open, pid, 0)));
+    if(pidfd < 0)
+    {
+        // ESRCH means the process is already gone; ENOSYS was
+        // already checked in the constructor
+        //
+        int const e(errno);
+        if(e != ESRCH)
+        {
+            SNAP_LOG_WARNING
+                << "could not open a pidfd for process \""
+                << name
+                << "\" ("
+                << pid
+                << ") (errno: "
+                << e
+                << ", "
+                << strerror(e)
+                << ")."
+                << SNAP_LOG_SEND;
+        }
+        return false;
+    }
+
+    cppthread::guard lock(f_mutex);
+
+    auto it(f_watches.find(name));
+    if(it != f_watches.end())
+    {
+        unwatch(it);
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = pidfd;
+    if(epoll_ctl(f_epoll.get(), EPOLL_CTL_ADD, pidfd, &event) != 0)
+    {
+        close(pidfd);
+        return false;
+    }
+
+    watch_t & w(f_watches[name]);
+    w.f_name = name;
+    w.f_pid = pid;
+    w.f_pidfd = pidfd;
+
+    return true;
+}
+
+
+/** \brief Get the PID of a watched process.
+ *
+ * If the named process is being watched, then this function returns
+ * its PID. Otherwise it returns 0 meaning that the caller has to search
+ * for that process and call watch() once found.
+ *
+ * \param[in] name  The name of the process.
+ *
+ * \return The PID of the process or 0.
+ */
+pid_t pidfd_watcher::get_pid(std::string const & name)
+{
+    cppthread::guard lock(f_mutex);
+
+    auto it(f_watches.find(name));
+    if(it == f_watches.end())
+    {
+        return 0;
+    }
+
+    return it->second.f_pid;
+}
+
+
+/** \brief The pidfd watcher is a reader.
+ *
+ * The epoll file descriptor becomes readable when one of the pidfd is
+ * readable, i.e. one of the watched processes exited.
+ *
+ * \return Always true.
+ */
+bool pidfd_watcher::is_reader() const
+{
+    return true;
+}
+
+
+/** \brief Return the epoll file descriptor.
+ *
+ * \return The epoll file descriptor or -1.
+ */
+int pidfd_watcher::get_socket() const
+{
+    return f_epoll.get();
+}
+
+
+/** \brief Handle processes that exited.
+ *
+ * This function retrieves the pidfd which are readable, removes the
+ * corresponding watches, logs an error, and forces a tick so the
+ * plugins search for the processes again.
+ */
+void pidfd_watcher::process_read()
+{
+    epoll_event events[16];
+    int const count(epoll_wait(f_epoll.get(), events, 16, 0));
+    if(count <= 0)
+    {
+        return;
+    }
+
+    bool force_tick(false);
+    {
+        cppthread::guard lock(f_mutex);
+
+        for(int idx(0); idx < count; ++idx)
+        {
+            for(auto it(f_watches.begin()); it != f_watches.end(); ++it)
+            {
+                if(it->second.f_pidfd == events[idx].data.fd)
+                {
+                    SNAP_LOG_ERROR
+                        << "process \""
+                        << it->second.f_name
+                        << "\" ("
+                        << it->second.f_pid
+                        << ") exited."
+                        << SNAP_LOG_SEND;
+
+                    unwatch(it);
+                    force_tick = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    if(force_tick)
+    {
+        f_server->force_tick();
+    }
+}
+
+
+/** \brief Stop watching a process.
+ *
+ * This function removes the pidfd from the epoll file descriptor,
+ * closes it, and removes the watch from the map.
+ *
+ * \note
+ * This function must be called with the mutex locked.
+ *
+ * \param[in] it  The watch to remove.
+ */
+void pidfd_watcher::unwatch(watch_map_t::iterator it)
+{
+    epoll_ctl(f_epoll.get(), EPOLL_CTL_DEL, it->second.f_pidfd, nullptr);
+    close(it->second.f_pidfd);
+    f_watches.erase(it);
+}
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
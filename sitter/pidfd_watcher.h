@@ -0,0 +1,104 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// eventdispatcher
+//
+#include    <eventdispatcher/connection.h>
+
+
+// cppthread
+//
+#include    <cppthread/mutex.h>
+
+
+// snapdev
+//
+#include    <snapdev/raii_generic_deleter.h>
+
+
+// C++
+//
+#include    <map>
+#include    <string>
+
+
+
+/** \file
+ * \brief This file declares a watcher of process file descriptors.
+ *
+ * Once a mandatory process was found, a pidfd is opened for it. The
+ * pidfd becomes readable when the process exits so we do not have to
+ * search for that process again until then.
+ *
+ * This is considered an internal class.
+ */
+
+
+
+
+namespace sitter
+{
+
+
+
+class server;
+
+class pidfd_watcher
+    : public ed::connection
+{
+public:
+    typedef std::shared_ptr<pidfd_watcher>      pointer_t;
+
+
+                                pidfd_watcher(server * s);
+                                pidfd_watcher(pidfd_watcher const & rhs) = delete;
+    virtual                     ~pidfd_watcher() override;
+    pidfd_watcher &             operator = (pidfd_watcher const & rhs) = delete;
+
+    bool                        is_valid() const;
+    bool                        watch(std::string const & name, pid_t pid);
+    pid_t                       get_pid(std::string const & name);
+
+    // ed::connection implementation
+    virtual bool                is_reader() const override;
+    virtual int                 get_socket() const override;
+    virtual void                process_read() override;
+
+private:
+    struct watch_t
+    {
+        std::string             f_name = std::string();
+        pid_t                   f_pid = 0;
+        int                     f_pidfd = -1;
+    };
+    typedef std::map<std::string, watch_t>      watch_map_t;
+
+    void                        unwatch(watch_map_t::iterator it);
+
+    server *                    f_server = nullptr;
+    snapdev::raii_fd_t          f_epoll = snapdev::raii_fd_t();
+    bool                        f_supported = false;
+    cppthread::mutex            f_mutex = cppthread::mutex();
+    watch_map_t                 f_watches = watch_map_t();
+};
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
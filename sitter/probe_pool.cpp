@@ -0,0 +1,375 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "sitter/probe_pool.h"
+
+#include    "sitter/monotonic_clock.h"
+
+
+// cppthread
+//
+#include    <cppthread/guard.h>
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// snapdev
+//
+#include    <snapdev/not_used.h>
+
+
+// C++
+//
+#include    <algorithm>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements a pool of helpers running blocking probes.
+ *
+ * On Feb 10, 2018, I was testing the sitter daemon and it was getting
+ * stuck on statvfs(). I have keybase installed on my system and
+ * it failed restarting properly. The `df` command would also lock up.
+ *
+ * The pool starts a fixed number of helper threads once. Each probe is
+ * identified by a key (i.e. the mount point) and gets its own timeout
+ * which starts when a helper picks it up. When a probe times out, it is
+ * abandoned: the helper keeps waiting on the blocking call and the key
+ * is marked unresponsive until that call returns. This means a key has
+ * at most one outstanding probe and a stuck device costs at most one
+ * helper.
+ *
+ * When all the helpers are stuck, the remaining probes are not started
+ * and are reported as unresponsive instead of waiting forever.
+ *
+ * The helpers are joined when the pool is destroyed.
+ */
+
+
+
+namespace sitter
+{
+
+
+
+/** \brief Initialize a probe helper.
+ *
+ * \param[in] pool  The pool this helper works for.
+ * \param[in] name  The name of the helper thread.
+ */
+probe_helper::probe_helper(probe_pool * pool, std::string const & name)
+    : runner(name)
+    , f_pool(pool)
+{
+}
+
+
+/** \brief Run the probes.
+ *
+ * The helper waits for the next probe, runs it, and marks it as done
+ * until the pool gets destroyed.
+ */
+void probe_helper::run()
+{
+    while(continue_running())
+    {
+        probe_pool::job_t::pointer_t job(f_pool->next_job());
+        if(job == nullptr)
+        {
+            return;
+        }
+
+        try
+        {
+            job->f_callback();
+        }
+        catch(std::exception const & e)
+        {
+            SNAP_LOG_ERROR
+                << "probe of \""
+                << job->f_key
+                << "\" failed with an exception: "
+                << e.what()
+                << SNAP_LOG_SEND;
+        }
+
+        f_pool->job_done(job);
+    }
+}
+
+
+
+
+
+/** \brief Start the helpers of the pool.
+ *
+ * \param[in] name  The name of the pool, used to name the helper threads
+ * and in the logs.
+ * \param[in] helpers  The number of helpers running probes concurrently.
+ */
+probe_pool::probe_pool(std::string const & name, std::size_t helpers)
+    : f_name(name)
+{
+    for(std::size_t idx(0); idx < helpers; ++idx)
+    {
+        helper_t h;
+        h.f_runner = std::make_shared<probe_helper>(this, f_name + '-' + std::to_string(idx));
+        h.f_thread = std::make_shared<cppthread::thread>(f_name + '-' + std::to_string(idx), h.f_runner);
+        if(!h.f_thread->start())
+        {
+            SNAP_LOG_ERROR
+                << "could not start helper #"
+                << idx
+                << " of the \""
+                << f_name
+                << "\" probe pool."
+                << SNAP_LOG_SEND;
+            continue;
+        }
+        f_helpers.push_back(h);
+    }
+}
+
+
+/** \brief Stop and join the helpers.
+ *
+ * The idle helpers exit immediately. A helper stuck in a blocking call
+ * is joined once that call returns.
+ */
+probe_pool::~probe_pool()
+{
+    {
+        cppthread::guard lock(f_mutex);
+        f_stopping = true;
+        f_queue.clear();
+        f_mutex.broadcast();
+    }
+
+    for(auto & h : f_helpers)
+    {
+        h.f_thread->stop([this](cppthread::thread * t)
+            {
+                snapdev::NOT_USED(t);
+                cppthread::guard lock(f_mutex);
+                f_mutex.broadcast();
+            });
+    }
+}
+
+
+/** \brief Run a set of probes.
+ *
+ * This function queues the \p probes and waits for them. The returned
+ * statuses are in the same order as the probes:
+ *
+ * \li PROBE_STATUS_SUCCESS -- the callback returned; it saved its own
+ * results
+ * \li PROBE_STATUS_TIMED_OUT -- the callback did not return within
+ * \p timeout microseconds; it is abandoned
+ * \li PROBE_STATUS_UNRESPONSIVE -- a previous probe with the same key is
+ * still running or all the helpers are stuck so the probe was not started
+ *
+ * The data the callback writes to must be owned by the callback (i.e.
+ * captured in a shared pointer) since an abandoned callback may return
+ * long after this function.
+ *
+ * \param[in] probes  The probes to run.
+ * \param[in] timeout  The maximum amount of time each probe can take in
+ * microseconds.
+ *
+ * \return The status of each probe.
+ */
+probe_pool::status_vector_t probe_pool::run(
+      probe_vector_t const & probes
+    , std::int64_t timeout)
+{
+    status_vector_t result(probes.size(), probe_status_t::PROBE_STATUS_UNRESPONSIVE);
+
+    cppthread::guard lock(f_mutex);
+
+    std::vector<std::pair<std::size_t, job_t::pointer_t>> running;
+    for(std::size_t idx(0); idx < probes.size(); ++idx)
+    {
+        if(f_pending.find(probes[idx].f_key) != f_pending.end())
+        {
+            continue;
+        }
+
+        job_t::pointer_t job(std::make_shared<job_t>());
+        job->f_key = probes[idx].f_key;
+        job->f_callback = probes[idx].f_callback;
+        job->f_timeout = timeout;
+        f_pending[job->f_key] = job;
+        f_queue.push_back(job);
+        running.emplace_back(idx, job);
+    }
+    f_mutex.broadcast();
+
+    while(!running.empty())
+    {
+        std::int64_t const now(monotonic_usec());
+        std::int64_t earliest_deadline(now + timeout);
+        for(auto it(running.begin()); it != running.end(); )
+        {
+            job_t::pointer_t job(it->second);
+            if(job->f_done)
+            {
+                result[it->first] = probe_status_t::PROBE_STATUS_SUCCESS;
+                it = running.erase(it);
+            }
+            else if(job->f_deadline != 0
+                 && now >= job->f_deadline)
+            {
+                SNAP_LOG_WARNING
+                    << f_name
+                    << " probe of \""
+                    << job->f_key
+                    << "\" timed out; it is marked unresponsive until it answers."
+                    << SNAP_LOG_SEND;
+
+                result[it->first] = probe_status_t::PROBE_STATUS_TIMED_OUT;
+                job->f_abandoned = true;
+                ++f_abandoned;
+                it = running.erase(it);
+            }
+            else
+            {
+                if(job->f_deadline != 0)
+                {
+                    earliest_deadline = std::min(earliest_deadline, job->f_deadline);
+                }
+                ++it;
+            }
+        }
+
+        if(!running.empty()
+        && f_abandoned >= f_helpers.size())
+        {
+            // all the helpers are stuck, the probes still in the queue
+            // would never start
+            //
+            SNAP_LOG_WARNING
+                << "all the "
+                << f_name
+                << " helpers are stuck; "
+                << running.size()
+                << " probe(s) not started."
+                << SNAP_LOG_SEND;
+
+            for(auto const & r : running)
+            {
+                f_pending.erase(r.second->f_key);
+            }
+            f_queue.clear();
+            break;
+        }
+
+        if(!running.empty())
+        {
+            f_mutex.timed_wait(static_cast<std::uint64_t>(std::max(earliest_deadline - now, static_cast<std::int64_t>(1))));
+        }
+    }
+
+    return result;
+}
+
+
+/** \brief Wait for the next probe to run.
+ *
+ * This function is called by the helpers.
+ *
+ * \return The next probe or nullptr if the pool is being destroyed.
+ */
+probe_pool::job_t::pointer_t probe_pool::next_job()
+{
+    cppthread::guard lock(f_mutex);
+
+    while(f_queue.empty())
+    {
+        if(f_stopping)
+        {
+            return job_t::pointer_t();
+        }
+        f_mutex.wait();
+    }
+    if(f_stopping)
+    {
+        return job_t::pointer_t();
+    }
+
+    job_t::pointer_t job(f_queue.front());
+    f_queue.pop_front();
+    job->f_deadline = monotonic_usec() + job->f_timeout;
+
+    return job;
+}
+
+
+/** \brief Mark a probe as done.
+ *
+ * This function is called by the helpers once the callback returned.
+ * If the probe was abandoned, the fact that the key answers again is
+ * logged.
+ *
+ * \param[in] job  The probe which just returned.
+ */
+void probe_pool::job_done(job_t::pointer_t job)
+{
+    cppthread::guard lock(f_mutex);
+
+    job->f_done = true;
+
+    auto it(f_pending.find(job->f_key));
+    if(it != f_pending.end()
+    && it->second == job)
+    {
+        f_pending.erase(it);
+    }
+
+    if(job->f_abandoned)
+    {
+        --f_abandoned;
+
+        SNAP_LOG_INFO
+            << f_name
+            << " probe of \""
+            << job->f_key
+            << "\" answered again."
+            << SNAP_LOG_SEND;
+    }
+
+    f_mutex.broadcast();
+}
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,147 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// cppthread
+//
+#include    <cppthread/mutex.h>
+#include    <cppthread/runner.h>
+#include    <cppthread/thread.h>
+
+
+// C++
+//
+#include    <deque>
+#include    <functional>
+#include    <map>
+#include    <memory>
+#include    <string>
+#include    <vector>
+
+
+
+/** \file
+ * \brief This file declares a pool of helpers running blocking probes.
+ *
+ * Some system calls such as statvfs(), write(), or fsync() cannot be
+ * canceled and may block forever on a dead device. The plugins which
+ * need such calls run them in this pool so each probe gets a timeout.
+ */
+
+
+
+
+namespace sitter
+{
+
+
+
+enum class probe_status_t
+{
+    PROBE_STATUS_SUCCESS,
+    PROBE_STATUS_FAILED,
+    PROBE_STATUS_TIMED_OUT,
+    PROBE_STATUS_UNRESPONSIVE,
+};
+
+
+class probe_pool;
+
+
+class probe_helper
+    : public cppthread::runner
+{
+public:
+    typedef std::shared_ptr<probe_helper>   pointer_t;
+
+                            probe_helper(probe_pool * pool, std::string const & name);
+                            probe_helper(probe_helper const &) = delete;
+    probe_helper &          operator = (probe_helper const &) = delete;
+
+    // cppthread::runner implementation
+    //
+    virtual void            run() override;
+
+private:
+    probe_pool *            f_pool = nullptr;
+};
+
+
+class probe_pool
+{
+public:
+    typedef std::function<void()>           callback_t;
+
+    struct probe_t
+    {
+        std::string             f_key = std::string();
+        callback_t              f_callback = callback_t();
+    };
+    typedef std::vector<probe_t>            probe_vector_t;
+    typedef std::vector<probe_status_t>     status_vector_t;
+
+                            probe_pool(std::string const & name, std::size_t helpers);
+                            probe_pool(probe_pool const &) = delete;
+                            ~probe_pool();
+    probe_pool &            operator = (probe_pool const &) = delete;
+
+    status_vector_t         run(
+                                  probe_vector_t const & probes
+                                , std::int64_t timeout);
+
+private:
+    friend class probe_helper;
+
+    struct job_t
+    {
+        typedef std::shared_ptr<job_t>      pointer_t;
+
+        std::string             f_key = std::string();
+        callback_t              f_callback = callback_t();
+        std::int64_t            f_timeout = 0;
+        std::int64_t            f_deadline = 0;
+        bool                    f_done = false;
+        bool                    f_abandoned = false;
+    };
+    typedef std::map<std::string, job_t::pointer_t>     job_map_t;
+    typedef std::deque<job_t::pointer_t>                job_queue_t;
+
+    struct helper_t
+    {
+        probe_helper::pointer_t f_runner = probe_helper::pointer_t();
+        cppthread::thread::pointer_t
+                                f_thread = cppthread::thread::pointer_t();
+    };
+    typedef std::vector<helper_t>                       helper_vector_t;
+
+    job_t::pointer_t        next_job();
+    void                    job_done(job_t::pointer_t job);
+
+    std::string             f_name = std::string();
+    cppthread::mutex        f_mutex = cppthread::mutex();
+    helper_vector_t         f_helpers = helper_vector_t();
+    job_map_t               f_pending = job_map_t();
+    job_queue_t             f_queue = job_queue_t();
+    std::size_t             f_abandoned = 0;
+    bool                    f_stopping = false;
+};
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,532 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "sitter/process_connector.h"
+
+#include    "sitter/process_snapshot.h"
+#include    "sitter/sitter.h"
+
+
+// cppthread
+//
+#include    <cppthread/guard.h>
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// C
+//
+#include    <linux/cn_proc.h>
+#include    <linux/connector.h>
+#include    <linux/netlink.h>
+#include    <string.h>
+#include    <sys/socket.h>
+#include    <sys/wait.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the process connector listener.
+ *
+ * The processes plugin used to scan the entire /proc directory once per
+ * tick to find the processes it has to watch. That means a mandatory
+ * process which dies just after a tick would go unnoticed for up to a
+ * minute.
+ *
+ * The kernel offers the process connector (`NETLINK_CONNECTOR` with the
+ * `CN_IDX_PROC` group) which sends an event whenever a process forks,
+ * executes a new program, or exits. This listener maintains an index of
+ * all the processes from those events so the tick can read the index
+ * instead of rescanning /proc. It also forces a tick as soon as one of
+ * the watched (mandatory) processes exits.
+ *
+ * \note
+ * Listening to the process connector requires the CAP_NET_ADMIN
+ * capability. Without it, the listener is not created and the plugins
+ * fall back to scanning /proc on each tick.
+ */
+
+
+
+namespace sitter
+{
+
+
+
+/** \class process_connector
+ * \brief Listen to the kernel process events.
+ *
+ * This class is a connection added to the ed::communicator. The socket
+ * is a netlink socket subscribed to the process connector multicast
+ * group.
+ *
+ * The index is read from the worker thread and updated from the main
+ * thread so all accesses are protected by a mutex.
+ */
+
+
+
+/** \brief Initialize the process connector.
+ *
+ * The constructor creates the netlink socket and subscribes to the
+ * process events. If any of these steps fails, the error is logged and
+ * the is_listening() function returns false. In that case, the connection
+ * should not be added to the communicator.
+ *
+ * The index of processes is initialized on the first call to the
+ * get_processes() function.
+ *
+ * \param[in] s  A pointer to the server object.
+ */
+process_connector::process_connector(server * s)
+    : f_server(s)
+{
+    set_name("process_connector");
+
+    if(!subscribe())
+    {
+        f_socket.reset();
+    }
+}
+
+
+process_connector::~process_connector()
+{
+}
+
+
+/** \brief Check whether the connector is listening to process events.
+ *
+ * If the socket could not be created or the subscription failed (i.e.
+ * the sitter is not running with the CAP_NET_ADMIN capability) then
+ * this function returns false.
+ *
+ * \return true if the process events are being received.
+ */
+bool process_connector::is_listening() const
+{
+    return f_socket.get() != -1;
+}
+
+
+/** \brief Get a copy of the current index of processes.
+ *
+ * This function returns the list of processes currently running on
+ * this computer as known by the process connector.
+ *
+ * The command line of a process is loaded lazily. The fork event copies
+ * the command line of the parent and the exec event marks the entry as
+ * stale. Only processes that are still running when this function gets
+ * called see their command line reloaded. This way short lived commands
+ * (i.e. a shell script running many small tools) cost us nothing.
+ *
+ * If events were lost (the socket buffer was full), then the index is
+ * rebuilt from scratch by scanning /proc.
+ *
+ * \return A vector with one entry per process.
+ */
+process_connector::process_vector_t process_connector::get_processes()
+{
+    cppthread::guard lock(f_mutex);
+
+    if(f_rescan)
+    {
+        scan_processes();
+    }
+
+    process_vector_t result;
+    result.reserve(f_processes.size());
+    for(auto & p : f_processes)
+    {
+        if(p.second.f_stale)
+        {
+            load_process(p.second);
+        }
+        if(!p.second.f_name.empty())
+        {
+            result.push_back(p.second);
+        }
+    }
+
+    return result;
+}
+
+
+/** \brief Define the list of processes to watch.
+ *
+ * The processes plugin calls this function with the list of mandatory
+ * processes it found running. When one of these processes exits, the
+ * connector records the event and forces a tick so the error gets
+ * reported right away instead of at the next tick.
+ *
+ * \param[in] watched  A map of PIDs to process names.
+ */
+void process_connector::set_watched(std::map<pid_t, std::string> const & watched)
+{
+    cppthread::guard lock(f_mutex);
+    f_watched = watched;
+}
+
+
+/** \brief Retrieve the list of watched processes that exited.
+ *
+ * This function returns the list of watched processes which exited since
+ * the last call. The internal list is cleared.
+ *
+ * \return The list of exit events.
+ */
+process_connector::exit_vector_t process_connector::get_exits()
+{
+    cppthread::guard lock(f_mutex);
+
+    exit_vector_t result;
+    result.swap(f_exits);
+    return result;
+}
+
+
+/** \brief The process connector is a reader.
+ *
+ * The netlink socket is only used to receive events so this function
+ * returns true.
+ *
+ * \return Always true.
+ */
+bool process_connector::is_reader() const
+{
+    return true;
+}
+
+
+/** \brief Return the netlink socket.
+ *
+ * \return The netlink socket or -1 if it is not open.
+ */
+int process_connector::get_socket() const
+{
+    return f_socket.get();
+}
+
+
+/** \brief Read the process events.
+ *
+ * This function reads all the events currently available on the socket
+ * and updates the index accordingly.
+ */
+void process_connector::process_read()
+{
+    alignas(nlmsghdr) char buf[8192];
+
+    for(;;)
+    {
+        ssize_t const r(recv(f_socket.get(), buf, sizeof(buf), 0));
+        if(r < 0)
+        {
+            int const e(errno);
+            if(e == EINTR)
+            {
+                continue;
+            }
+            if(e == ENOBUFS)
+            {
+                // we lost some events, rebuild the index from scratch
+                // next time it gets used
+                //
+                SNAP_LOG_WARNING
+                    << "process connector lost events; the index of processes will be rebuilt."
+                    << SNAP_LOG_SEND;
+
+                cppthread::guard lock(f_mutex);
+                f_rescan = true;
+                continue;
+            }
+            if(e != EAGAIN)
+            {
+                SNAP_LOG_ERROR
+                    << "process connector failed reading events (errno: "
+                    << e
+                    << ", "
+                    << strerror(e)
+                    << ")."
+                    << SNAP_LOG_SEND;
+            }
+            return;
+        }
+        if(r == 0)
+        {
+            return;
+        }
+
+        cppthread::guard lock(f_mutex);
+
+        int len(static_cast<int>(r));
+        for(nlmsghdr const * nlh(reinterpret_cast<nlmsghdr const *>(buf));
+            NLMSG_OK(nlh, len);
+            nlh = NLMSG_NEXT(nlh, len))
+        {
+            if(nlh->nlmsg_type == NLMSG_NOOP
+            || nlh->nlmsg_type == NLMSG_ERROR)
+            {
+                continue;
+            }
+
+            cn_msg const * msg(reinterpret_cast<cn_msg const *>(reinterpret_cast<char const *>(nlh) + NLMSG_HDRLEN));
+            if(msg->id.idx != CN_IDX_PROC
+            || msg->id.val != CN_VAL_PROC
+            || msg->len < sizeof(proc_event))
+            {
+                continue;
+            }
+            proc_event const * ev(reinterpret_cast<proc_event const *>(msg->data));
+
+            // while a rescan is pending, the events are useless
+            //
+            if(f_rescan)
+            {
+                continue;
+            }
+
+            switch(ev->what)
+            {
+            case proc_event::PROC_EVENT_FORK:
+                // we are only interested in processes, not threads
+                //
+                if(ev->event_data.fork.child_pid == ev->event_data.fork.child_tgid)
+                {
+                    // the child runs the same program as its parent until
+                    // it calls exec()
+                    //
+                    process_t child;
+                    auto parent(f_processes.find(ev->event_data.fork.parent_tgid));
+                    if(parent != f_processes.end())
+                    {
+                        child = parent->second;
+                    }
+                    child.f_pid = ev->event_data.fork.child_pid;
+                    f_processes[child.f_pid] = child;
+                }
+                break;
+
+            case proc_event::PROC_EVENT_EXEC:
+                {
+                    process_t & p(f_processes[ev->event_data.exec.process_tgid]);
+                    p.f_pid = ev->event_data.exec.process_tgid;
+                    p.f_stale = true;
+                }
+                break;
+
+            case proc_event::PROC_EVENT_EXIT:
+                if(ev->event_data.exit.process_pid == ev->event_data.exit.process_tgid)
+                {
+                    process_exited(
+                          ev->event_data.exit.process_pid
+                        , static_cast<int>(ev->event_data.exit.exit_code));
+                }
+                break;
+
+            default:
+                // ignore other events (UID/GID changes, ptrace, etc.)
+                break;
+
+            }
+        }
+    }
+}
+
+
+/** \brief Create the netlink socket and subscribe to the process events.
+ *
+ * This function creates the socket, binds it to the process connector
+ * multicast group, and sends the "listen" request.
+ *
+ * \return true if the subscription succeeded.
+ */
+bool process_connector::subscribe()
+{
+    int const s(socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR));
+    if(s < 0)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not create the process connector socket (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << ")."
+            << SNAP_LOG_SEND;
+        return false;
+    }
+    f_socket.reset(s);
+
+    sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = CN_IDX_PROC;
+    addr.nl_pid = 0;    // let the kernel assign our port ID
+    if(bind(s, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not bind the process connector socket (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << "); the sitter needs the CAP_NET_ADMIN capability for this feature."
+            << SNAP_LOG_SEND;
+        return false;
+    }
+
+    alignas(nlmsghdr) char buf[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))] = {};
+    nlmsghdr * nlh(reinterpret_cast<nlmsghdr *>(buf));
+    nlh->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+    nlh->nlmsg_type = NLMSG_DONE;
+    nlh->nlmsg_pid = 0;
+
+    cn_msg * msg(reinterpret_cast<cn_msg *>(buf + NLMSG_HDRLEN));
+    msg->id.idx = CN_IDX_PROC;
+    msg->id.val = CN_VAL_PROC;
+    msg->len = sizeof(proc_cn_mcast_op);
+
+    proc_cn_mcast_op const op(PROC_CN_MCAST_LISTEN);
+    memcpy(msg->data, &op, sizeof(op));
+
+    if(send(s, nlh, nlh->nlmsg_len, 0) < 0)
+    {
+        int const e(errno);
+        SNAP_LOG_ERROR
+            << "could not subscribe to the process connector events (errno: "
+            << e
+            << ", "
+            << strerror(e)
+            << ")."
+            << SNAP_LOG_SEND;
+        return false;
+    }
+
+    return true;
+}
+
+
+/** \brief Rebuild the index of processes from /proc.
+ *
+ * This function reads the list of directories under /proc which are
+ * numbers (PIDs) and creates the index from scratch.
+ *
+ * The command lines are not loaded here. Each entry is marked stale
+ * and get_processes() loads them.
+ *
+ * \note
+ * This function must be called with the mutex locked.
+ */
+void process_connector::scan_processes()
+{
+    f_rescan = false;
+    f_processes.clear();
+
+    for(pid_t const pid : process_snapshot::get_pids())
+    {
+        process_t & p(f_processes[pid]);
+        p.f_pid = pid;
+        p.f_stale = true;
+    }
+}
+
+
+/** \brief Handle the exit of a process.
+ *
+ * The process is removed from the index. If it is one of the watched
+ * processes, the exit is recorded and a tick is forced so the error
+ * gets reported immediately.
+ *
+ * The server limits the number of forced ticks so a process crashing
+ * in a loop does not keep the worker thread busy.
+ *
+ * \note
+ * This function must be called with the mutex locked.
+ *
+ * \param[in] pid  The process that exited.
+ * \param[in] status  The exit status as returned by wait(2).
+ */
+void process_connector::process_exited(pid_t pid, int status)
+{
+    f_processes.erase(pid);
+
+    auto it(f_watched.find(pid));
+    if(it == f_watched.end())
+    {
+        return;
+    }
+
+    exit_t e;
+    e.f_pid = pid;
+    e.f_name = it->second;
+    e.f_status = status;
+    e.f_date = time(nullptr);
+    f_exits.push_back(e);
+
+    f_watched.erase(it);
+
+    SNAP_LOG_ERROR
+        << "mandatory process \""
+        << e.f_name
+        << "\" ("
+        << pid
+        << ") exited"
+        << (WIFSIGNALED(status) ? " on signal " : " with code ")
+        << (WIFSIGNALED(status) ? WTERMSIG(status) : WEXITSTATUS(status))
+        << "."
+        << SNAP_LOG_SEND;
+
+    f_server->force_tick();
+}
+
+
+/** \brief Load the name and command line of a process.
+ *
+ * The name is the basename of the first argument of the command line.
+ * See process_snapshot::load_command() for details.
+ *
+ * \param[in,out] p  The process to load.
+ */
+void process_connector::load_process(process_t & p)
+{
+    p.f_stale = false;
+
+    process_snapshot::process_t info;
+    info.f_pid = p.f_pid;
+    process_snapshot::load_command(info);
+    p.f_name = info.f_command;
+    p.f_cmdline = info.f_cmdline;
+}
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,124 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// eventdispatcher
+//
+#include    <eventdispatcher/connection.h>
+
+
+// cppthread
+//
+#include    <cppthread/mutex.h>
+
+
+// snapdev
+//
+#include    <snapdev/raii_generic_deleter.h>
+
+
+// C++
+//
+#include    <map>
+#include    <string>
+#include    <vector>
+
+
+
+/** \file
+ * \brief This file declares a listener on the kernel process connector.
+ *
+ * The process connector sends an event each time a process forks, calls
+ * exec(), or exits. This listener uses those events to maintain an index
+ * of all the running processes.
+ *
+ * This is considered an internal class.
+ */
+
+
+
+
+namespace sitter
+{
+
+
+
+class server;
+
+class process_connector
+    : public ed::connection
+{
+public:
+    typedef std::shared_ptr<process_connector>  pointer_t;
+
+    struct process_t
+    {
+        pid_t                   f_pid = 0;
+        std::string             f_name = std::string();
+        std::string             f_cmdline = std::string();
+        bool                    f_stale = true;
+    };
+    typedef std::vector<process_t>              process_vector_t;
+
+    struct exit_t
+    {
+        pid_t                   f_pid = 0;
+        std::string             f_name = std::string();
+        int                     f_status = 0;
+        time_t                  f_date = 0;
+    };
+    typedef std::vector<exit_t>                 exit_vector_t;
+
+
+                                process_connector(server * s);
+                                process_connector(process_connector const & rhs) = delete;
+    virtual                     ~process_connector() override;
+    process_connector &         operator = (process_connector const & rhs) = delete;
+
+    bool                        is_listening() const;
+    process_vector_t            get_processes();
+    void                        set_watched(std::map<pid_t, std::string> const & watched);
+    exit_vector_t               get_exits();
+
+    // ed::connection implementation
+    virtual bool                is_reader() const override;
+    virtual int                 get_socket() const override;
+    virtual void                process_read() override;
+
+private:
+    typedef std::map<pid_t, process_t>          process_map_t;
+
+    bool                        subscribe();
+    void                        scan_processes();
+    void                        process_exited(pid_t pid, int status);
+    static void                 load_process(process_t & p);
+
+    server *                    f_server = nullptr;
+    snapdev::raii_fd_t          f_socket = snapdev::raii_fd_t();
+    cppthread::mutex            f_mutex = cppthread::mutex();
+    process_map_t               f_processes = process_map_t();
+    std::map<pid_t, std::string>
+                                f_watched = std::map<pid_t, std::string>();
+    exit_vector_t               f_exits = exit_vector_t();
+    bool                        f_rescan = true;
+};
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
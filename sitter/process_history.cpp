@@ -0,0 +1,252 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "sitter/process_history.h"
+#include    "sitter/monotonic_clock.h"
+#include    "sitter/process_snapshot.h"
+
+
+// C++
+//
+#include    <cmath>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the per process history.
+ *
+ * The cppprocess library gives us cumulative values (i.e. the CPU
+ * percentage is computed over the whole lifetime of the process). To
+ * know what a process is doing now, we need to compare two samples.
+ *
+ * This class keeps the last sample of each watched process and a short
+ * history of its resident memory. The key is the PID and the start time
+ * of the process so a PID reused by a new process starts a new history.
+ *
+ * The history of the RSS is used to compute a linear regression. A
+ * slope which stays positive with a strong correlation over a long
+ * period is a good sign of a memory leak.
+ *
+ * \note
+ * This object is only used from the worker thread so it is not protected
+ * by a mutex.
+ */
+
+
+
+namespace sitter
+{
+
+
+
+
+/** \brief Sample a process and compute its rates.
+ *
+ * This function reads the current statistics of the process \p pid and
+ * compares them against the previous sample of the same process (same
+ * PID and same start time). On the first call for a given process, the
+ * f_has_rates field is false.
+ *
+ * Several plugins may output the same process within one tick. Only
+ * the first call of a tick samples the process; the following calls
+ * return that same sample so the rates always cover a full interval.
+ *
+ * \param[in] pid  The process to sample.
+ * \param[in] tick  The number of the current tick.
+ * \param[out] stats  The statistics and rates of the process.
+ *
+ * \return false if the process could not be read (i.e. it died).
+ */
+bool process_history::sample(pid_t pid, std::uint64_t tick, stats_t & stats)
+{
+    for(auto it(f_history.lower_bound(key_t(pid, 0)));
+        it != f_history.end() && it->first.first == pid;
+        ++it)
+    {
+        if(it->second.f_tick == tick)
+        {
+            stats = it->second.f_last;
+            return true;
+        }
+    }
+
+    process_snapshot::process_t p;
+    p.f_pid = pid;
+    if(!process_snapshot::load_stat(p))
+    {
+        return false;
+    }
+    process_snapshot::load_io(p);
+    process_snapshot::load_fd_count(p);
+
+    stats = stats_t();
+    stats.f_sample_time = monotonic_seconds();
+    stats.f_start_time = p.f_start_time;
+    stats.f_cpu_ticks = p.f_cpu_ticks;
+    stats.f_rss = p.f_rss;
+    stats.f_read_bytes = p.f_read_bytes;
+    stats.f_write_bytes = p.f_write_bytes;
+    stats.f_fd_count = p.f_fd_count;
+    stats.f_threads = p.f_threads;
+
+    purge(stats.f_sample_time);
+
+    history_t & h(f_history[key_t(pid, stats.f_start_time)]);
+    if(h.f_last.f_sample_time > 0.0)
+    {
+        double const elapsed(stats.f_sample_time - h.f_last.f_sample_time);
+        if(elapsed > 0.0)
+        {
+            static long const clock_ticks(sysconf(_SC_CLK_TCK));
+
+            stats.f_has_rates = true;
+            stats.f_pcpu = static_cast<double>(stats.f_cpu_ticks - h.f_last.f_cpu_ticks)
+                                / static_cast<double>(clock_ticks)
+                                / elapsed
+                                * 100.0;
+            stats.f_rss_rate = (static_cast<double>(stats.f_rss) - static_cast<double>(h.f_last.f_rss))
+                                / elapsed;
+            if(stats.f_read_bytes >= 0
+            && h.f_last.f_read_bytes >= 0)
+            {
+                stats.f_read_rate = static_cast<double>(stats.f_read_bytes - h.f_last.f_read_bytes) / elapsed;
+                stats.f_write_rate = static_cast<double>(stats.f_write_bytes - h.f_last.f_write_bytes) / elapsed;
+            }
+        }
+    }
+
+    h.f_rss.push_back(std::make_pair(stats.f_sample_time, static_cast<double>(stats.f_rss)));
+    while(h.f_rss.size() > MAXIMUM_SAMPLES
+       || stats.f_sample_time - h.f_rss.front().first > HISTORY_PERIOD)
+    {
+        h.f_rss.pop_front();
+    }
+    compute_slope(h, stats);
+
+    h.f_tick = tick;
+    h.f_last = stats;
+
+    return true;
+}
+
+
+/** \brief Compute the slope of the RSS history.
+ *
+ * This function computes a linear regression over the RSS samples. The
+ * slope is saved in bytes per second.
+ *
+ * A leak is reported when the samples cover at least MINIMUM_LEAK_PERIOD
+ * seconds (and there are at least MINIMUM_LEAK_SAMPLES of them), the
+ * slope is positive, the correlation is at least MINIMUM_LEAK_CORRELATION,
+ * and the RSS grew by at least MINIMUM_LEAK_GROWTH over the period. The
+ * period is measured in time, not in number of samples, since forced
+ * ticks can make samples much closer than the tick frequency.
+ *
+ * \param[in] h  The history of the process.
+ * \param[in,out] stats  The statistics where the slope is saved.
+ */
+void process_history::compute_slope(history_t & h, stats_t & stats)
+{
+    std::size_t const n(h.f_rss.size());
+    if(n < 2)
+    {
+        return;
+    }
+
+    // use times relative to the first sample to keep the precision
+    //
+    double const t0(h.f_rss.front().first);
+    double sum_t(0.0);
+    double sum_r(0.0);
+    for(auto const & s : h.f_rss)
+    {
+        sum_t += s.first - t0;
+        sum_r += s.second;
+    }
+    double const mean_t(sum_t / static_cast<double>(n));
+    double const mean_r(sum_r / static_cast<double>(n));
+
+    double cov(0.0);
+    double var_t(0.0);
+    double var_r(0.0);
+    for(auto const & s : h.f_rss)
+    {
+        double const dt(s.first - t0 - mean_t);
+        double const dr(s.second - mean_r);
+        cov += dt * dr;
+        var_t += dt * dt;
+        var_r += dr * dr;
+    }
+    if(var_t <= 0.0)
+    {
+        return;
+    }
+
+    stats.f_rss_slope = cov / var_t;
+
+    double const span(h.f_rss.back().first - t0);
+    if(n >= MINIMUM_LEAK_SAMPLES
+    && span >= MINIMUM_LEAK_PERIOD
+    && stats.f_rss_slope > 0.0
+    && var_r > 0.0
+    && mean_r > 0.0)
+    {
+        double const correlation(cov / std::sqrt(var_t * var_r));
+        double const growth(stats.f_rss_slope * span / mean_r);
+        stats.f_leak = correlation >= MINIMUM_LEAK_CORRELATION
+                    && growth >= MINIMUM_LEAK_GROWTH;
+    }
+}
+
+
+/** \brief Forget about processes which were not sampled in a while.
+ *
+ * Processes which died or are not watched anymore would otherwise stay
+ * in the history forever.
+ *
+ * \param[in] now  The current monotonic time.
+ */
+void process_history::purge(double now)
+{
+    for(auto it(f_history.begin()); it != f_history.end(); )
+    {
+        if(now - it->second.f_last.f_sample_time > MAXIMUM_IDLE_TIME)
+        {
+            it = f_history.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,107 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <cstdint>
+#include    <deque>
+#include    <map>
+#include    <memory>
+
+
+// C
+//
+#include    <unistd.h>
+
+
+
+/** \file
+ * \brief This file declares the history of the watched processes.
+ *
+ * The history keeps the last sample of each process to compute rates
+ * (CPU, RSS, I/O) over the last tick and the RSS of the last hour to
+ * detect memory leaks.
+ */
+
+
+
+namespace sitter
+{
+
+
+
+class process_history
+{
+public:
+    typedef std::shared_ptr<process_history>    pointer_t;
+
+    static constexpr double const               HISTORY_PERIOD = 3600.0;        // keep 1 hour of RSS samples
+    static constexpr std::size_t const          MAXIMUM_SAMPLES = 360;          // 1 hour of ticks at the shortest tick interval
+    static constexpr double const               MINIMUM_LEAK_PERIOD = 1800.0;   // 30 minutes
+    static constexpr std::size_t const          MINIMUM_LEAK_SAMPLES = 10;
+    static constexpr double const               MINIMUM_LEAK_CORRELATION = 0.9;
+    static constexpr double const               MINIMUM_LEAK_GROWTH = 0.1;      // 10%
+    static constexpr double const               MAXIMUM_IDLE_TIME = 3600.0;     // forget processes not sampled for 1 hour
+
+    struct stats_t
+    {
+        double                  f_sample_time = 0.0;
+        std::uint64_t           f_start_time = 0;
+        std::uint64_t           f_cpu_ticks = 0;
+        std::uint64_t           f_rss = 0;
+        std::int64_t            f_read_bytes = -1;
+        std::int64_t            f_write_bytes = -1;
+        std::int64_t            f_fd_count = -1;
+        std::int64_t            f_threads = 0;
+
+        // the following are computed from the previous sample(s)
+        //
+        bool                    f_has_rates = false;
+        double                  f_pcpu = 0.0;
+        double                  f_rss_rate = 0.0;
+        double                  f_read_rate = 0.0;
+        double                  f_write_rate = 0.0;
+        double                  f_rss_slope = 0.0;
+        bool                    f_leak = false;
+    };
+
+    bool                        sample(pid_t pid, std::uint64_t tick, stats_t & stats);
+
+private:
+    typedef std::pair<pid_t, std::uint64_t>     key_t;
+
+    struct history_t
+    {
+        std::uint64_t           f_tick = 0;
+        stats_t                 f_last = stats_t();
+        std::deque<std::pair<double, double>>
+                                f_rss = std::deque<std::pair<double, double>>();
+    };
+    typedef std::map<key_t, history_t>          history_map_t;
+
+    static void                 compute_slope(history_t & h, stats_t & stats);
+    void                        purge(double now);
+
+    history_map_t               f_history = history_map_t();
+};
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,525 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "sitter/process_snapshot.h"
+#include    "sitter/monotonic_clock.h"
+
+
+// snapdev
+//
+#include    <snapdev/file_contents.h>
+#include    <snapdev/trim_string.h>
+
+
+// C++
+//
+#include    <algorithm>
+#include    <iomanip>
+#include    <sstream>
+#include    <stdexcept>
+
+
+// C
+//
+#include    <dirent.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements a snapshot of all the processes.
+ *
+ * When the cpu or memory plugins detect a high usage, the administrator
+ * wants to know which processes are responsible. The snapshot is taken
+ * once per tick, before the plugins run, and it is shared by all the
+ * plugins.
+ *
+ * The CPU and I/O values are computed over the interval between two
+ * snapshots so they represent what the processes are doing now and not
+ * since they started.
+ *
+ * The static load_...() functions are the only readers of the files
+ * under /proc/<pid>. They are also used to sample a single process
+ * (process_history) or to get its command line (process_connector and
+ * the processes plugin).
+ *
+ * \note
+ * The I/O counters are only readable by the owner of a process (or root)
+ * so they are likely missing for most processes.
+ */
+
+
+
+namespace sitter
+{
+
+
+
+
+/** \brief Take a new snapshot of all the processes.
+ *
+ * This function reads the statistics of all the processes and computes
+ * the interval values against the previous snapshot.
+ */
+void process_snapshot::refresh()
+{
+    static double const clock_ticks(static_cast<double>(sysconf(_SC_CLK_TCK)));
+
+    double const now(monotonic_seconds());
+    double const elapsed(f_previous_time > 0.0 ? now - f_previous_time : 0.0);
+
+    f_processes.clear();
+    f_loaded = true;
+
+    for(pid_t const pid : get_pids())
+    {
+        process_t p;
+        p.f_pid = pid;
+        if(!load_stat(p))
+        {
+            continue;
+        }
+        load_status(p);
+        load_io(p);
+
+        auto const previous(f_previous.find(key_t(p.f_pid, p.f_start_time)));
+        if(previous != f_previous.end()
+        && elapsed > 0.0)
+        {
+            p.f_pcpu = static_cast<double>(p.f_cpu_ticks - previous->second.f_cpu_ticks)
+                        / clock_ticks
+                        / elapsed
+                        * 100.0;
+            if(p.f_io_bytes >= 0
+            && previous->second.f_io_bytes >= 0)
+            {
+                p.f_io = p.f_io_bytes - previous->second.f_io_bytes;
+            }
+        }
+
+        f_processes.push_back(p);
+    }
+
+    f_previous.clear();
+    for(auto const & p : f_processes)
+    {
+        f_previous[key_t(p.f_pid, p.f_start_time)] = p;
+    }
+    f_previous_time = now;
+}
+
+
+/** \brief Check whether a snapshot was taken.
+ *
+ * \return true if refresh() was called at least once.
+ */
+bool process_snapshot::is_loaded() const
+{
+    return f_loaded;
+}
+
+
+/** \brief Get the list of processes of the last snapshot.
+ *
+ * \return A reference to the list of processes.
+ */
+process_snapshot::process_vector_t const & process_snapshot::get_processes() const
+{
+    return f_processes;
+}
+
+
+/** \brief Get the top \p n consumers of a resource.
+ *
+ * This function uses a partial sort so only the first \p n processes
+ * get sorted. Processes with a value of zero are not included.
+ *
+ * \param[in] resource  The resource to sort on.
+ * \param[in] n  The maximum number of processes to return.
+ *
+ * \return The top consumers, largest first.
+ */
+process_snapshot::process_vector_t process_snapshot::get_top(resource_t resource, std::size_t n) const
+{
+    process_vector_t result(std::min(n, f_processes.size()));
+    result.resize(std::partial_sort_copy(
+              f_processes.begin()
+            , f_processes.end()
+            , result.begin()
+            , result.end()
+            , [resource](process_t const & a, process_t const & b)
+                {
+                    return get_value(a, resource) > get_value(b, resource);
+                }) - result.begin());
+
+    while(!result.empty()
+       && get_value(result.back(), resource) <= 0.0)
+    {
+        result.pop_back();
+    }
+
+    return result;
+}
+
+
+/** \brief Get the value of a process for the specified resource.
+ *
+ * \param[in] p  The process.
+ * \param[in] resource  The resource to retrieve.
+ *
+ * \return The value as a double.
+ */
+double process_snapshot::get_value(process_t const & p, resource_t resource)
+{
+    switch(resource)
+    {
+    case resource_t::RESOURCE_CPU:
+        return p.f_pcpu;
+
+    case resource_t::RESOURCE_RSS:
+        return static_cast<double>(p.f_rss);
+
+    case resource_t::RESOURCE_SWAP:
+        return static_cast<double>(p.f_swap);
+
+    case resource_t::RESOURCE_IO:
+        return static_cast<double>(p.f_io);
+
+    default:
+        return 0.0;
+
+    }
+}
+
+
+/** \brief Format the value of a process for an error message.
+ *
+ * \param[in] p  The process.
+ * \param[in] resource  The resource to format.
+ *
+ * \return The value followed by its unit.
+ */
+std::string process_snapshot::format_value(process_t const & p, resource_t resource)
+{
+    std::stringstream ss;
+    if(resource == resource_t::RESOURCE_CPU)
+    {
+        ss << std::fixed << std::setprecision(1) << p.f_pcpu << '%';
+    }
+    else
+    {
+        ss << static_cast<std::int64_t>(get_value(p, resource) / 1024.0) << " KiB";
+    }
+    return ss.str();
+}
+
+
+/** \brief Get the list of processes currently running.
+ *
+ * This function reads the list of directories under /proc which are
+ * numbers (PIDs).
+ *
+ * \return The list of PIDs.
+ */
+std::vector<pid_t> process_snapshot::get_pids()
+{
+    std::vector<pid_t> result;
+
+    DIR * d(opendir("/proc"));
+    if(d == nullptr)
+    {
+        return result;
+    }
+
+    for(dirent const * ent(readdir(d)); ent != nullptr; ent = readdir(d))
+    {
+        char const * s(ent->d_name);
+        pid_t pid(0);
+        for(; *s >= '0' && *s <= '9'; ++s)
+        {
+            pid = pid * 10 + *s - '0';
+        }
+        if(*s != '\0'
+        || pid <= 0)
+        {
+            continue;
+        }
+        result.push_back(pid);
+    }
+    closedir(d);
+
+    return result;
+}
+
+
+/** \brief Load the /proc/<pid>/stat file.
+ *
+ * The name of the process is written between parenthesis and may
+ * include spaces so the fields are counted from the closing parenthesis.
+ *
+ * \param[in,out] p  The process to load, f_pid must be set.
+ *
+ * \return false if the process could not be read (i.e. it died).
+ */
+bool process_snapshot::load_stat(process_t & p)
+{
+    static std::uint64_t const page_size(sysconf(_SC_PAGESIZE));
+
+    snapdev::file_contents stat("/proc/" + std::to_string(p.f_pid) + "/stat");
+    if(!stat.read_all())
+    {
+        return false;
+    }
+    std::string const & contents(stat.contents());
+    std::string::size_type const open_paren(contents.find('('));
+    std::string::size_type const close_paren(contents.rfind(')'));
+    if(open_paren == std::string::npos
+    || close_paren == std::string::npos
+    || close_paren < open_paren)
+    {
+        return false;
+    }
+    p.f_name = contents.substr(open_paren + 1, close_paren - open_paren - 1);
+
+    // fields[0] is field 3 (state) in proc(5)
+    //
+    std::vector<std::string> fields;
+    std::string::size_type pos(close_paren + 2);
+    while(pos < contents.length())
+    {
+        std::string::size_type const end(contents.find(' ', pos));
+        if(end == std::string::npos)
+        {
+            fields.push_back(contents.substr(pos));
+            break;
+        }
+        fields.push_back(contents.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    if(fields.size() < 22)
+    {
+        return false;
+    }
+    try
+    {
+        p.f_cpu_ticks = std::stoull(fields[11])     // utime
+                      + std::stoull(fields[12]);    // stime
+        p.f_threads = std::stoll(fields[17]);
+        p.f_start_time = std::stoull(fields[19]);
+        p.f_rss = std::stoull(fields[21]) * page_size;
+    }
+    catch(std::logic_error const &)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+
+/** \brief Load the swap usage from the /proc/<pid>/status file.
+ *
+ * Kernel threads have no VmSwap field. In that case f_swap remains 0.
+ *
+ * \param[in,out] p  The process to load, f_pid must be set.
+ */
+void process_snapshot::load_status(process_t & p)
+{
+    snapdev::file_contents status("/proc/" + std::to_string(p.f_pid) + "/status");
+    if(!status.read_all())
+    {
+        return;
+    }
+
+    std::string const & s(status.contents());
+    std::string::size_type const pos(s.find("\nVmSwap:"));
+    if(pos != std::string::npos)
+    {
+        try
+        {
+            p.f_swap = std::stoull(s.substr(pos + 8)) * 1024;
+        }
+        catch(std::logic_error const &)
+        {
+        }
+    }
+}
+
+
+/** \brief Load the /proc/<pid>/io file.
+ *
+ * This file is only readable by the owner of the process (or root). If
+ * we cannot read it, the read and write bytes remain set to -1.
+ *
+ * \param[in,out] p  The process to load, f_pid must be set.
+ */
+void process_snapshot::load_io(process_t & p)
+{
+    snapdev::file_contents io("/proc/" + std::to_string(p.f_pid) + "/io");
+    if(!io.read_all())
+    {
+        return;
+    }
+
+    std::string const & contents(io.contents());
+    auto get_field([&contents](std::string const & name) -> std::int64_t
+        {
+            // the '\n' prevents "cancelled_write_bytes" from matching
+            //
+            std::string::size_type const pos(contents.find('\n' + name + ": "));
+            if(pos == std::string::npos)
+            {
+                return -1;
+            }
+            try
+            {
+                return std::stoll(contents.substr(pos + name.length() + 3));
+            }
+            catch(std::logic_error const &)
+            {
+                return -1;
+            }
+        });
+
+    std::int64_t const read_bytes(get_field("read_bytes"));
+    std::int64_t const write_bytes(get_field("write_bytes"));
+    if(read_bytes < 0
+    || write_bytes < 0)
+    {
+        return;
+    }
+    p.f_read_bytes = read_bytes;
+    p.f_write_bytes = write_bytes;
+    p.f_io_bytes = read_bytes + write_bytes;
+}
+
+
+/** \brief Count the number of file descriptors opened by a process.
+ *
+ * Like the io file, the fd directory is only accessible to the owner of
+ * the process. If we cannot read it, the count remains -1.
+ *
+ * \param[in,out] p  The process to load, f_pid must be set.
+ */
+void process_snapshot::load_fd_count(process_t & p)
+{
+    DIR * d(opendir(("/proc/" + std::to_string(p.f_pid) + "/fd").c_str()));
+    if(d == nullptr)
+    {
+        return;
+    }
+
+    std::int64_t count(0);
+    for(dirent const * ent(readdir(d)); ent != nullptr; ent = readdir(d))
+    {
+        if(ent->d_name[0] != '.')
+        {
+            ++count;
+        }
+    }
+    closedir(d);
+
+    p.f_fd_count = count;
+}
+
+
+/** \brief Load the command and command line of a process.
+ *
+ * The command is the basename of the first argument of the command line.
+ * The command line includes the first argument as is (with its path)
+ * followed by all the non-empty arguments separated by spaces. This is
+ * the format the processes plugin expects when matching regular
+ * expressions.
+ *
+ * Kernel threads have no command line. In that case the command is read
+ * from the comm file.
+ *
+ * \param[in,out] p  The process to load, f_pid must be set.
+ *
+ * \return false if the process could not be read (i.e. it died).
+ */
+bool process_snapshot::load_command(process_t & p)
+{
+    p.f_command.clear();
+    p.f_cmdline.clear();
+
+    std::string const proc_path("/proc/" + std::to_string(p.f_pid) + "/");
+
+    std::string command;
+    snapdev::file_contents cmdline(proc_path + "cmdline");
+    if(cmdline.read_all())
+    {
+        std::string const & args(cmdline.contents());
+        std::string::size_type pos(0);
+        while(pos < args.length())
+        {
+            std::string::size_type end(args.find('\0', pos));
+            if(end == std::string::npos)
+            {
+                end = args.length();
+            }
+            if(pos == 0)
+            {
+                command = args.substr(0, end);
+            }
+            if(end > pos)
+            {
+                if(!p.f_cmdline.empty())
+                {
+                    p.f_cmdline += ' ';
+                }
+                p.f_cmdline += args.substr(pos, end - pos);
+            }
+            pos = end + 1;
+        }
+    }
+
+    if(command.empty())
+    {
+        snapdev::file_contents comm(proc_path + "comm");
+        if(!comm.read_all())
+        {
+            // process is gone
+            //
+            return false;
+        }
+        command = snapdev::trim_string(comm.contents());
+        p.f_cmdline = command;
+    }
+
+    std::string::size_type const slash(command.rfind('/'));
+    p.f_command = slash == std::string::npos
+                    ? command
+                    : command.substr(slash + 1);
+
+    return true;
+}
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
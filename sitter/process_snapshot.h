@@ -0,0 +1,112 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <cstdint>
+#include    <map>
+#include    <memory>
+#include    <string>
+#include    <vector>
+
+
+// C
+//
+#include    <unistd.h>
+
+
+
+/** \file
+ * \brief This file declares a snapshot of all the processes.
+ *
+ * The snapshot is also the one place where the files under /proc/<pid>
+ * get read and parsed. The process history, the process connector, and
+ * the processes plugin use its static functions.
+ */
+
+
+
+namespace sitter
+{
+
+
+
+enum class resource_t
+{
+    RESOURCE_CPU,
+    RESOURCE_RSS,
+    RESOURCE_SWAP,
+    RESOURCE_IO,
+};
+
+
+class process_snapshot
+{
+public:
+    typedef std::shared_ptr<process_snapshot>   pointer_t;
+
+    struct process_t
+    {
+        pid_t                   f_pid = 0;
+        std::string             f_name = std::string();
+        std::string             f_command = std::string();
+        std::string             f_cmdline = std::string();
+        std::uint64_t           f_start_time = 0;
+        std::uint64_t           f_cpu_ticks = 0;
+        std::int64_t            f_threads = 0;
+        std::int64_t            f_read_bytes = -1;
+        std::int64_t            f_write_bytes = -1;
+        std::int64_t            f_io_bytes = -1;
+        std::int64_t            f_fd_count = -1;
+        double                  f_pcpu = 0.0;
+        std::uint64_t           f_rss = 0;
+        std::uint64_t           f_swap = 0;
+        std::int64_t            f_io = 0;
+    };
+    typedef std::vector<process_t>              process_vector_t;
+
+    void                        refresh();
+    bool                        is_loaded() const;
+    process_vector_t const &    get_processes() const;
+    process_vector_t            get_top(resource_t resource, std::size_t n) const;
+
+    static double               get_value(process_t const & p, resource_t resource);
+    static std::string          format_value(process_t const & p, resource_t resource);
+
+    static std::vector<pid_t>   get_pids();
+    static bool                 load_stat(process_t & p);
+    static void                 load_status(process_t & p);
+    static void                 load_io(process_t & p);
+    static void                 load_fd_count(process_t & p);
+    static bool                 load_command(process_t & p);
+
+private:
+    typedef std::pair<pid_t, std::uint64_t>     key_t;
+    typedef std::map<key_t, process_t>          previous_map_t;
+
+    process_vector_t            f_processes = process_vector_t();
+    previous_map_t              f_previous = previous_map_t();
+    double                      f_previous_time = 0.0;
+    bool                        f_loaded = false;
+};
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
@@ -0,0 +1,368 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "sitter/service_watchdog.h"
+#include    "sitter/monotonic_clock.h"
+
+#include    "sitter/names.h"
+#include    "sitter/sitter.h"
+
+
+// advgetopt
+//
+#include    <advgetopt/utils.h>
+#include    <advgetopt/validator_integer.h>
+
+
+// cppthread
+//
+#include    <cppthread/guard.h>
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// C++
+//
+#include    <algorithm>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the service watchdog.
+ *
+ * The watchdog sends an ALIVE message to the services listed in the
+ * watchdog_services parameter (fluid_settings by default). Each service
+ * which is connected to the communicatord replies with ABSOLUTELY.
+ *
+ * The list is not obtained from the communicatord since a service which
+ * is not running at all would then never be reported. Instead, the
+ * administrator lists the services expected on this computer. The round trip time is saved
+ * in a latency tracker per service: a baseline representing the usual
+ * latency and a recent histogram representing the last minute.
+ *
+ * The messages are paced: the timer sends a single ALIVE message every
+ * watchdog_interval seconds, going through the list of services in a
+ * round robin manner. Adding services makes each service be pinged less
+ * often but it never increases the number of messages on the network.
+ *
+ * The results are read by the watchdog plugin from the worker thread so
+ * the state is protected by a mutex.
+ */
+
+
+
+namespace sitter
+{
+
+
+
+namespace
+{
+
+
+
+// the services get pinged every few seconds; the baseline covers about
+// the last hour and the recent latencies the last minute
+//
+latency_settings_t const    g_latency_settings =
+{
+    40.0 * 60.0,    // baseline period
+    60.0,           // recent period
+    50.0,           // minimum samples
+    10.0 * 60.0,    // minimum period
+};
+
+
+
+} // no name namespace
+
+
+
+
+/** \class service_watchdog
+ * \brief Ping the services one at a time.
+ *
+ * This class is a timer added to the ed::communicator. The messages are
+ * sent and the replies received in the main thread.
+ */
+
+
+
+/** \brief Initialize the service watchdog.
+ *
+ * The timer is created disabled. It gets enabled once the fluid-settings
+ * parameters are available.
+ *
+ * \param[in] s  A pointer to the server object.
+ */
+service_watchdog::service_watchdog(server * s)
+    : timer(DEFAULT_INTERVAL * 1'000'000LL)
+    , f_server(s)
+{
+    set_name("service_watchdog");
+    set_enable(false);
+}
+
+
+service_watchdog::~service_watchdog()
+{
+}
+
+
+/** \brief Get the status of each service.
+ *
+ * \return A copy of the status of all the watched services.
+ */
+service_watchdog::service_status_vector_t service_watchdog::get_status()
+{
+    cppthread::guard lock(f_mutex);
+
+    service_status_vector_t result;
+    result.reserve(f_services.size());
+    for(auto const & s : f_services)
+    {
+        result.push_back(s.f_status);
+    }
+    return result;
+}
+
+
+/** \brief Handle an ABSOLUTELY reply.
+ *
+ * The reply includes the serial number of our ALIVE message. It is used
+ * to find the service and compute the round trip time. A reply received
+ * after the timeout is ignored since that ping was already counted as
+ * missed.
+ *
+ * \param[in] message  The ABSOLUTELY message.
+ */
+void service_watchdog::reply(ed::message & message)
+{
+    if(!message.has_parameter(g_name_sitter_param_serial))
+    {
+        return;
+    }
+    std::int64_t serial(0);
+    if(!advgetopt::validator_integer::convert_string(
+              message.get_parameter(g_name_sitter_param_serial)
+            , serial))
+    {
+        return;
+    }
+
+    std::int64_t const now(monotonic_usec());
+
+    cppthread::guard lock(f_mutex);
+
+    for(auto & s : f_services)
+    {
+        if(s.f_sent_on == 0
+        || s.f_serial != static_cast<std::uint32_t>(serial))
+        {
+            continue;
+        }
+
+        double const latency(static_cast<double>(now - s.f_sent_on));
+        s.f_sent_on = 0;
+
+        s.f_status.f_latency.add(latency);
+
+        if(s.f_status.f_missed != 0)
+        {
+            SNAP_LOG_INFO
+                << "service \""
+                << s.f_status.f_name
+                << "\" answers ALIVE messages again."
+                << SNAP_LOG_SEND;
+        }
+
+        s.f_status.f_replies += 1;
+        s.f_status.f_missed = 0;
+        s.f_status.f_last_reply = time(nullptr);
+        s.f_status.f_last_latency = latency;
+        break;
+    }
+}
+
+
+/** \brief Time to send the next ALIVE message.
+ *
+ * This function counts the pings which timed out and then sends one
+ * ALIVE message to the next service in the list.
+ *
+ * Nothing is sent while the communicatord is not connected since the
+ * messages would not go anywhere.
+ */
+void service_watchdog::process_timeout()
+{
+    update_services();
+
+    std::int64_t const now(monotonic_usec());
+    check_timeouts(now);
+
+    if(f_server->get_communicatord_is_connected())
+    {
+        send_alive(now);
+    }
+
+    // the interval may change through fluid-settings
+    //
+    set_timeout_delay(f_server->get_integer_parameter(g_name_sitter_watchdog_interval, DEFAULT_INTERVAL, MINIMUM_INTERVAL) * 1'000'000LL);
+}
+
+
+/** \brief Update the list of services.
+ *
+ * The list of services may change through fluid-settings. Services
+ * which remain in the list keep their statistics.
+ */
+void service_watchdog::update_services()
+{
+    advgetopt::string_list_t names;
+    advgetopt::split_string(
+              f_server->get_server_parameter(g_name_sitter_watchdog_services)
+            , names
+            , { "," });
+
+    cppthread::guard lock(f_mutex);
+
+    f_timeout = f_server->get_integer_parameter(g_name_sitter_watchdog_timeout, DEFAULT_TIMEOUT, MINIMUM_INTERVAL) * 1'000'000LL;
+
+    service_vector_t services;
+    services.reserve(names.size());
+    for(auto const & n : names)
+    {
+        auto it(std::find_if(
+                  f_services.begin()
+                , f_services.end()
+                , [&n](service_t const & s)
+                {
+                    return s.f_status.f_name == n;
+                }));
+        if(it != f_services.end())
+        {
+            services.push_back(*it);
+        }
+        else
+        {
+            service_t s;
+            s.f_status.f_name = n;
+            s.f_status.f_latency = latency_tracker(g_latency_settings);
+            services.push_back(s);
+        }
+    }
+    f_services.swap(services);
+
+    if(f_next >= f_services.size())
+    {
+        f_next = 0;
+    }
+}
+
+
+/** \brief Count the pings which did not receive a reply in time.
+ *
+ * \param[in] now  The current time in microseconds.
+ */
+void service_watchdog::check_timeouts(std::int64_t now)
+{
+    cppthread::guard lock(f_mutex);
+
+    for(auto & s : f_services)
+    {
+        if(s.f_sent_on != 0
+        && now - s.f_sent_on >= f_timeout)
+        {
+            s.f_sent_on = 0;
+            s.f_status.f_missed += 1;
+
+            SNAP_LOG_WARNING
+                << "service \""
+                << s.f_status.f_name
+                << "\" did not answer ALIVE message #"
+                << s.f_serial
+                << "."
+                << SNAP_LOG_SEND;
+        }
+    }
+}
+
+
+/** \brief Send an ALIVE message to the next service.
+ *
+ * A service which did not yet answer our previous message is skipped
+ * so a stuck service never gets more than one pending message.
+ *
+ * \param[in] now  The current time in microseconds.
+ */
+void service_watchdog::send_alive(std::int64_t now)
+{
+    cppthread::guard lock(f_mutex);
+
+    if(f_services.empty())
+    {
+        return;
+    }
+
+    service_t & s(f_services[f_next]);
+    f_next = (f_next + 1) % f_services.size();
+    if(s.f_sent_on != 0)
+    {
+        return;
+    }
+
+    ++f_serial;
+    if(f_serial == 0)
+    {
+        f_serial = 1;
+    }
+
+    ed::message alive;
+    alive.set_command(g_name_sitter_cmd_alive);
+    alive.set_service(s.f_status.f_name);
+    alive.add_parameter(g_name_sitter_param_cache, "no");
+    alive.add_parameter(g_name_sitter_param_serial, std::to_string(f_serial));
+    if(!f_server->send_message(alive))
+    {
+        // not a missed ping, the message did not leave
+        //
+        return;
+    }
+
+    s.f_serial = f_serial;
+    s.f_sent_on = now;
+    s.f_status.f_sent += 1;
+}
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
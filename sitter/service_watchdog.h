@@ -0,0 +1,121 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    <sitter/latency_tracker.h>
+
+
+// eventdispatcher
+//
+#include    <eventdispatcher/message.h>
+#include    <eventdispatcher/timer.h>
+
+
+// cppthread
+//
+#include    <cppthread/mutex.h>
+
+
+// C++
+//
+#include    <string>
+#include    <vector>
+
+
+
+/** \file
+ * \brief This file declares the service watchdog.
+ *
+ * Knowing that the process of a service exists does not tell us whether
+ * that service still answers messages. The watchdog sends an ALIVE
+ * message to one service at a time through the communicatord and
+ * measures how long it takes for the ABSOLUTELY reply to come back.
+ *
+ * This is considered an internal class.
+ */
+
+
+
+
+namespace sitter
+{
+
+
+
+class server;
+
+class service_watchdog
+    : public ed::timer
+{
+public:
+    typedef std::shared_ptr<service_watchdog>   pointer_t;
+
+    static constexpr std::int64_t const         DEFAULT_INTERVAL = 5;          // seconds between two ALIVE messages
+    static constexpr std::int64_t const         MINIMUM_INTERVAL = 1;          // 1 second
+    static constexpr std::int64_t const         DEFAULT_TIMEOUT = 10;          // seconds before a ping is considered missed
+
+    struct service_status_t
+    {
+        std::string             f_name = std::string();
+        std::int64_t            f_sent = 0;
+        std::int64_t            f_replies = 0;
+        std::int64_t            f_missed = 0;           // consecutive pings without a reply
+        time_t                  f_last_reply = 0;
+        double                  f_last_latency = 0.0;   // microseconds
+        latency_tracker         f_latency = latency_tracker();
+    };
+    typedef std::vector<service_status_t>       service_status_vector_t;
+
+                                service_watchdog(server * s);
+                                service_watchdog(service_watchdog const & rhs) = delete;
+    virtual                     ~service_watchdog() override;
+    service_watchdog &          operator = (service_watchdog const & rhs) = delete;
+
+    service_status_vector_t     get_status();
+    void                        reply(ed::message & message);
+
+    // ed::timer implementation
+    virtual void                process_timeout() override;
+
+private:
+    struct service_t
+    {
+        service_status_t        f_status = service_status_t();
+        std::uint32_t           f_serial = 0;
+        std::int64_t            f_sent_on = 0;          // 0 when no ping is pending
+    };
+    typedef std::vector<service_t>              service_vector_t;
+
+    void                        update_services();
+    void                        check_timeouts(std::int64_t now);
+    void                        send_alive(std::int64_t now);
+
+    server *                    f_server = nullptr;
+    cppthread::mutex            f_mutex = cppthread::mutex();
+    service_vector_t            f_services = service_vector_t();
+    std::size_t                 f_next = 0;
+    std::uint32_t               f_serial = 0;
+    std::int64_t                f_timeout = DEFAULT_TIMEOUT * 1'000'000LL;
+};
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
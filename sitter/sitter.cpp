@@ -22,6 +22,7 @@
 #include    "sitter/sitter.h"
 
 #include    "sitter/exception.h"
+#include    "sitter/monotonic_clock.h"
 #include    "sitter/names.h"
 #include    "sitter/version.h"
 
@@ -37,10 +38,16 @@
 //
 #include    <advgetopt/conf_file.h>
 #include    <advgetopt/exception.h>
+#include    <advgetopt/utils.h>
 #include    <advgetopt/validator_duration.h>
 #include    <advgetopt/validator_integer.h>
 
 
+// cppthread
+//
+#include    <cppthread/guard.h>
+
+
 // snapdev
 //
 #include    <snapdev/file_contents.h>
@@ -207,6 +214,78 @@ int server::run()
     f_tick_timer = std::make_shared<tick_timer>(this);
     f_communicator->add_connection(f_tick_timer);
 
+    // listen to the kernel process events so we know about processes
+    // exiting as they happen instead of at the next tick; this requires
+    // the CAP_NET_ADMIN capability, without it the plugins fall back to
+    // scanning /proc on each tick
+    //
+    // IMPORTANT: this must be done before the worker thread starts since
+    //            the communicator is not thread safe
+    //
+    std::string const use_process_connector(get_server_parameter(g_name_sitter_process_connector));
+    if(use_process_connector.empty()
+    || advgetopt::is_true(use_process_connector))
+    {
+        f_process_connector = std::make_shared<process_connector>(this);
+        if(f_process_connector->is_listening())
+        {
+            f_communicator->add_connection(f_process_connector);
+        }
+        else
+        {
+            f_process_connector.reset();
+        }
+    }
+
+    // watch mandatory processes once found so we do not have to search
+    // for them on each tick
+    //
+    f_pidfd_watcher = std::make_shared<pidfd_watcher>(this);
+    if(f_pidfd_watcher->is_valid())
+    {
+        f_communicator->add_connection(f_pidfd_watcher);
+    }
+    else
+    {
+        f_pidfd_watcher.reset();
+    }
+
+    // record network link state changes as they happen
+    //
+    f_link_monitor = std::make_shared<link_monitor>(this);
+    if(f_link_monitor->is_listening())
+    {
+        f_communicator->add_connection(f_link_monitor);
+    }
+    else
+    {
+        f_link_monitor.reset();
+    }
+
+    // classify the kernel log records as they arrive; this requires
+    // the CAP_SYSLOG capability when kernel.dmesg_restrict is set
+    //
+    std::string const use_kmsg_monitor(get_server_parameter(g_name_sitter_kmsg_monitor));
+    if(use_kmsg_monitor.empty()
+    || advgetopt::is_true(use_kmsg_monitor))
+    {
+        f_kmsg_monitor = std::make_shared<kmsg_monitor>(this);
+        if(f_kmsg_monitor->is_listening())
+        {
+            f_communicator->add_connection(f_kmsg_monitor);
+        }
+        else
+        {
+            f_kmsg_monitor.reset();
+        }
+    }
+
+    // ping the services through the communicatord; the timer gets
+    // enabled once the fluid-settings parameters are available
+    //
+    f_service_watchdog = std::make_shared<service_watchdog>(this);
+    f_communicator->add_connection(f_service_watchdog);
+
     // start runner thread
     //
     f_worker_done = std::make_shared<worker_done>(this);
@@ -245,6 +324,10 @@ bool server::send_message(ed::message & message, bool cache)
  *
  * In case the tick happens too often, the function makes sure that the
  * child process is started at most once.
+ *
+ * \note
+ * This is the periodic tick (see tick_timer). It is never refused. The
+ * event sources call force_tick() instead.
  */
 void server::process_tick()
 {
@@ -252,6 +335,41 @@ void server::process_tick()
 }
 
 
+/** \brief Force a tick because of an event.
+ *
+ * The event sources (process exits, link changes, kernel errors, urgent
+ * log entries, etc.) call this function to force a tick so their errors
+ * get reported right away. To avoid keeping the worker thread busy when
+ * such events happen in a loop, forced ticks are limited to one every
+ * MINIMUM_TICK_INTERVAL seconds. The periodic tick is not affected.
+ *
+ * A refused tick does not lose the event: its source keeps the state
+ * which the plugins report on the next tick, periodic or forced.
+ *
+ * \note
+ * This function can be called from any thread.
+ *
+ * \return true if the tick was sent to the worker thread.
+ */
+bool server::force_tick()
+{
+    std::int64_t const now(monotonic_usec());
+    {
+        cppthread::guard lock(f_tick_mutex);
+
+        if(f_last_forced_tick != 0
+        && now - f_last_forced_tick < MINIMUM_TICK_INTERVAL * 1'000'000)
+        {
+            return false;
+        }
+        f_last_forced_tick = now;
+    }
+
+    f_worker->tick();
+    return true;
+}
+
+
 //bool server::init_parameters()
 //{
 // the below code worked when we had all the parameters at hand, now that
@@ -313,6 +431,15 @@ void server::process_tick()
 
 
 
+void server::msg_absolutely(ed::message & message)
+{
+    if(f_service_watchdog != nullptr)
+    {
+        f_service_watchdog->reply(message);
+    }
+}
+
+
 void server::msg_rusage(ed::message & message)
 {
     record_usage(message);
@@ -352,6 +479,10 @@ void server::ready(ed::message & message)
 void server::fluid_ready()
 {
     f_tick_timer->set_enable(true);
+    if(f_service_watchdog != nullptr)
+    {
+        f_service_watchdog->set_enable(true);
+    }
 }
 
 
@@ -914,9 +1045,155 @@ std::int64_t server::get_error_report_critical_span()
 }
 
 
+/** \brief Get the number of processes to include in top lists.
+ *
+ * When the cpu or memory plugins detect a high usage, they include the
+ * list of the processes using the most of that resource. This value
+ * defines the number of processes in that list. Zero turns off the
+ * feature.
+ *
+ * \return The number of processes to include in top lists.
+ */
+std::int64_t server::get_top_processes()
+{
+    if(f_top_processes < 0)
+    {
+        std::int64_t top_processes(DEFAULT_TOP_PROCESSES);
+        std::string const top_processes_str(get_server_parameter(g_name_sitter_top_processes));
+        if(!top_processes_str.empty())
+        {
+            if(!advgetopt::validator_integer::convert_string(top_processes_str, top_processes)
+            || top_processes < 0
+            || top_processes > MAXIMUM_TOP_PROCESSES)
+            {
+                SNAP_LOG_RECOVERABLE_ERROR
+                    << "top processes ("
+                    << top_processes_str
+                    << ") must be a number between 0 and "
+                    << MAXIMUM_TOP_PROCESSES
+                    << ". Using default instead."
+                    << SNAP_LOG_SEND;
+                top_processes = DEFAULT_TOP_PROCESSES;
+            }
+        }
+        f_top_processes = top_processes;
+    }
+
+    return f_top_processes;
+}
+
+
+/** \brief Take a snapshot of all the processes.
+ *
+ * The worker calls this function once per tick, before running the
+ * plugins. The snapshot is used to compute the top consumers of each
+ * resource when a plugin reports a high usage.
+ *
+ * If the top lists are turned off, the snapshot is not taken.
+ */
+void server::refresh_process_snapshot()
+{
+    if(get_top_processes() > 0)
+    {
+        f_process_snapshot.refresh();
+    }
+}
+
+
+/** \brief Output the top consumers of a resource.
+ *
+ * This function adds an array named "top_<resource>" to \p json with
+ * the processes using the most of \p resource. It also returns a
+ * string which can be appended to an error message so the email
+ * report says which processes are responsible.
+ *
+ * \param[in] json  The JSON object where the array is added.
+ * \param[in] resource  The resource to sort the processes by.
+ *
+ * \return A string listing the top processes or an empty string.
+ */
+std::string server::output_top_processes(
+      as2js::json::json_value_ref & json
+    , resource_t resource)
+{
+    std::int64_t const n(get_top_processes());
+    if(n <= 0
+    || !f_process_snapshot.is_loaded())
+    {
+        return std::string();
+    }
+
+    char const * field(nullptr);
+    char const * label(nullptr);
+    switch(resource)
+    {
+    case resource_t::RESOURCE_CPU:
+        field = "top_cpu";
+        label = " Top CPU processes:";
+        break;
+
+    case resource_t::RESOURCE_RSS:
+        field = "top_rss";
+        label = " Top memory processes:";
+        break;
+
+    case resource_t::RESOURCE_SWAP:
+        field = "top_swap";
+        label = " Top swap processes:";
+        break;
+
+    case resource_t::RESOURCE_IO:
+        field = "top_io";
+        label = " Top I/O processes:";
+        break;
+
+    default:
+        return std::string();
+
+    }
+
+    process_snapshot::process_vector_t const top(f_process_snapshot.get_top(resource, n));
+    if(top.empty())
+    {
+        return std::string();
+    }
+
+    std::string result(label);
+    char sep(' ');
+    as2js::json::json_value_ref list(json[field]);
+    for(auto const & p : top)
+    {
+        as2js::json::json_value_ref item(list[-1]);
+        item["pid"] = static_cast<std::int64_t>(p.f_pid);
+        item["name"] = p.f_name;
+        item["value"] = process_snapshot::get_value(p, resource);
+
+        result += sep;
+        result += p.f_name;
+        result += " (";
+        result += std::to_string(p.f_pid);
+        result += "): ";
+        result += process_snapshot::format_value(p, resource);
+        sep = ',';
+    }
+    result += '.';
+
+    return result;
+}
+
+
+/** \brief Save the number of ticks received since the last run.
+ *
+ * The worker thread calls this function once at the start of each run
+ * of the plugins. The function also increments the tick counter used
+ * to sample each process at most once per run.
+ *
+ * \param[in] ticks  The number of ticks received since the last run.
+ */
 void server::set_ticks(int ticks)
 {
     f_ticks = ticks;
+    ++f_tick_count;
 }
 
 
@@ -958,6 +1235,13 @@ void server::clear_cache(std::string const & name)
         }
         break;
 
+    case 't':
+        if(name == "top-processes")
+        {
+            f_top_processes = -1;
+        }
+        break;
+
     case 's':
         if(name == "statistics-frequency")
         {
@@ -1032,6 +1316,48 @@ bool server::output_process(
     process["cutime"] = std::to_string(cutime);
     process["cstime"] = std::to_string(cstime);
 
+    // the values above are cumulative since the process started, the
+    // history gives us values for the last interval
+    //
+    process_history::stats_t stats;
+    if(f_process_history.sample(info->get_pid(), f_tick_count, stats))
+    {
+        process["threads"] = stats.f_threads;
+        if(stats.f_fd_count >= 0)
+        {
+            process["fd_count"] = stats.f_fd_count;
+        }
+        if(stats.f_read_bytes >= 0)
+        {
+            process["read_bytes"] = stats.f_read_bytes;
+            process["write_bytes"] = stats.f_write_bytes;
+        }
+        if(stats.f_has_rates)
+        {
+            process["interval_pcpu"] = stats.f_pcpu;
+            process["rss_rate"] = stats.f_rss_rate;
+            if(stats.f_read_bytes >= 0)
+            {
+                process["read_rate"] = stats.f_read_rate;
+                process["write_rate"] = stats.f_write_rate;
+            }
+        }
+        process["rss_slope"] = stats.f_rss_slope;
+
+        if(stats.f_leak)
+        {
+            append_error(
+                      json
+                    , plugin_name
+                    , "resident memory of process \""
+                        + process_name
+                        + "\" keeps growing ("
+                        + std::to_string(static_cast<std::int64_t>(stats.f_rss_slope * 3600.0))
+                        + " bytes per hour); it may be leaking memory."
+                    , 45);
+        }
+    }
+
     return true;
 }
 
@@ -1073,6 +1399,42 @@ void server::stop(bool quitting)
     f_communicator->remove_connection(f_interrupt);
     f_communicator->remove_connection(f_tick_timer);
     f_communicator->remove_connection(f_worker_done);
+    if(f_process_connector != nullptr)
+    {
+        f_communicator->remove_connection(f_process_connector);
+        f_process_connector.reset();
+    }
+
+    if(f_pidfd_watcher != nullptr)
+    {
+        f_communicator->remove_connection(f_pidfd_watcher);
+        f_pidfd_watcher.reset();
+    }
+
+    if(f_link_monitor != nullptr)
+    {
+        f_communicator->remove_connection(f_link_monitor);
+        f_link_monitor.reset();
+    }
+
+    if(f_kmsg_monitor != nullptr)
+    {
+        f_communicator->remove_connection(f_kmsg_monitor);
+        f_kmsg_monitor.reset();
+    }
+
+    // the watchdog plugin gets the pointer from the worker thread; it
+    // keeps its own copy so we only have to protect the pointer itself
+    //
+    service_watchdog::pointer_t w;
+    {
+        cppthread::guard lock(f_service_watchdog_mutex);
+        w.swap(f_service_watchdog);
+    }
+    if(w != nullptr)
+    {
+        f_communicator->remove_connection(w);
+    }
 }
 
 
@@ -1122,6 +1484,152 @@ std::string server::get_server_parameter(std::string const & name) const
 }
 
 
+/** \brief Get a server parameter as an integer.
+ *
+ * Many plugins accept numeric parameters (thresholds, timeouts, sizes)
+ * and fall back to a default when the parameter is not defined or is
+ * not valid. This function centralizes that conversion.
+ *
+ * \param[in] name  The name of the parameter.
+ * \param[in] default_value  The value returned if the parameter is not
+ * defined, is not a valid integer, or is smaller than \p minimum.
+ * \param[in] minimum  The smallest acceptable value.
+ *
+ * \return The parameter value or \p default_value.
+ */
+std::int64_t server::get_integer_parameter(
+      std::string const & name
+    , std::int64_t default_value
+    , std::int64_t minimum) const
+{
+    std::string const value(get_server_parameter(name));
+    std::int64_t result(0);
+    if(value.empty()
+    || !advgetopt::validator_integer::convert_string(value, result)
+    || result < minimum)
+    {
+        return default_value;
+    }
+    return result;
+}
+
+
+/** \brief Get the process connector.
+ *
+ * When the sitter is allowed to listen to the kernel process events,
+ * this function returns a pointer to the process connector. Plugins can
+ * use it to get the list of running processes without having to scan
+ * the entire /proc directory.
+ *
+ * \return The process connector or nullptr when not available.
+ */
+process_connector::pointer_t server::get_process_connector() const
+{
+    return f_process_connector;
+}
+
+
+/** \brief Get the network link monitor.
+ *
+ * The link monitor records the network interfaces going up and down as
+ * it happens. The network plugin retrieves those events on each tick.
+ *
+ * \return The link monitor or nullptr when not available.
+ */
+link_monitor::pointer_t server::get_link_monitor() const
+{
+    return f_link_monitor;
+}
+
+
+/** \brief Get the kernel log monitor.
+ *
+ * The kernel log monitor classifies the records of /dev/kmsg as they
+ * arrive. The kernel plugin retrieves the counters on each tick.
+ *
+ * \return The kernel log monitor or nullptr when not available.
+ */
+kmsg_monitor::pointer_t server::get_kmsg_monitor() const
+{
+    return f_kmsg_monitor;
+}
+
+
+/** \brief Get the service watchdog.
+ *
+ * The service watchdog sends ALIVE messages to the services and measures
+ * how long they take to reply. The watchdog plugin reports the services
+ * which stopped answering or became slow.
+ *
+ * \note
+ * This function is called from the worker thread. The pointer is reset
+ * by stop() so it is protected by a mutex and the caller gets its own
+ * copy which remains valid even if stop() runs meanwhile.
+ *
+ * \return The service watchdog or nullptr once the server was stopped.
+ */
+service_watchdog::pointer_t server::get_service_watchdog() const
+{
+    cppthread::guard lock(f_service_watchdog_mutex);
+    return f_service_watchdog;
+}
+
+
+/** \brief Search for a mandatory process.
+ *
+ * This function returns the information about the named process. The
+ * first time, the process is searched in the list of processes. Once
+ * found, a pidfd watch is added so the following calls do not have to
+ * search the list of processes again until the process exits.
+ *
+ * If the pidfd watcher is not available (i.e. kernel older than 5.3)
+ * then the list of processes is searched on each call.
+ *
+ * \param[in] name  The name of the process to search.
+ *
+ * \return The process information or nullptr if the process is not running.
+ */
+cppprocess::process_info::pointer_t server::find_process(std::string const & name)
+{
+    if(f_pidfd_watcher != nullptr)
+    {
+        pid_t const pid(f_pidfd_watcher->get_pid(name));
+        if(pid > 0)
+        {
+            return std::make_shared<cppprocess::process_info>(pid);
+        }
+    }
+
+    cppprocess::process_list list;
+    cppprocess::process_info::pointer_t info(list.find(name));
+    if(info != nullptr
+    && f_pidfd_watcher != nullptr)
+    {
+        f_pidfd_watcher->watch(name, info->get_pid());
+    }
+
+    return info;
+}
+
+
+/** \brief Get the statvfs() pool.
+ *
+ * The disk and dirsize plugins call statvfs() through this pool so a
+ * dead mount does not block the sitter. Sharing one pool means one set
+ * of helper threads and a mount which does not answer is probed by at
+ * most one helper whichever plugin asks.
+ *
+ * \note
+ * The pool must only be used from the worker thread.
+ *
+ * \return A reference to the statvfs() pool.
+ */
+statvfs_pool & server::get_statvfs_pool()
+{
+    return f_statvfs_pool;
+}
+
+
 /** \brief Get the path to a file in the sitter cache.
  *
  * This function returns a full path to the sitter cache plus
@@ -20,8 +20,16 @@
 // self
 //
 #include    <sitter/interrupt.h>
+#include    <sitter/kmsg_monitor.h>
+#include    <sitter/link_monitor.h>
 #include    <sitter/messenger.h>
+#include    <sitter/pidfd_watcher.h>
+#include    <sitter/process_history.h>
+#include    <sitter/process_snapshot.h>
+#include    <sitter/process_connector.h>
+#include    <sitter/service_watchdog.h>
 #include    <sitter/sitter_worker.h>
+#include    <sitter/statvfs_pool.h>
 #include    <sitter/tick_timer.h>
 
 
@@ -43,6 +51,7 @@
 
 // cppthreadd
 //
+#include    <cppthread/mutex.h>
 #include    <cppthread/thread.h>
 
 
@@ -88,6 +97,9 @@ public:
     static constexpr std::int64_t const     MAXIMUM_ERROR_REPORT_CRITICAL_PRIORITY = 100;
     static constexpr std::int64_t const     DEFAULT_ERROR_REPORT_CRITICAL_SPAN     = 86400;   // 1 day
     static constexpr std::int64_t const     MINIMUM_ERROR_REPORT_CRITICAL_SPAN     = 300;     // 5 minutes
+    static constexpr std::int64_t const     DEFAULT_TOP_PROCESSES                  = 5;
+    static constexpr std::int64_t const     MAXIMUM_TOP_PROCESSES                  = 100;
+    static constexpr std::int64_t const     MINIMUM_TICK_INTERVAL                  = 10;      // 10 seconds
 
                         server(int argc, char * argv[]);
 
@@ -106,6 +118,21 @@ public:
                         get_communicatord_disconnected_on() const;
     std::string         get_cache_path(std::string const & filename);
     std::string         get_server_parameter(std::string const & name) const;
+    std::int64_t        get_integer_parameter(
+                              std::string const & name
+                            , std::int64_t default_value
+                            , std::int64_t minimum = 0) const;
+    process_connector::pointer_t
+                        get_process_connector() const;
+    link_monitor::pointer_t
+                        get_link_monitor() const;
+    kmsg_monitor::pointer_t
+                        get_kmsg_monitor() const;
+    service_watchdog::pointer_t
+                        get_service_watchdog() const;
+    cppprocess::process_info::pointer_t
+                        find_process(std::string const & name);
+    statvfs_pool &      get_statvfs_pool();
 
     PLUGIN_SIGNAL_WITH_MODE(process_watch, (as2js::json::json_value_ref & json), (json), NEITHER);
 
@@ -116,7 +143,9 @@ public:
     // internal functions (these are NOT virtual)
     // 
     void                process_tick();
+    bool                force_tick();
 
+    void                msg_absolutely(ed::message & message);
     void                msg_rusage(ed::message & message);
 
     void                clear_cache(std::string const & name);
@@ -146,6 +175,12 @@ public:
     std::int64_t        get_error_report_medium_span();
     std::int64_t        get_error_report_critical_priority();
     std::int64_t        get_error_report_critical_span();
+    std::int64_t        get_top_processes();
+
+    void                refresh_process_snapshot();
+    std::string         output_top_processes(
+                              as2js::json::json_value_ref & json
+                            , resource_t resource);
 
     void                set_ticks(int ticks);
     int                 get_ticks() const;
@@ -163,6 +198,21 @@ private:
                         f_tick_timer = tick_timer::pointer_t();
     messenger::pointer_t
                         f_messenger = messenger::pointer_t();
+    process_connector::pointer_t
+                        f_process_connector = process_connector::pointer_t();
+    pidfd_watcher::pointer_t
+                        f_pidfd_watcher = pidfd_watcher::pointer_t();
+    link_monitor::pointer_t
+                        f_link_monitor = link_monitor::pointer_t();
+    kmsg_monitor::pointer_t
+                        f_kmsg_monitor = kmsg_monitor::pointer_t();
+    service_watchdog::pointer_t
+                        f_service_watchdog = service_watchdog::pointer_t();
+    mutable cppthread::mutex
+                        f_service_watchdog_mutex = cppthread::mutex();
+    process_history     f_process_history = process_history();
+    process_snapshot    f_process_snapshot = process_snapshot();
+    statvfs_pool        f_statvfs_pool = statvfs_pool();
 
     std::int64_t        f_statistics_frequency = -1;
     std::int64_t        f_statistics_period = -1;
@@ -174,6 +224,7 @@ private:
     std::int64_t        f_error_report_medium_span = -1;
     std::int64_t        f_error_report_critical_priority = -1;
     std::int64_t        f_error_report_critical_span = -1;
+    std::int64_t        f_top_processes = -1;
     int                 f_error_count = 0;
     int                 f_max_error_priority = 0;
     bool                f_stopping = false;
@@ -184,6 +235,9 @@ private:
                         f_communicatord_disconnected = 0.0;
     std::string         f_cache_path = std::string();
     int                 f_ticks = 0;
+    std::uint64_t       f_tick_count = 0;
+    cppthread::mutex    f_tick_mutex = cppthread::mutex();
+    std::int64_t        f_last_forced_tick = 0;
 
     worker_done::pointer_t
                         f_worker_done = worker_done::pointer_t();
@@ -214,6 +214,7 @@ void sitter_worker::run_plugins()
     root["start_date"] = start_date;
 
     f_server->clear_errors();
+    f_server->refresh_process_snapshot();
 
     // while running the plugins we want to have a severity of WARNING
     // because otherwise we get a ton of messages all the time
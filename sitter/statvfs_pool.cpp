@@ -0,0 +1,156 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// self
+//
+#include    "sitter/statvfs_pool.h"
+
+
+// C++
+//
+#include    <memory>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+
+/** \file
+ * \brief This file implements the statvfs() probes.
+ *
+ * The statvfs() function cannot be canceled. The previous implementation
+ * used SIGALRM to interrupt it, which changes a process wide handler
+ * and probes the mounts one after the other so a few slow mounts add
+ * seconds to every tick.
+ *
+ * The probes now run in a probe_pool with up to MAXIMUM_HELPERS probes
+ * running concurrently. Each probe has its own timeout. A mount which
+ * does not answer in time is marked unresponsive and does not get
+ * probed again until its statvfs() returns, so a stuck mount costs at
+ * most one helper.
+ */
+
+
+
+namespace sitter
+{
+
+
+
+
+/** \brief Initialize the pool.
+ *
+ * \param[in] helpers  The maximum number of statvfs() running
+ * concurrently.
+ */
+statvfs_pool::statvfs_pool(std::size_t helpers)
+    : f_pool("statvfs", helpers)
+{
+}
+
+
+/** \brief Probe a set of directories with statvfs().
+ *
+ * This function calls statvfs() on each one of the \p dirs and returns
+ * the results in the same order.
+ *
+ * A directory for which a previous probe is still pending is not probed
+ * again. Its status is set to PROBE_STATUS_UNRESPONSIVE.
+ *
+ * A directory which does not answer within \p timeout microseconds gets
+ * its status set to PROBE_STATUS_TIMED_OUT.
+ *
+ * \param[in] dirs  The list of directories to probe.
+ * \param[in] timeout  The maximum amount of time each probe can take in
+ * microseconds.
+ *
+ * \return The list of results.
+ */
+statvfs_result_vector_t statvfs_pool::probe(
+      std::vector<std::string> const & dirs
+    , std::int64_t timeout)
+{
+    // the callbacks own their result since an abandoned one may return
+    // after this function
+    //
+    std::vector<std::shared_ptr<statvfs_result_t>> probed;
+    probe_pool::probe_vector_t probes;
+    probed.reserve(dirs.size());
+    probes.reserve(dirs.size());
+    for(auto const & d : dirs)
+    {
+        std::shared_ptr<statvfs_result_t> r(std::make_shared<statvfs_result_t>());
+        r->f_dir = d;
+        probed.push_back(r);
+
+        probe_pool::probe_t p;
+        p.f_key = d;
+        p.f_callback = [r]() noexcept
+            {
+                struct statvfs s = {};
+                if(statvfs(r->f_dir.c_str(), &s) == 0)
+                {
+                    r->f_status = probe_status_t::PROBE_STATUS_SUCCESS;
+                    r->f_stat = s;
+                }
+                else
+                {
+                    r->f_errno = errno;
+                    r->f_status = probe_status_t::PROBE_STATUS_FAILED;
+                }
+            };
+        probes.push_back(p);
+    }
+
+    probe_pool::status_vector_t const status(f_pool.run(probes, timeout));
+
+    statvfs_result_vector_t result(dirs.size());
+    for(std::size_t idx(0); idx < dirs.size(); ++idx)
+    {
+        switch(status[idx])
+        {
+        case probe_status_t::PROBE_STATUS_SUCCESS:
+            result[idx] = *probed[idx];
+            break;
+
+        case probe_status_t::PROBE_STATUS_TIMED_OUT:
+            result[idx].f_dir = dirs[idx];
+            result[idx].f_status = probe_status_t::PROBE_STATUS_TIMED_OUT;
+            result[idx].f_errno = ETIMEDOUT;
+            break;
+
+        default:
+            result[idx].f_dir = dirs[idx];
+            result[idx].f_status = probe_status_t::PROBE_STATUS_UNRESPONSIVE;
+            break;
+
+        }
+    }
+
+    return result;
+}
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
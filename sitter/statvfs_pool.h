@@ -0,0 +1,82 @@
+// Copyright (c) 2011-2025  Made to Order Software Corp.  All Rights Reserved.
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    <sitter/probe_pool.h>
+
+
+// C++
+//
+#include    <string>
+#include    <vector>
+
+
+// C
+//
+#include    <sys/statvfs.h>
+
+
+
+/** \file
+ * \brief This file declares the statvfs() probes.
+ *
+ * The disk and dirsize plugins call statvfs() through this pool so a
+ * dead mount does not block the sitter. The server owns the one pool
+ * (see server::get_statvfs_pool()).
+ */
+
+
+
+
+namespace sitter
+{
+
+
+
+struct statvfs_result_t
+{
+    std::string                 f_dir = std::string();
+    probe_status_t              f_status = probe_status_t::PROBE_STATUS_FAILED;
+    int                         f_errno = 0;
+    struct statvfs              f_stat = {};
+};
+typedef std::vector<statvfs_result_t>   statvfs_result_vector_t;
+
+
+class statvfs_pool
+{
+public:
+    static constexpr std::size_t const  MAXIMUM_HELPERS = 8;
+    static constexpr std::int64_t const DEFAULT_TIMEOUT = 3'000'000;    // 3 seconds in microseconds
+
+                                statvfs_pool(std::size_t helpers = MAXIMUM_HELPERS);
+
+    statvfs_result_vector_t     probe(
+                                      std::vector<std::string> const & dirs
+                                    , std::int64_t timeout = DEFAULT_TIMEOUT);
+
+private:
+    probe_pool                  f_pool;
+};
+
+
+
+} // namespace sitter
+// vim: ts=4 sw=4 et
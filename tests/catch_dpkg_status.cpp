@@ -0,0 +1,106 @@
+// Copyright (c) 2013-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// sitter
+//
+#include    <plugins/sitter_packages/dpkg_status.h>
+
+
+// self
+//
+#include    "catch_main.h"
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+CATCH_TEST_CASE("dpkg_status_compare_versions", "[packages][version]")
+{
+    CATCH_START_SECTION("dpkg_status_compare_versions: equal versions")
+    {
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0", "1.0") == 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0-1", "1.0-1") == 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("0:1.0", "1.0") == 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.01", "1.1") == 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("", "") == 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("dpkg_status_compare_versions: numbers compare numerically")
+    {
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.2", "1.10") < 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.10", "1.2") > 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("2.0", "10.0") < 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0", "1.0.1") < 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("dpkg_status_compare_versions: letters sort before non-letters")
+    {
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0a", "1.0+") < 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0a", "1.0b") < 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0", "1.0a") < 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0+dfsg", "1.0.1") < 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("dpkg_status_compare_versions: tilde sorts before anything, even the end")
+    {
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0~rc1", "1.0") < 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0", "1.0~rc1") > 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0~~", "1.0~") < 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0~~a", "1.0~~") > 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0~rc1", "1.0~rc2") < 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0-1~bpo1", "1.0-1") < 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("dpkg_status_compare_versions: the epoch has precedence")
+    {
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1:0.9", "2.0") > 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("2.0", "1:0.9") < 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1:2.0", "2:1.0") < 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("10:1.0", "9:1.0") > 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("dpkg_status_compare_versions: the revision is compared last")
+    {
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0-2", "1.0-1") > 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0-1", "1.0-10") < 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.1-1", "1.0-9") > 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0", "1.0-0") == 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0-1ubuntu1", "1.0-1") > 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("dpkg_status_compare_versions: the last dash separates the revision")
+    {
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0-beta-2", "1.0-beta-1") > 0);
+        CATCH_REQUIRE(sitter::packages::dpkg_status::compare_versions("1.0-beta-1", "1.0-alpha-9") > 0);
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
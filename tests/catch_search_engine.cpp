@@ -0,0 +1,145 @@
+// Copyright (c) 2013-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/sitter
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// sitter
+//
+#include    <plugins/sitter_log/search_engine.h>
+
+
+// self
+//
+#include    "catch_main.h"
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+
+CATCH_TEST_CASE("search_engine_required_literal", "[log][search]")
+{
+    CATCH_START_SECTION("search_engine_required_literal: plain literals")
+    {
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("SEGV") == "SEGV");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("Out of memory") == "Out of memory");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("").empty());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("search_engine_required_literal: the longest sequence is returned")
+    {
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal(".*panic.*") == "panic");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("^kernel: .* oops$") == "kernel: ");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("ab.cdef") == "cdef");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("[abc]+xyz") == "xyz");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("search_engine_required_literal: optional characters and groups")
+    {
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("abc?d") == "ab");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("abcd*ef") == "abc");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("x{0,3}yz") == "yz");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("(foo)?bar") == "bar");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("(foobar)*baz") == "baz");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("(foo)bar") == "bar");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("(a|b)cde") == "cde");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("search_engine_required_literal: a repeated character is included once")
+    {
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("abc+") == "abc");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("abc{2}") == "abc");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("ab+cd") == "ab");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("search_engine_required_literal: escapes")
+    {
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("file\\.txt") == "file.txt");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("a\\.b\\*c\\(d") == "a.b*c(d");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("\\d+ errors") == " errors");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("^\\d+$").empty());
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("\\bword\\b") == "word");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("\\x41bc") == "bc");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("\\u0041bc") == "bc");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("(a)b\\1 again") == " again");
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("abc\\") == "abc");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("search_engine_required_literal: alternation")
+    {
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("foo|bar").empty());
+        CATCH_REQUIRE(sitter::log::search_engine::required_literal("a\\|b") == "a|b");
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("search_engine_required_literals", "[log][search]")
+{
+    CATCH_START_SECTION("search_engine_required_literals: no alternation")
+    {
+        CATCH_REQUIRE(sitter::log::search_engine::required_literals("SEGV") == sitter::log::string_list_t({"SEGV"}));
+        CATCH_REQUIRE(sitter::log::search_engine::required_literals("\\d+ errors") == sitter::log::string_list_t({" errors"}));
+        CATCH_REQUIRE(sitter::log::search_engine::required_literals("^\\d+$").empty());
+        CATCH_REQUIRE(sitter::log::search_engine::required_literals("").empty());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("search_engine_required_literals: one literal per alternative")
+    {
+        CATCH_REQUIRE(sitter::log::search_engine::required_literals("Out of memory|oom-killer")
+                                        == sitter::log::string_list_t({"Out of memory", "oom-killer"}));
+        CATCH_REQUIRE(sitter::log::search_engine::required_literals("a|b|c")
+                                        == sitter::log::string_list_t({"a", "b", "c"}));
+        CATCH_REQUIRE(sitter::log::search_engine::required_literals("^error: .*|fatal\\.$")
+                                        == sitter::log::string_list_t({"error: ", "fatal."}));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("search_engine_required_literals: an alternative without a literal")
+    {
+        CATCH_REQUIRE(sitter::log::search_engine::required_literals("foo|\\d+").empty());
+        CATCH_REQUIRE(sitter::log::search_engine::required_literals("foo|").empty());
+        CATCH_REQUIRE(sitter::log::search_engine::required_literals("|foo").empty());
+        CATCH_REQUIRE(sitter::log::search_engine::required_literals("foo|(bar)?").empty());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("search_engine_required_literals: nested and escaped bars do not split")
+    {
+        CATCH_REQUIRE(sitter::log::search_engine::required_literals("(a|b)cde")
+                                        == sitter::log::string_list_t({"cde"}));
+        CATCH_REQUIRE(sitter::log::search_engine::required_literals("[|]xy|z")
+                                        == sitter::log::string_list_t({"xy", "z"}));
+        CATCH_REQUIRE(sitter::log::search_engine::required_literals("a\\|b")
+                                        == sitter::log::string_list_t({"a|b"}));
+        CATCH_REQUIRE(sitter::log::search_engine::required_literals("(foo)?bar|baz")
+                                        == sitter::log::string_list_t({"bar", "baz"}));
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
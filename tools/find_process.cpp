@@ -20,15 +20,11 @@
 #include    <sitter/version.h>
 
 
-// cppprocess
-//
-#include    <cppprocess/process_list.h>
-
-
 // snapdev
 //
-#include    <snapdev/not_reached.h>
+#include    <snapdev/file_contents.h>
 #include    <snapdev/stringize.h>
+#include    <snapdev/trim_string.h>
 
 
 // advgetopt
@@ -39,9 +35,16 @@
 
 // C++
 //
+#include    <algorithm>
+#include    <iostream>
 #include    <regex>
 
 
+// C
+//
+#include    <dirent.h>
+
+
 // last include
 //
 #include    <snapdev/poison.h>
@@ -54,6 +57,13 @@ namespace
 
 advgetopt::option const g_command_line_options[] =
 {
+    advgetopt::define_option(
+          advgetopt::Name("batch")
+        , advgetopt::ShortName('b')
+        , advgetopt::Flags(advgetopt::command_flags<
+                advgetopt::GETOPT_FLAG_FLAG>())
+        , advgetopt::Help("search for all the <process name> at once (read the names from stdin if none are specified) and print one line per name: \"<name> present <pid>,...\" or \"<name> absent\"")
+    ),
     advgetopt::define_option(
           advgetopt::Name("script")
         , advgetopt::ShortName('s')
@@ -80,7 +90,7 @@ advgetopt::option const g_command_line_options[] =
                   advgetopt::GETOPT_FLAG_MULTIPLE
                 , advgetopt::GETOPT_FLAG_DEFAULT_OPTION
                 , advgetopt::GETOPT_FLAG_SHOW_USAGE_ON_ERROR>())
-        , advgetopt::Help("<process name>")
+        , advgetopt::Help("<process name> ...")
     ),
     advgetopt::end_options()
 };
@@ -106,6 +116,7 @@ advgetopt::options_environment const g_command_line_options_environment =
     .f_configuration_directories = nullptr,
     .f_environment_flags = advgetopt::GETOPT_ENVIRONMENT_FLAG_PROCESS_SYSTEM_PARAMETERS,
     .f_help_header = "Usage: %p [-<opt>] <process-name>\n"
+                     "       %p --batch [-<opt>] [<process-name> ...]\n"
                      "where -<opt> is one or more of:",
     .f_help_footer = "%c",
     .f_version = SITTER_VERSION_STRING,
@@ -120,125 +131,419 @@ advgetopt::options_environment const g_command_line_options_environment =
 
 
 
-}
-//namespace
+/** \brief The comm file holds at most 15 characters.
+ *
+ * The kernel truncates the name of the command saved in the comm file
+ * to 15 characters (TASK_COMM_LEN - 1). When the comm is that long, we
+ * have to read the command line to get the full name.
+ */
+constexpr std::string::size_type const  COMM_MAX_LENGTH = 15;
 
 
+struct query_t
+{
+    std::string                 f_name = std::string();
+    std::shared_ptr<std::regex> f_regex = std::shared_ptr<std::regex>();
+    std::vector<pid_t>          f_pids = std::vector<pid_t>();
+};
 
 
+std::string basename(std::string const & path)
+{
+    std::string::size_type const pos(path.rfind('/'));
+    if(pos == std::string::npos)
+    {
+        return path;
+    }
+    return path.substr(pos + 1);
+}
+
 
-int main(int argc, char * argv[])
+/** \brief Read the list of arguments of a process.
+ *
+ * \param[in] proc_path  The path to the process directory under /proc.
+ *
+ * \return The list of arguments, empty if the command line is not
+ * available (i.e. kernel thread or zombie).
+ */
+advgetopt::string_list_t read_cmdline(std::string const & proc_path)
 {
-    int exitval(1);
+    advgetopt::string_list_t args;
 
-    try
+    snapdev::file_contents cmdline(proc_path + "/cmdline");
+    if(cmdline.read_all())
     {
-        advgetopt::getopt opt(g_command_line_options_environment, argc, argv);
+        std::string const & contents(cmdline.contents());
+        std::string::size_type pos(0);
+        while(pos < contents.length())
+        {
+            std::string::size_type end(contents.find('\0', pos));
+            if(end == std::string::npos)
+            {
+                end = contents.length();
+            }
+            args.push_back(contents.substr(pos, end - pos));
+            pos = end + 1;
+        }
+    }
 
-        bool const verbose(opt.is_defined("verbose"));
-        bool const regex(opt.is_defined("regex"));
+    return args;
+}
 
-        std::string const script(opt.get_string("script"));
-        std::string const process_name(opt.get_string("--"));
 
-        std::unique_ptr<std::regex> script_regex;
-        std::unique_ptr<std::regex> process_name_regex;
-        if(regex)
+/** \brief Get the name of a process as used for matching.
+ *
+ * This function determines the name of the process defined in
+ * \p proc_path. Both, the single and the batch modes use this function
+ * so a name matches the same processes in both modes.
+ *
+ * Without the --script option, the name is read from the
+ * /proc/<pid>/comm file. When the comm is 15 characters, it was likely
+ * truncated, so the function reads the command line and uses the
+ * basename of the first argument if it starts the same way.
+ *
+ * When the --script option is used, the comm cannot be used: for a
+ * script started through its shebang, the comm is the name of the
+ * script, not the interpreter. Instead, the basename of the first
+ * argument of the command line has to be the script interpreter and the
+ * returned name is the basename of the first argument which is not an
+ * option (not 100% of the time, though, "sh -o blah command" won't work).
+ *
+ * \param[in] proc_path  The path to the process directory under /proc.
+ * \param[in] script  The name of the script interpreter or an empty string.
+ * \param[in] script_regex  The script as a regular expression or nullptr.
+ * \param[in] verbose  Whether to print out skipped scripts.
+ *
+ * \return The name of the process or an empty string if it cannot match.
+ */
+std::string get_process_name(
+      std::string const & proc_path
+    , std::string const & script
+    , std::regex const * script_regex
+    , bool verbose)
+{
+    if(!script.empty())
+    {
+        // (note that if no command line was used we cannot currently
+        // find a corresponding process)
+        //
+        advgetopt::string_list_t const args(read_cmdline(proc_path));
+        if(args.empty())
         {
-            if(!script.empty())
+            return std::string();
+        }
+        std::string const name(basename(args[0]));
+        if(script_regex != nullptr
+            ? !std::regex_match(name, *script_regex)
+            : name != script)
+        {
+            return std::string();
+        }
+
+        // the process is the script interpreter, the name we are
+        // looking for is the first argument which is not an option
+        //
+        std::string command;
+        for(std::size_t idx(1); idx < args.size(); ++idx)
+        {
+            if(!args[idx].empty()
+            && args[idx][0] != '-')
             {
-                script_regex.reset(new std::regex(script, std::regex::nosubs));
+                command = args[idx];
+                break;
             }
-            process_name_regex.reset(new std::regex(process_name, std::regex::nosubs));
-
+        }
+        if(command.empty())
+        {
             if(verbose)
             {
-                std::cout << "find_process: using regular expressions for testing." << std::endl;
+                std::cout << "find_process: skipping \"" << name << "\" as it does not seem to define a command." << std::endl;
             }
+            return std::string();
         }
-        std::smatch match;
+        if(verbose)
+        {
+            std::cout << "find_process: found \"" << name << "\", its command is \"" << command << "\"." << std::endl;
+        }
+        return basename(command);
+    }
 
-        cppprocess::process_list l;
-        for(auto const & p : l)
+    snapdev::file_contents comm(proc_path + "/comm");
+    if(!comm.read_all())
+    {
+        // process is gone
+        //
+        return std::string();
+    }
+    std::string name(snapdev::trim_string(comm.contents()));
+    if(name.length() >= COMM_MAX_LENGTH)
+    {
+        // the comm is likely truncated, get the full name from
+        // the first argument if it starts the same way
+        //
+        advgetopt::string_list_t const args(read_cmdline(proc_path));
+        if(!args.empty())
         {
-            // get the command name
-            //
-            // (note that if no command line was used we cannot currently
-            // find a corresponding process)
-            //
-            std::string name(p.second->get_basename());
-            if(name.empty())
+            std::string const full(basename(args[0]));
+            if(full.compare(0, name.length(), name) == 0)
             {
-                continue;
+                name = full;
             }
+        }
+    }
 
-            // if we have a script we need to find the actual command
-            // which is the first argument without a '-'
-            // (not 100% of the time, though, "sh -o blah command" won't work)
-            //
-            if(!script.empty())
+    return name;
+}
+
+
+/** \brief Search /proc for the processes matching the queries.
+ *
+ * This function reads the list of processes once and adds the PID of
+ * each process to the queries it matches.
+ *
+ * The names are compared as is, unless the query has a regular
+ * expression, in which case the name must match it.
+ *
+ * \param[in,out] queries  The queries to search for.
+ * \param[in] script  The name of the script interpreter or an empty string.
+ * \param[in] script_regex  The script as a regular expression or nullptr.
+ * \param[in] verbose  Whether to print out skipped scripts.
+ *
+ * \return true if /proc could be read, false otherwise.
+ */
+bool search_processes(
+      std::vector<query_t> & queries
+    , std::string const & script
+    , std::regex const * script_regex
+    , bool verbose)
+{
+    DIR * d(opendir("/proc"));
+    if(d == nullptr)
+    {
+        std::cerr << "find_process: could not open /proc.\n";
+        return false;
+    }
+    for(dirent const * ent(readdir(d)); ent != nullptr; ent = readdir(d))
+    {
+        if(ent->d_name[0] < '1'
+        || ent->d_name[0] > '9')
+        {
+            continue;
+        }
+        std::string const name(get_process_name(
+                  std::string("/proc/") + ent->d_name
+                , script
+                , script_regex
+                , verbose));
+        if(name.empty())
+        {
+            continue;
+        }
+
+        pid_t const pid(static_cast<pid_t>(std::stoi(ent->d_name)));
+        for(auto & q : queries)
+        {
+            if(q.f_regex != nullptr
+                ? std::regex_match(name, *q.f_regex)
+                : name == q.f_name)
             {
-                std::string command;
-                int const max(p.second->get_args_size());
-                for(int idx(1); idx < max; ++idx)
-                {
-                    std::string const a(p.second->get_arg(idx));
-                    if(a.length() > 0
-                    && a[0] != '-')
-                    {
-                        command = a;
-                        break;
-                    }
-                }
-                if(command.empty())
-                {
-                    // no command found, we can't match properly
-                    //
-                    if(verbose)
-                    {
-                        std::cout << "find_process: skipping \"" << name << "\" as it does not seem to define a command." << std::endl;
-                    }
-                    continue;
-                }
-                if(regex
-                    ? !std::regex_match(name, match, *script_regex)
-                    : name != script)
-                {
-                    continue;
-                }
-                if(verbose)
-                {
-                    std::cout << "find_process: found \"" << name << "\", its command is \"" << command << "\"." << std::endl;
-                }
-                std::string::size_type const pos(command.rfind('/'));
-                if(pos == std::string::npos)
-                {
-                    name = command;
-                }
-                else
-                {
-                    name = command.substr(pos + 1);
-                }
+                q.f_pids.push_back(pid);
             }
+        }
+    }
+    closedir(d);
+
+    return true;
+}
+
 
-            if(regex
-                ? std::regex_match(name, match, *process_name_regex)
-                : name == process_name)
+/** \brief Compile the regular expressions of the queries.
+ *
+ * When the --regex command line option is used, this function compiles
+ * the script and each name only once.
+ *
+ * \param[in] opt  The command line options.
+ * \param[in,out] queries  The queries to compile.
+ *
+ * \return The script regular expression or nullptr if not required.
+ */
+std::shared_ptr<std::regex> compile_queries(
+      advgetopt::getopt & opt
+    , std::vector<query_t> & queries)
+{
+    std::shared_ptr<std::regex> script_regex;
+    if(opt.is_defined("regex"))
+    {
+        std::string const script(opt.get_string("script"));
+        if(!script.empty())
+        {
+            script_regex = std::make_shared<std::regex>(script, std::regex::nosubs);
+        }
+        for(auto & q : queries)
+        {
+            q.f_regex = std::make_shared<std::regex>(q.f_name, std::regex::nosubs);
+        }
+    }
+    return script_regex;
+}
+
+
+/** \brief Search for many processes in one pass.
+ *
+ * This function reads the list of names from the command line or, if
+ * none were specified, from stdin (one name per line). Then it reads
+ * the list of processes once and checks each one against all the names.
+ *
+ * The output is one line per name in the same order as the input:
+ *
+ * \code
+ *     <name> present <pid>,<pid>,...
+ *     <name> absent
+ * \endcode
+ *
+ * \param[in] opt  The command line options.
+ *
+ * \return 0 if all the processes were found, 1 otherwise.
+ */
+int batch_mode(advgetopt::getopt & opt)
+{
+    std::vector<query_t> queries;
+    int const max(static_cast<int>(opt.size("--")));
+    for(int idx(0); idx < max; ++idx)
+    {
+        query_t q;
+        q.f_name = opt.get_string("--", idx);
+        queries.push_back(q);
+    }
+    if(queries.empty())
+    {
+        std::string line;
+        while(std::getline(std::cin, line))
+        {
+            line = snapdev::trim_string(line);
+            if(!line.empty()
+            && line[0] != '#')
             {
-                // found it!
-                //
-                if(verbose)
-                {
-                    std::cout << "find_process: success! Found \"" << name << "\"." << std::endl;
-                }
-                exitval = 0;
-                break;
+                query_t q;
+                q.f_name = line;
+                queries.push_back(q);
             }
         }
+    }
+    if(queries.empty())
+    {
+        std::cerr << "find_process: no process names specified.\n";
+        return 1;
+    }
+
+    std::shared_ptr<std::regex> script_regex(compile_queries(opt, queries));
+    if(!search_processes(
+              queries
+            , opt.get_string("script")
+            , script_regex.get()
+            , opt.is_defined("verbose")))
+    {
+        return 1;
+    }
+
+    int exitval(0);
+    for(auto & q : queries)
+    {
+        std::cout << q.f_name;
+        if(q.f_pids.empty())
+        {
+            std::cout << " absent\n";
+            exitval = 1;
+        }
+        else
+        {
+            std::sort(q.f_pids.begin(), q.f_pids.end());
+            char sep(' ');
+            std::cout << " present";
+            for(auto const pid : q.f_pids)
+            {
+                std::cout << sep << pid;
+                sep = ',';
+            }
+            std::cout << '\n';
+        }
+    }
+
+    return exitval;
+}
+
+
+/** \brief Search for one process.
+ *
+ * This function checks whether the process named on the command line
+ * is running. It prints nothing unless --verbose is used.
+ *
+ * \param[in] opt  The command line options.
+ *
+ * \return 0 if the process was found, 1 otherwise.
+ */
+int single_mode(advgetopt::getopt & opt)
+{
+    bool const verbose(opt.is_defined("verbose"));
+
+    std::vector<query_t> queries(1);
+    queries[0].f_name = opt.get_string("--");
+
+    std::shared_ptr<std::regex> script_regex(compile_queries(opt, queries));
+    if(verbose && queries[0].f_regex != nullptr)
+    {
+        std::cout << "find_process: using regular expressions for testing." << std::endl;
+    }
+
+    if(!search_processes(
+              queries
+            , opt.get_string("script")
+            , script_regex.get()
+            , verbose))
+    {
+        return 1;
+    }
+
+    if(queries[0].f_pids.empty())
+    {
+        if(verbose)
+        {
+            std::cout << "find_process: failure. Could not find \"" << queries[0].f_name << "\"." << std::endl;
+        }
+        return 1;
+    }
 
-        if(verbose && exitval != 0)
+    if(verbose)
+    {
+        std::cout << "find_process: success! Found \"" << queries[0].f_name << "\"." << std::endl;
+    }
+    return 0;
+}
+
+
+
+}
+//namespace
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+    int exitval(1);
+
+    try
+    {
+        advgetopt::getopt opt(g_command_line_options_environment, argc, argv);
+
+        if(opt.is_defined("batch"))
+        {
+            exitval = batch_mode(opt);
+        }
+        else
         {
-            std::cout << "find_process: failure. Could not find \"" << process_name << "\"." << std::endl;
+            exitval = single_mode(opt);
         }
     }
     catch(advgetopt::getopt_exit const & e)
@@ -265,11 +570,7 @@ int main(int argc, char * argv[])
             << "find_process: unknown exception caught!\n";
     }
 
-    // exit via the server so the server can clean itself up properly
-    //
-    exit(exitval);
-    snapdev::NOT_REACHED();
-    return 0;
+    return exitval;
 }
 
 // vim: ts=4 sw=4 et